@@ -6,11 +6,16 @@
 
 /* C++ STL HEADER FILES */
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
-#include <sstream>
+#include <string_view>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include <Eigen/Dense>
@@ -22,25 +27,158 @@
 
 namespace cpet {
 
-class AtomID {
+/* Fixed size form of a chain:residue:name id whose chain and name have at
+ * most four characters and whose residue is a plain integer, which covers
+ * every pdb id. Equality compares three words and the hash is computed once,
+ * when the id is packed. */
+class PackedAtomID {
  public:
-  enum class Constants { origin, e1, e2 };
+  static constexpr size_t FIELD_WIDTH = 4;
+
+  /* nullopt when id does not fit, or would not print back as id */
+  [[nodiscard]] static inline std::optional<PackedAtomID> pack(
+      const std::string_view id) noexcept {
+    const auto first = id.find(':');
+    const auto second = id.find(':', first + 1);
+    if (first == std::string_view::npos || second == std::string_view::npos ||
+        id.find(':', second + 1) != std::string_view::npos) {
+      return std::nullopt;
+    }
 
-  explicit inline AtomID(const Constants other_id)
-      : isConstant_(true), id_(decodeConstant_(other_id)) {
-    if (!validID()) {
-      throw cpet::value_error("Invalid atom id: " + id_);
+    PackedAtomID result;
+    const auto residue = id.substr(first + 1, second - first - 1);
+    if (!copyField_(id.substr(0, first), result.chain_) ||
+        !copyField_(id.substr(second + 1), result.name_) ||
+        !parseResidue_(residue, result.residue_)) {
+      return std::nullopt;
     }
+    result.hash_ = result.computeHash_();
+    return result;
+  }
+
+  [[nodiscard]] inline std::string_view chain() const noexcept {
+    return fieldView_(chain_);
   }
 
-  template <typename S1,
-            typename = std::enable_if_t<std::is_convertible_v<S1, std::string>>>
-  explicit inline AtomID(S1&& other_id) : id_(std::forward<S1>(other_id)) {
-    if (!validID()) {
-      throw cpet::value_error("Invalid atom ID: " + id_);
+  [[nodiscard]] constexpr int32_t residue() const noexcept { return residue_; }
+
+  [[nodiscard]] inline std::string_view name() const noexcept {
+    return fieldView_(name_);
+  }
+
+  [[nodiscard]] constexpr uint32_t hash() const noexcept { return hash_; }
+
+  /* Default constructed; no id packs to this as chains are never empty */
+  [[nodiscard]] constexpr bool empty() const noexcept {
+    return chain_[0] == '\0';
+  }
+
+  /* The chain:residue:name string, only needed for output */
+  [[nodiscard]] inline std::string str() const {
+    std::string result(chain());
+    result.push_back(':');
+    result += std::to_string(residue_);
+    result.push_back(':');
+    result += name();
+    return result;
+  }
+
+  /* The hash follows from the fields, so it only rules out a mismatch */
+  [[nodiscard]] inline bool operator==(const PackedAtomID& rhs) const noexcept {
+    return hash_ == rhs.hash_ && residue_ == rhs.residue_ &&
+           chain_ == rhs.chain_ && name_ == rhs.name_;
+  }
+
+  [[nodiscard]] inline bool operator!=(const PackedAtomID& rhs) const noexcept {
+    return !(*this == rhs);
+  }
+
+ private:
+  std::array<char, FIELD_WIDTH> chain_{};
+  int32_t residue_{0};
+  std::array<char, FIELD_WIDTH> name_{};
+  uint32_t hash_{0};
+
+  [[nodiscard]] static inline bool copyField_(
+      const std::string_view field,
+      std::array<char, FIELD_WIDTH>& packed) noexcept {
+    if (field.empty() || field.size() > FIELD_WIDTH ||
+        field.find('\0') != std::string_view::npos) {
+      return false;
+    }
+    std::copy(field.begin(), field.end(), packed.begin());
+    return true;
+  }
+
+  [[nodiscard]] static inline std::string_view fieldView_(
+      const std::array<char, FIELD_WIDTH>& field) noexcept {
+    const auto length = std::find(field.begin(), field.end(), '\0');
+    return {field.data(), static_cast<size_t>(length - field.begin())};
+  }
+
+  /* Only residues that print back unchanged, so 7 but not 07 or +7 */
+  [[nodiscard]] static inline bool parseResidue_(const std::string_view str,
+                                                 int32_t& residue) noexcept {
+    const auto* last = str.data() + str.size();
+    if (const auto [ptr, ec] = std::from_chars(str.data(), last, residue);
+        ec != std::errc() || ptr != last) {
+      return false;
+    }
+    std::array<char, 16> printed{};
+    const auto [end, ec] = std::to_chars(
+        printed.data(), printed.data() + printed.size(), residue);
+    return std::string_view(printed.data(),
+                            static_cast<size_t>(end - printed.data())) == str;
+  }
+
+  /* FNV-1a over the fields, finished with the murmur3 mixer so that the low
+   * bits alone make a good table index */
+  [[nodiscard]] inline uint32_t computeHash_() const noexcept {
+    uint32_t h = 2166136261U;
+    const auto mix = [&h](const uint8_t byte) {
+      h = (h ^ byte) * 16777619U;
+    };
+    std::for_each(chain_.begin(), chain_.end(),
+                  [&](const char c) { mix(static_cast<uint8_t>(c)); });
+    const auto residue = static_cast<uint32_t>(residue_);
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+      mix(static_cast<uint8_t>(residue >> shift));
     }
+    std::for_each(name_.begin(), name_.end(),
+                  [&](const char c) { mix(static_cast<uint8_t>(c)); });
+
+    h ^= h >> 16U;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13U;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16U;
+    return h;
+  }
+};
+static_assert(sizeof(PackedAtomID) == 16);
+
+/* A chain:residue:name atom id, or an x:y:z position. Ids that pack are
+ * held as their PackedAtomID alone and their text is only made when asked
+ * for; the rest, positions included, share an immutable copy of their
+ * string. */
+class AtomID {
+ public:
+  enum class Constants { origin, e1, e2 };
+
+  explicit inline AtomID(const Constants other_id) : isConstant_(true) {
+    assign_(decodeConstant_(other_id), "Invalid atom id: ");
   }
 
+  template <typename S1, typename = std::enable_if_t<
+                             std::is_convertible_v<S1, std::string_view>>>
+  explicit inline AtomID(S1&& other_id) {
+    assign_(std::string_view(other_id), "Invalid atom ID: ");
+  }
+
+  /* The id that packed, e.g. as a Topology stores it */
+  explicit inline AtomID(const PackedAtomID& packed) noexcept
+      : packed_(packed) {}
+
   inline AtomID(AtomID&&) noexcept = default;
   inline AtomID(const AtomID&) = default;
   inline ~AtomID() = default;
@@ -55,34 +193,45 @@ class AtomID {
   }
 
   inline AtomID& operator=(AtomID::Constants c) {
-    id_ = decodeConstant_(c);
-    if (!validID()) {
-      throw cpet::value_error("Invalid AtomID specification: " + id_);
-    }
+    assign_(decodeConstant_(c), "Invalid AtomID specification: ");
     isConstant_ = true;
     return *this;
   }
 
-  [[nodiscard]] inline bool validID() const noexcept { return validID(id_); }
+  [[nodiscard]] inline bool validID() const noexcept {
+    return unpacked_ ? validID(unpacked_->id) : !packed_.empty();
+  }
 
   [[nodiscard]] static inline bool validID(std::string_view atomid) noexcept {
-    auto splitID = util::split(atomid, ':');
-
-    return splitID.size() == 3 &&
-           (isVector(atomid) || util::isDouble(splitID[1]));
+    std::array<std::string_view, 4> tokens;
+    return util::tokenize(atomid, ':', tokens) == 3 &&
+           (positionOf_(tokens) || util::toDouble(tokens[1]));
   }
 
+  /* An id that packs only prints as a string that packs to the same */
   [[nodiscard]] inline bool operator==(
       const std::string_view rhs) const noexcept {
-    return (id_ == rhs);
+    if (unpacked_) {
+      return unpacked_->id == rhs;
+    }
+    const auto packed = PackedAtomID::pack(rhs);
+    return packed && *packed == packed_;
   }
 
   [[nodiscard]] inline bool operator==(Constants c) const noexcept {
-    return (id_ == decodeConstant_(c));
+    return (*this == decodeConstant_(c));
   }
 
+  /* Ids that pack are equal exactly when their packed forms are */
   [[nodiscard]] inline bool operator==(const AtomID& rhs) const noexcept {
-    return (id_ == rhs.id_);
+    if (hash() != rhs.hash() || packed_.empty() != rhs.packed_.empty()) {
+      return false;
+    }
+    if (!packed_.empty()) {
+      return packed_ == rhs.packed_;
+    }
+    return (unpacked_ && rhs.unpacked_) ? (unpacked_->id == rhs.unpacked_->id)
+                                        : (unpacked_ == rhs.unpacked_);
   }
 
   [[nodiscard]] inline bool operator!=(
@@ -94,31 +243,47 @@ class AtomID {
     return !(*this == c);
   }
 
-  [[nodiscard]] inline const std::string& ID() const noexcept { return id_; }
+  [[nodiscard]] inline bool operator!=(const AtomID& rhs) const noexcept {
+    return !(*this == rhs);
+  }
+
+  /* The text of the id, made on demand for ids that pack */
+  [[nodiscard]] inline std::string ID() const {
+    return unpacked_ ? unpacked_->id : packed_.str();
+  }
+
+  [[nodiscard]] inline std::optional<PackedAtomID> packed() const noexcept {
+    if (packed_.empty()) {
+      return std::nullopt;
+    }
+    return packed_;
+  }
+
+  /* Computed once per id, see PackedAtomID::hash */
+  [[nodiscard]] inline uint32_t hash() const noexcept {
+    return unpacked_ ? unpacked_->hash : packed_.hash();
+  }
 
   template <typename S1>
   inline void setID(S1&& newID) {
-    if (validID(std::forward<S1>(newID))) {
-      id_ = std::forward<S1>(newID);
-      position_.reset();
-    } else {
-      throw cpet::value_error("Invalid AtomID " + std::string(newID));
-    }
+    assign_(std::string_view(newID), "Invalid AtomID ");
   }
 
   [[nodiscard]] static inline AtomID generateID(const std::string_view line,
                                                 const constants::FileType ft) {
-    std::stringstream result_stream;
+    std::string_view chain;
+    std::string_view resnum;
+    std::string_view name;
     switch (ft) {
       case constants::FileType::pqr: {
-        const auto tokens = util::split(line, ' ');
-        if (tokens.size() <= constants::PQR_MIN_INDEX) {
+        std::array<std::string_view, constants::PQR_MIN_INDEX + 1> tokens;
+        if (util::tokenize(line, ' ', tokens) < tokens.size()) {
           throw cpet::value_error("pqr line too short: " +
                                   static_cast<std::string>(line));
         }
-        result_stream << tokens[constants::PQR_CHAIN_INDEX] << ':'
-                      << tokens[constants::PQR_RESNUM_INDEX] << ':'
-                      << tokens[constants::PQR_ATOMID_INDEX];
+        chain = tokens[constants::PQR_CHAIN_INDEX];
+        resnum = tokens[constants::PQR_RESNUM_INDEX];
+        name = tokens[constants::PQR_ATOMID_INDEX];
       } break;
       case constants::FileType::pdb:
       default:
@@ -126,61 +291,106 @@ class AtomID {
           throw cpet::value_error("pdb line too short: " +
                                   static_cast<std::string>(line));
         }
-        result_stream << line.substr(constants::PDB_CHAIN_START,
-                                     constants::PDB_CHAIN_WIDTH)
-                      << ':'
-                      << line.substr(constants::PDB_RESNUM_START,
-                                     constants::PDB_RESNUM_WIDTH)
-                      << ':'
-                      << line.substr(constants::PDB_ATOMID_START,
-                                     constants::PDB_ATOMID_WIDTH);
+        chain =
+            line.substr(constants::PDB_CHAIN_START, constants::PDB_CHAIN_WIDTH);
+        resnum = line.substr(constants::PDB_RESNUM_START,
+                             constants::PDB_RESNUM_WIDTH);
+        name = line.substr(constants::PDB_ATOMID_START,
+                           constants::PDB_ATOMID_WIDTH);
     };
 
-    auto result = result_stream.str();
-    result.erase(remove(begin(result), end(result), ' '), end(result));
-    return AtomID(result);
+    /* pdb ids fit in the small string buffer, so no allocation happens */
+    std::string result;
+    result.reserve(chain.size() + resnum.size() + name.size() + 2);
+    appendWithoutSpaces_(result, chain);
+    result.push_back(':');
+    appendWithoutSpaces_(result, resnum);
+    result.push_back(':');
+    appendWithoutSpaces_(result, name);
+    return AtomID(std::move(result));
   }
 
   [[nodiscard]] inline std::optional<Eigen::Vector3d> position()
       const noexcept {
-    if (!position_) {
-      auto splitID = util::split(id_, ':');
-
-      if (splitID.size() != 3) {
-        position_.reset();
-      } else {
-        if (isVector()) {
-          position_.emplace(std::stod(splitID[0]), std::stod(splitID[1]),
-                            std::stod(splitID[2]));
-        } else {
-          position_.reset();
-        }
-      }
-    }
-    return position_;
+    return unpacked_ ? unpacked_->position : std::nullopt;
   }
 
   [[nodiscard]] inline bool isConstant() const noexcept { return isConstant_; }
 
-  [[nodiscard]] inline bool isVector() const noexcept { return isVector(id_); }
+  [[nodiscard]] inline bool isVector() const noexcept {
+    return unpacked_ && unpacked_->position;
+  }
 
   [[nodiscard]] static inline bool isVector(std::string_view atomid) noexcept {
-    auto splitID = util::split(atomid, ':');
-    if (splitID.size() != 3) {
-      return false;
-    }
-
-    return std::all_of(
-        splitID.begin(), splitID.end(),
-        [](const std::string& str) { return util::isDouble(str); });
+    std::array<std::string_view, 4> tokens;
+    return util::tokenize(atomid, ':', tokens) == 3 &&
+           positionOf_(tokens).has_value();
   }
 
  private:
+  /* What an id that does not pack, or is a position, keeps. The hash is
+   * the packed one when there is a packed form. */
+  struct Unpacked {
+    std::string id;
+    std::optional<Eigen::Vector3d> position;
+    uint32_t hash;
+  };
+
+  /* Empty when the id does not pack */
+  PackedAtomID packed_;
+  std::shared_ptr<const Unpacked> unpacked_;
   bool isConstant_ = false;
-  std::string id_;
-  mutable std::optional<Eigen::Vector3d> position_;
 
-  [[nodiscard]] static inline std::string decodeConstant_(Constants c) {
+  /* Validates id and only then replaces the current id, so a failed
+   * assignment leaves the AtomID unchanged. Ids that pack and are not
+   * positions are stored without allocating. */
+  inline void assign_(const std::string_view id,
+                      const std::string_view error) {
+    std::array<std::string_view, 4> tokens;
+    std::optional<Eigen::Vector3d> position;
+    const bool valid = util::tokenize(id, ':', tokens) == 3 &&
+                       ((position = positionOf_(tokens)) ||
+                        util::toDouble(tokens[1]));
+    if (!valid) {
+      throw cpet::value_error(std::string(error) + std::string(id));
+    }
+
+    const auto packed = PackedAtomID::pack(id);
+    std::shared_ptr<const Unpacked> unpacked;
+    if (!packed || position) {
+      unpacked = std::make_shared<const Unpacked>(Unpacked{
+          std::string(id), position,
+          packed ? packed->hash()
+                 : static_cast<uint32_t>(std::hash<std::string_view>{}(id))});
+    }
+    packed_ = packed.value_or(PackedAtomID{});
+    unpacked_ = std::move(unpacked);
+  }
+
+  [[nodiscard]] static inline std::optional<Eigen::Vector3d> positionOf_(
+      const std::array<std::string_view, 4>& tokens) noexcept {
+    const auto x = util::toDouble(tokens[0]);
+    if (!x) {
+      return std::nullopt;
+    }
+    const auto y = util::toDouble(tokens[1]);
+    const auto z = util::toDouble(tokens[2]);
+    if (!y || !z) {
+      return std::nullopt;
+    }
+    return Eigen::Vector3d(*x, *y, *z);
+  }
+
+  static inline void appendWithoutSpaces_(std::string& str,
+                                          const std::string_view field) {
+    for (const auto c : field) {
+      if (c != ' ') {
+        str.push_back(c);
+      }
+    }
+  }
+
+  [[nodiscard]] static inline std::string_view decodeConstant_(Constants c) {
     switch (c) {
       case AtomID::Constants::origin:
         return "0:0:0";
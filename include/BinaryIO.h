@@ -0,0 +1,34 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+/* C++ STL HEADER FILES */
+#include <fstream>
+#include <string>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+
+namespace cpet::util {
+
+/* Raw, native-endian reads and writes of trivially copyable data */
+template <typename T>
+inline void writeBinary(std::ostream& outFile, const T* data,
+                        const size_t count) {
+  outFile.write(reinterpret_cast<const char*>(data),
+                static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+inline void readBinary(std::istream& inFile, T* data, const size_t count,
+                       const std::string& file) {
+  inFile.read(reinterpret_cast<char*>(data),
+              static_cast<std::streamsize>(sizeof(T) * count));
+  if (!inFile) {
+    throw cpet::io_error("Unexpected end of binary file " + file);
+  }
+}
+}  // namespace cpet::util
+#endif  // BINARYIO_H
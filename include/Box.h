@@ -20,19 +20,10 @@
 #include "Utilities.h"
 #include "Volume.h"
 namespace cpet {
-class Box : public Volume {
+class Box final : public Volume {
  public:
-  explicit inline Box(const std::array<double, 3>& sides) : sides_(sides) {
-    constexpr auto is_less_than_zero = [](const double side) -> bool {
-      return side < 0.0;
-    };
-    if (const auto& location =
-            std::find_if(sides_.begin(), sides_.end(), is_less_than_zero);
-        location != sides_.end()) {
-      SPDLOG_ERROR("Invalid value for box side length {}", *location);
-      throw cpet::value_error("Invalid value for box side length");
-    }
-  }
+  explicit inline Box(const std::array<double, 3>& sides)
+      : Box(sides, {0, 0, 0}) {}
 
   inline Box(const std::array<double, 3>& sides, const Eigen::Vector3d& center)
       : sides_(sides) {
@@ -46,18 +37,16 @@ class Box : public Volume {
       throw cpet::value_error("Invalid value for box side length");
     }
     center_ = center;
+    maxDim_ = *std::max_element(sides_.begin(), sides_.end());
+    diagonal_ = 2 * sqrt(std::inner_product(sides_.begin(), sides_.end(),
+                                            sides_.begin(), 0.0));
   }
 
   [[nodiscard]] inline const double& maxDim() const noexcept override {
-    return *std::max_element(sides_.begin(), sides_.end());
+    return maxDim_;
   }
 
-  [[nodiscard]] inline double diagonal() const noexcept {
-    const double diag =
-        std::inner_product(sides_.begin(), sides_.end(), sides_.begin(), 0.0);
-
-    return 2 * sqrt(diag);
-  }
+  [[nodiscard]] inline double diagonal() const noexcept { return diagonal_; }
 
   [[nodiscard]] inline bool isInside(
       const Eigen::Vector3d& position) const override {
@@ -105,32 +94,9 @@ class Box : public Volume {
     return "box";
   }
 
-  [[nodiscard]] inline std::vector<Eigen::Vector3d> partition(
-      const std::array<int, 3>& density) const noexcept override {
-    /* Prevents division by zero later */
-    constexpr auto is_zero = [](const int dens) -> bool { return dens == 0.0; };
-    if (std::any_of(density.begin(), density.end(), is_zero)) {
-      return {};
-    }
-
-    std::vector<Eigen::Vector3d> result;
-    result.reserve(
-        static_cast<size_t>(abs(density[0] * density[1] * density[2])));
-
-    double x = -1 * sides_[0];
-    while (x <= sides_[0]) {
-      double y = -1 * sides_[1];
-      while (y <= sides_[1]) {
-        double z = -1 * sides_[2];
-        while (z <= sides_[2]) {
-          result.emplace_back(x + center_[0], y + center_[1], z + center_[2]);
-          z += static_cast<double>(static_cast<float>(sides_[2] / density[2]));
-        }
-        y += (sides_[1] / density[1]);
-      }
-      x += (sides_[0] / density[0]);
-    }
-    return result;
+  [[nodiscard]] inline Grid grid(
+      const std::array<int, 3>& density) const override {
+    return boundingGrid_(sides_, density);
   }
 
  private:
@@ -144,6 +110,8 @@ class Box : public Volume {
   }
 
   std::array<double, 3> sides_;
+  double maxDim_;
+  double diagonal_;
 };
 }  // namespace cpet
 #endif  // BOX_H
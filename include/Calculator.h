@@ -5,6 +5,9 @@
 #define CALCULATOR_H
 
 /* C++ STL HEADER FILES */
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -13,6 +16,7 @@
 #include <Eigen/Dense>
 
 /* CPET HEADER FILES */
+#include "MemoryPlan.h"
 #include "Option.h"
 #include "PointCharge.h"
 #include "System.h"
@@ -24,7 +28,11 @@ namespace cpet {
 class Calculator {
  public:
   Calculator(std::string proteinFile, const std::string& optionFile,
-             std::string chargesFile = "", int nThreads = 1);
+             std::string chargesFile = "", int nThreads = 1,
+             bool stream = false, std::string topologyFile = "",
+             bool cache = false,
+             std::optional<uint64_t> maxMemory = std::nullopt,
+             bool singlePrecision = false);
 
   void compute();
 
@@ -33,6 +41,10 @@ class Calculator {
   Option option_;
   std::string chargeFile_;
   int numberOfThreads_;
+  bool stream_;
+  std::string topologyFile_;
+  bool cache_;
+  bool singlePrecision_;
   std::vector<Frame> frameTrajectory_;
   std::vector<System> systems_;
 
@@ -44,24 +56,33 @@ class Calculator {
 
   void computeVolume_() const;
 
-  inline void loadPointChargeTrajectory_() {
-    frameTrajectory_ =
-        Frame::loadFramesFromFile(proteinFile_, option_.coordinatesStartIndex(),
-                                  option_.coordinatesStepSize());
-  }
+  void computeStreaming_() const;
+
+  void loadPointChargeTrajectory_();
+
+  /* Adjusts streaming and threads so the run stays within maxMemory bytes */
+  void planMemory_(uint64_t maxMemory);
+
+  [[nodiscard]] memory::Workload workload_() const;
+
+  void forEachFrame_(const std::function<void(Frame)>& func) const;
+
+  [[nodiscard]] Frame loadTopology_() const;
 
   inline void createSystems_() {
     if (!systems_.empty()) {
       systems_.clear();
     }
 
-    const auto make_system = [this](const Frame& frame) -> System {
-      return System{frame, this->option_};
+    /* Systems take over the frames, coordinates are never held twice */
+    const auto make_system = [this](Frame& frame) -> System {
+      return System{std::move(frame), this->option_};
     };
 
     systems_.reserve(frameTrajectory_.size());
     std::transform(frameTrajectory_.begin(), frameTrajectory_.end(),
                    std::back_inserter(systems_), make_system);
+    frameTrajectory_.clear();
   }
 
   inline void transformSystems_() {
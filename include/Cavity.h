@@ -0,0 +1,149 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef CAVITY_H
+#define CAVITY_H
+
+/* C++ STL HEADER FILES */
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "AtomID.h"
+#include "Exceptions.h"
+#include "Topology.h"
+#include "Utilities.h"
+#include "Volume.h"
+namespace cpet {
+/* Union of spheres of the probe radius around selected atoms, residues
+ * (chain:resnum, every atom of it) or positions, e.g. a binding pocket.
+ * The union is voxelized once into voxels wholly inside a sphere, voxels
+ * on its surface and the rest. isInside is a bitmap lookup except on the
+ * surface, where only the spheres near the point are checked, so it costs
+ * about the same however many spheres there are.
+ *
+ * Atoms move between frames, so a cavity selecting them only has a shape
+ * once placedIn a frame; until then nothing is inside it. A cavity of
+ * positions alone is placed from the start. */
+class Cavity final : public Volume {
+ public:
+  /* Voxel edge as a fraction of the probe radius */
+  static constexpr double VOXELS_PER_RADIUS = 8.0;
+
+  Cavity(double radius, std::vector<std::string> selections);
+
+  [[nodiscard]] inline bool placed() const noexcept {
+    return atoms_.empty() && residues_.empty();
+  }
+
+  /* The cavity around the selected atoms of a frame with topology, where
+   * coordinate(i) is the position of atom i in the space sampled in */
+  template <typename Coordinate>
+  [[nodiscard]] Cavity placedIn(const Topology& topology,
+                                const Coordinate& coordinate) const {
+    auto centers = positions_;
+    for (const auto& atom : atoms_) {
+      const auto index = topology.indexOf(atom);
+      if (!index) {
+        throw cpet::value_not_found("Cavity atom not found: " + atom.ID());
+      }
+      centers.emplace_back(coordinate(*index));
+    }
+    for (const auto& residue : residues_) {
+      const auto before = centers.size();
+      for (size_t i = 0; i < topology.size(); ++i) {
+        if (util::startswith(topology.id(i).ID(), residue)) {
+          centers.emplace_back(coordinate(i));
+        }
+      }
+      if (centers.size() == before) {
+        throw cpet::value_not_found("Cavity residue not found: " +
+                                    residue.substr(0, residue.size() - 1));
+      }
+    }
+    return {radius_, std::move(centers), selections_};
+  }
+
+  [[nodiscard]] inline const double& maxDim() const noexcept override {
+    return maxDim_;
+  }
+
+  [[nodiscard]] inline double diagonal() const noexcept { return diagonal_; }
+
+  [[nodiscard]] inline bool isInside(
+      const Eigen::Vector3d& position) const override {
+    const Eigen::Vector3d scaled = (position - origin_) / voxel_;
+    size_t index = 0;
+    for (size_t i = 0; i < 3; ++i) {
+      const auto q = scaled[static_cast<long>(i)];
+      if (!(q >= 0.0) || q >= static_cast<double>(dimensions_[i])) {
+        return false;
+      }
+      index = index * dimensions_[i] + static_cast<size_t>(q);
+    }
+    return occupied_[index] && (interior_[index] || inSphere_(position));
+  }
+
+  /* Uniform over the voxels the union reaches into, drawn again while it
+   * falls outside every sphere */
+  [[nodiscard]] Eigen::Vector3d randomPoint() const noexcept override;
+
+  [[nodiscard]] std::string description() const noexcept override;
+
+  [[nodiscard]] int randomDistance(double stepSize) const noexcept override;
+
+  [[nodiscard]] inline std::string type() const noexcept override {
+    return "cavity";
+  }
+
+  /* Only defined for a placed cavity, since the grid of a plot3d is shared
+   * by every frame */
+  [[nodiscard]] Grid grid(const std::array<int, 3>& density) const override;
+
+  [[nodiscard]] inline size_t numberOfVoxels() const noexcept {
+    return voxels_.size();
+  }
+
+ private:
+  Cavity(double radius, std::vector<Eigen::Vector3d> centers,
+         std::vector<std::string> selections);
+
+  void voxelize_(const std::vector<Eigen::Vector3d>& centers);
+
+  /* Cell of the probe radius position is in, may be outside of cells_ */
+  [[nodiscard]] std::array<long, 3> cellOf_(
+      const Eigen::Vector3d& position) const noexcept;
+
+  /* Whether position is within the probe radius of a sphere center */
+  [[nodiscard]] bool inSphere_(const Eigen::Vector3d& position) const noexcept;
+
+  double radius_;
+  std::vector<std::string> selections_;
+  std::vector<Eigen::Vector3d> positions_;
+  std::vector<AtomID> atoms_;
+  /* chain:resnum: prefixes of the ids of the selected residues */
+  std::vector<std::string> residues_;
+
+  double voxel_;
+  Eigen::Vector3d origin_{0, 0, 0};
+  std::array<size_t, 3> dimensions_{0, 0, 0};
+  /* Voxels the union reaches into, and those of them inside one sphere */
+  std::vector<bool> occupied_;
+  std::vector<bool> interior_;
+  /* Indices of the occupied voxels, to sample from */
+  std::vector<uint32_t> voxels_;
+  /* Sphere centers ordered by cells of the probe radius; a point can only
+   * be in the spheres of the 27 cells around its own */
+  std::array<size_t, 3> cells_{0, 0, 0};
+  std::vector<uint32_t> cellStarts_;
+  std::vector<Eigen::Vector3d> cellCenters_;
+  double maxDim_{0};
+  double diagonal_{0};
+};
+}  // namespace cpet
+#endif  // CAVITY_H
@@ -0,0 +1,56 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+/* C++ STL HEADER FILES */
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cpet::cluster {
+
+enum class Method { kmedoids, average };
+
+struct Options {
+  Method method;
+  int numberOfClusters;
+};
+
+struct Result {
+  std::vector<size_t> medoids;
+  std::vector<size_t> labels;
+};
+
+[[nodiscard]] std::optional<Method> decodeMethod(const std::string& method);
+
+[[nodiscard]] std::string methodName(Method method) noexcept;
+
+/* Partitioning around medoids (BUILD + SWAP). Candidate swaps are evaluated
+ * in parallel using the FastPAM1 update so each iteration is O(N^2). */
+[[nodiscard]] Result kMedoids(const std::vector<std::vector<double>>& distances,
+                              size_t numberOfClusters, int numberOfThreads);
+
+/* Average-linkage (UPGMA) agglomerative clustering via the nearest-neighbor
+ * chain algorithm, with the dendrogram cut at numberOfClusters. The symmetric
+ * matrix is taken by value and used as scratch space, so move it in when it is
+ * no longer needed. Throws cpet::value_error if a distance is NaN. */
+[[nodiscard]] Result averageLinkage(std::vector<std::vector<double>> distances,
+                                    size_t numberOfClusters);
+
+/* distances is consumed by average linkage and only read by k-medoids */
+[[nodiscard]] inline Result clusterWith(
+    const Options& options, std::vector<std::vector<double>> distances,
+    int numberOfThreads) {
+  const auto numberOfClusters = static_cast<size_t>(options.numberOfClusters);
+  switch (options.method) {
+    case Method::average:
+      return averageLinkage(std::move(distances), numberOfClusters);
+    case Method::kmedoids:
+    default:
+      return kMedoids(distances, numberOfClusters, numberOfThreads);
+  }
+}
+}  // namespace cpet::cluster
+#endif  // CLUSTER_H
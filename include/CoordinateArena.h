@@ -0,0 +1,65 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef COORDINATEARENA_H
+#define COORDINATEARENA_H
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+namespace cpet {
+
+/* Coordinates of one frame. The pointer may alias a slab shared with other
+ * frames, which is freed together with the last of them. */
+using CoordinateStorage = std::shared_ptr<Eigen::Vector3d[]>;
+
+/* The same in single precision, see Frame::toSinglePrecision */
+using CompactStorage = std::shared_ptr<Eigen::Vector3f[]>;
+
+/* Storage of its own for coordinates, without copying them */
+template <typename T>
+[[nodiscard]] inline std::shared_ptr<T[]> ownedStorage(
+    std::vector<T> coordinates) {
+  auto owner = std::make_shared<std::vector<T>>(std::move(coordinates));
+  return {owner, owner->data()};
+}
+
+/* Bump allocator handing out the coordinates of many frames from a few large
+ * slabs. With the atom count known up front, a whole trajectory is a single
+ * allocation and a single free. The arena itself may be dropped at any time;
+ * slabs live on for as long as storage from them does. */
+template <typename T>
+class Arena {
+ public:
+  /* Number of coordinates allocated per slab, a larger request gets a slab
+   * of its own size */
+  explicit Arena(const size_t slabSize) noexcept : slabSize_(slabSize) {}
+
+  /* Uninitialized storage for n coordinates */
+  [[nodiscard]] inline std::shared_ptr<T[]> allocate(const size_t n) {
+    if (capacity_ - used_ < n) {
+      capacity_ = std::max(slabSize_, n);
+      slab_ = std::shared_ptr<T[]>(new T[capacity_]);
+      used_ = 0;
+    }
+    std::shared_ptr<T[]> block(slab_, slab_.get() + used_);
+    used_ += n;
+    return block;
+  }
+
+ private:
+  size_t slabSize_;
+  std::shared_ptr<T[]> slab_;
+  size_t capacity_{0};
+  size_t used_{0};
+};
+
+using CoordinateArena = Arena<Eigen::Vector3d>;
+using CompactArena = Arena<Eigen::Vector3f>;
+}  // namespace cpet
+#endif  // COORDINATEARENA_H
@@ -0,0 +1,93 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef CYLINDER_H
+#define CYLINDER_H
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "Utilities.h"
+#include "Volume.h"
+namespace cpet {
+/* Circular cylinder along the z axis, extending halfLength to either side
+ * of its center */
+class Cylinder final : public Volume {
+ public:
+  inline Cylinder(const double radius, const double halfLength,
+                  const Eigen::Vector3d& center = {0, 0, 0})
+      : radius_(radius),
+        halfLength_(halfLength),
+        radiusSquared_(radius * radius),
+        maxDim_(std::max(radius, halfLength)),
+        diagonal_(2 * std::sqrt(radius * radius + halfLength * halfLength)) {
+    if (!(radius_ > 0.0) || !(halfLength_ > 0.0)) {
+      SPDLOG_ERROR("Invalid value for cylinder radius {} or half length {}",
+                   radius_, halfLength_);
+      throw cpet::value_error("Invalid value for cylinder dimensions");
+    }
+    center_ = center;
+  }
+
+  [[nodiscard]] inline const double& maxDim() const noexcept override {
+    return maxDim_;
+  }
+
+  [[nodiscard]] inline double diagonal() const noexcept { return diagonal_; }
+
+  [[nodiscard]] inline bool isInside(
+      const Eigen::Vector3d& position) const override {
+    const Eigen::Vector3d displaced = position - center_;
+    return std::abs(displaced[2]) < halfLength_ &&
+           displaced.head<2>().squaredNorm() < radiusSquared_;
+  }
+
+  /* The square root of a uniform radius keeps the disk uniform */
+  [[nodiscard]] inline Eigen::Vector3d randomPoint() const noexcept override {
+    auto& generator = *util::randomNumberGenerator();
+    std::uniform_real_distribution<double> uniform;
+    const double r = radius_ * std::sqrt(uniform(generator));
+    const double theta = 2 * M_PI * uniform(generator);
+    const double z = halfLength_ * (2 * uniform(generator) - 1);
+    return Eigen::Vector3d{r * std::cos(theta), r * std::sin(theta), z} +
+           center_;
+  }
+
+  [[nodiscard]] inline std::string description() const noexcept override {
+    return "Cylinder: " + std::to_string(radius_) + ' ' +
+           std::to_string(halfLength_);
+  }
+
+  [[nodiscard]] inline int randomDistance(
+      double stepSize) const noexcept override {
+    return randomSteps_(diagonal_, stepSize);
+  }
+
+  [[nodiscard]] inline std::string type() const noexcept override {
+    return "cylinder";
+  }
+
+  [[nodiscard]] inline Grid grid(
+      const std::array<int, 3>& density) const override {
+    return boundingGrid_({radius_, radius_, halfLength_}, density)
+        .filter([this](const Eigen::Vector3d& p) { return isInside(p); });
+  }
+
+ private:
+  double radius_;
+  double halfLength_;
+  double radiusSquared_;
+  double maxDim_;
+  double diagonal_;
+};
+}  // namespace cpet
+#endif  // CYLINDER_H
@@ -6,6 +6,7 @@
 
 /* C++ STL HEADER FILES */
 #include <array>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
@@ -18,6 +19,8 @@
 #include <Eigen/Dense>
 
 /* CPET HEADER FILES */
+#include "NumpyIO.h"
+#include "Octree.h"
 #include "Volume.h"
 
 namespace cpet {
@@ -28,12 +31,15 @@ class EFieldVolume {
  public:
   EFieldVolume(std::unique_ptr<Volume> vol, std::array<int, 3> density,
                bool plot = false,
-               std::optional<std::string> output = std::nullopt) noexcept
+               std::optional<std::string> output = std::nullopt,
+               std::optional<octree::Refinement> refinement =
+                   std::nullopt) noexcept
       : volume_(std::move(vol)),
         sampleDensity_(density),
         showPlot_(plot),
-        output_(std::move(output)) {
-    points_ = volume_->partition(sampleDensity_);
+        output_(std::move(output)),
+        refinement_(refinement) {
+    grid_ = volume_->grid(sampleDensity_);
   }
 
   [[nodiscard]] inline std::string name() const {
@@ -52,10 +58,15 @@ class EFieldVolume {
   }
 
   [[nodiscard]] inline std::string details() const noexcept {
-    return ("Sample Density: " + std::to_string(sampleDensity_[0]) + ' ' +
-            std::to_string(sampleDensity_[1]) + ' ' +
-            std::to_string(sampleDensity_[2]) +
-            "; Volume: " + volume_->description());
+    auto result = "Sample Density: " + std::to_string(sampleDensity_[0]) +
+                  ' ' + std::to_string(sampleDensity_[1]) + ' ' +
+                  std::to_string(sampleDensity_[2]) +
+                  "; Volume: " + volume_->description();
+    if (refinement_) {
+      result += "; Adaptive: " + std::to_string(refinement_->maxDepth) + ' ' +
+                std::to_string(refinement_->tolerance);
+    }
+    return result;
   }
 
   [[nodiscard]] inline const Volume& volume() const noexcept {
@@ -67,9 +78,13 @@ class EFieldVolume {
     return sampleDensity_;
   }
 
-  [[nodiscard]] constexpr const std::vector<Eigen::Vector3d>& points()
-      const noexcept {
-    return points_;
+  /* Points at which the field is computed, generated on demand. Adaptive
+   * volumes refine it per frame where the field varies. */
+  [[nodiscard]] constexpr const Grid& grid() const noexcept { return grid_; }
+
+  [[nodiscard]] constexpr const std::optional<octree::Refinement>&
+  refinement() const noexcept {
+    return refinement_;
   }
 
   [[nodiscard]] constexpr bool showPlot() const noexcept { return showPlot_; }
@@ -92,20 +107,52 @@ class EFieldVolume {
   [[nodiscard]] static EFieldVolume fromBlock(
       const std::vector<std::string>& options);
 
-  void computeVolumeWith(const std::vector<System>& systems) const;
+  /* Incremental form of computeVolumeWith. The field of each system is
+   * computed block by block as it is written, so only a few blocks of the
+   * grid are held in memory (all of it when plotting or refining). Refined
+   * points differ between frames, so an .npz output then holds points_<i>
+   * for each frame rather than one points array. */
+  class Stream {
+   public:
+    explicit Stream(const EFieldVolume& volume, int numberOfThreads = 1);
+
+    void add(const System& system);
+
+    /* Completes an .npz output, text output needs no finishing */
+    void finish();
+
+   private:
+    const EFieldVolume& volume_;
+    std::ofstream outFile_;
+    std::optional<util::NpzWriter> npz_;
+    int numberOfThreads_;
+    size_t index_{0};
+  };
+
+  void computeVolumeWith(const std::vector<System>& systems,
+                         int numberOfThreads = 1) const;
 
  private:
   std::unique_ptr<Volume> volume_;
   std::array<int, 3> sampleDensity_;
-  std::vector<Eigen::Vector3d> points_;
+  Grid grid_;
   bool showPlot_{false};
   std::optional<std::string> output_{std::nullopt};
+  std::optional<octree::Refinement> refinement_{std::nullopt};
+
+  void plot_(const std::vector<Eigen::Vector3d>& points,
+             const std::vector<Eigen::Vector3d>& electricField) const;
 
-  void plot_(const std::vector<Eigen::Vector3d>& electricField) const;
+  /* point(i) is the i-th of size points and field(i) the field there */
+  template <typename Point, typename Field>
+  void writeFrame_(util::NpzWriter& npz, size_t index, const System& system,
+                   size_t size, const Point& point, const Field& field,
+                   int numberOfThreads) const;
 
-  void writeOutput_(
-      const std::vector<System>& systems,
-      const std::vector<std::vector<Eigen::Vector3d>>& results) const;
+  template <typename Point, typename Field>
+  void writeFrame_(std::ostream& outFile, size_t index, const System& system,
+                   size_t size, const Point& point, const Field& field,
+                   int numberOfThreads) const;
 };
 }  // namespace cpet
 #endif  // EFIELDVOLUME_H
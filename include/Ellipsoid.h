@@ -0,0 +1,92 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef ELLIPSOID_H
+#define ELLIPSOID_H
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <string>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "Volume.h"
+namespace cpet {
+/* Ellipsoid with its semi-axes along x, y and z */
+class Ellipsoid final : public Volume {
+ public:
+  explicit inline Ellipsoid(const std::array<double, 3>& semiAxes,
+                            const Eigen::Vector3d& center = {0, 0, 0})
+      : semiAxes_(semiAxes) {
+    constexpr auto is_not_positive = [](const double axis) -> bool {
+      return !(axis > 0.0);
+    };
+    if (const auto& location = std::find_if(
+            semiAxes_.begin(), semiAxes_.end(), is_not_positive);
+        location != semiAxes_.end()) {
+      SPDLOG_ERROR("Invalid value for ellipsoid semi-axis {}", *location);
+      throw cpet::value_error("Invalid value for ellipsoid semi-axis");
+    }
+    center_ = center;
+    scale_ = {semiAxes_[0], semiAxes_[1], semiAxes_[2]};
+    inverseScale_ = scale_.cwiseInverse();
+    maxDim_ = *std::max_element(semiAxes_.begin(), semiAxes_.end());
+  }
+
+  [[nodiscard]] inline const double& maxDim() const noexcept override {
+    return maxDim_;
+  }
+
+  /* The longest chord is the major axis */
+  [[nodiscard]] inline double diagonal() const noexcept { return 2 * maxDim_; }
+
+  [[nodiscard]] inline bool isInside(
+      const Eigen::Vector3d& position) const override {
+    return (position - center_).cwiseProduct(inverseScale_).squaredNorm() <
+           1.0;
+  }
+
+  /* Stretching the unit ball keeps it uniform, the map being linear */
+  [[nodiscard]] inline Eigen::Vector3d randomPoint() const noexcept override {
+    return randomUnitBallPoint_().cwiseProduct(scale_) + center_;
+  }
+
+  [[nodiscard]] inline std::string description() const noexcept override {
+    constexpr auto append_string = [](const std::string& sum,
+                                      const double dim) {
+      return sum + ' ' + std::to_string(dim);
+    };
+
+    return std::accumulate(semiAxes_.begin(), semiAxes_.end(),
+                           std::string("Ellipsoid:"), append_string);
+  }
+
+  [[nodiscard]] inline int randomDistance(
+      double stepSize) const noexcept override {
+    return randomSteps_(diagonal(), stepSize);
+  }
+
+  [[nodiscard]] inline std::string type() const noexcept override {
+    return "ellipsoid";
+  }
+
+  [[nodiscard]] inline Grid grid(
+      const std::array<int, 3>& density) const override {
+    return boundingGrid_(semiAxes_, density)
+        .filter([this](const Eigen::Vector3d& p) { return isInside(p); });
+  }
+
+ private:
+  std::array<double, 3> semiAxes_;
+  Eigen::Vector3d scale_;
+  Eigen::Vector3d inverseScale_;
+  double maxDim_;
+};
+}  // namespace cpet
+#endif  // ELLIPSOID_H
@@ -5,17 +5,22 @@
 #define FIELDLOCATIONS_H
 
 /* C++ STL HEADER FILES */
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <optional>
 #include <utility>
 
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
 /* CPET HEADER FILES */
 #include "AtomID.h"
 #include "Exceptions.h"
 #include "Utilities.h"
 #include "PointCharge.h"
+#include "Topology.h"
 
 namespace cpet {
 
@@ -50,7 +55,31 @@ constexpr PlotStyles& operator|=(PlotStyles& lhs, const PlotStyles rhs) {
 
 class FieldLocations {
  public:
-  void computeEFieldsWith(const std::vector<System>& systems) const;
+  /* Incremental form of computeEFieldsWith; only the fields at each location
+   * are retained per system, outputs are written by finish() */
+  class Stream {
+   public:
+    explicit Stream(const FieldLocations& fieldLocations,
+                    int numberOfThreads = 1);
+
+    void add(const System& system);
+
+    void finish() const;
+
+   private:
+    const FieldLocations& fieldLocations_;
+    int numberOfThreads_;
+    std::vector<std::vector<Eigen::Vector3d>> results_;
+    /* Atom index of each location in topology_; frames of a trajectory
+     * share their topology, so ids are only looked up when it changes */
+    std::shared_ptr<const Topology> topology_;
+    std::vector<size_t> indices_;
+
+    void resolveIndices_(const std::shared_ptr<const Topology>& topology);
+  };
+
+  void computeEFieldsWith(const std::vector<System>& systems,
+                          int numberOfThreads = 1) const;
 
   [[nodiscard]] constexpr const std::vector<AtomID>& locations()
       const noexcept {
@@ -126,8 +155,8 @@ class FieldLocations {
     return ((plotStyle_ & PlotStyles::m) == PlotStyles::m);
   }
 
-  void writeOutput_(
-      const std::vector<std::vector<Eigen::Vector3d>>& results) const;
+  void writeOutput_(const std::vector<std::vector<Eigen::Vector3d>>& results,
+                    int numberOfThreads) const;
 
   void plot_(const std::vector<std::vector<Eigen::Vector3d>>& results) const;
 };
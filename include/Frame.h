@@ -5,147 +5,392 @@
 #define FRAME_H
 
 /* C++ STL HEADER FILES */
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <algorithm>
-#include <utility>
+#include <functional>
+#include <iterator>
+#include <memory>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include <spdlog/spdlog.h>
 
 /* CPET HEADER FILES */
+#include "CoordinateArena.h"
 #include "PointCharge.h"
+#include "Span.h"
+#include "Topology.h"
 #include "Utilities.h"
 #include "Constants.h"
 
 namespace cpet {
 class Frame {
  public:
-  using const_iterator = std::vector<PointCharge>::const_iterator;
-  using iterator = std::vector<PointCharge>::iterator;
-  using const_reverse_iterator =
-      std::vector<PointCharge>::const_reverse_iterator;
-  using reverse_iterator = std::vector<PointCharge>::reverse_iterator;
+  /* Random access over the point charges of the frame. Dereferencing yields
+   * a PointChargeRef into the frame and its topology, nothing is copied. */
+  class const_iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = PointCharge;
+    using difference_type = std::ptrdiff_t;
+    using reference = PointChargeRef;
+
+    struct pointer {
+      PointChargeRef ref;
+      [[nodiscard]] inline const PointChargeRef* operator->() const noexcept {
+        return &ref;
+      }
+    };
+
+    const_iterator() = default;
+
+    inline const_iterator(const Frame* frame, const size_t index) noexcept
+        : frame_(frame), index_(static_cast<difference_type>(index)) {}
+
+    [[nodiscard]] inline reference operator*() const noexcept {
+      return (*frame_)[static_cast<size_t>(index_)];
+    }
+
+    [[nodiscard]] inline pointer operator->() const noexcept {
+      return {**this};
+    }
+
+    [[nodiscard]] inline reference operator[](
+        const difference_type n) const noexcept {
+      return *(*this + n);
+    }
+
+    inline const_iterator& operator++() noexcept {
+      ++index_;
+      return *this;
+    }
+
+    inline const_iterator operator++(int) noexcept {
+      auto result = *this;
+      ++index_;
+      return result;
+    }
+
+    inline const_iterator& operator--() noexcept {
+      --index_;
+      return *this;
+    }
+
+    inline const_iterator operator--(int) noexcept {
+      auto result = *this;
+      --index_;
+      return result;
+    }
+
+    inline const_iterator& operator+=(const difference_type n) noexcept {
+      index_ += n;
+      return *this;
+    }
+
+    inline const_iterator& operator-=(const difference_type n) noexcept {
+      index_ -= n;
+      return *this;
+    }
 
-  explicit Frame(std::vector<PointCharge> pcs)
-      : pointCharges_(std::move(pcs)) {}
+    [[nodiscard]] inline friend const_iterator operator+(
+        const_iterator iter, const difference_type n) noexcept {
+      return iter += n;
+    }
+
+    [[nodiscard]] inline friend const_iterator operator+(
+        const difference_type n, const_iterator iter) noexcept {
+      return iter += n;
+    }
+
+    [[nodiscard]] inline friend const_iterator operator-(
+        const_iterator iter, const difference_type n) noexcept {
+      return iter -= n;
+    }
+
+    [[nodiscard]] inline friend difference_type operator-(
+        const const_iterator& lhs, const const_iterator& rhs) noexcept {
+      return lhs.index_ - rhs.index_;
+    }
+
+    [[nodiscard]] inline bool operator==(
+        const const_iterator& rhs) const noexcept {
+      return index_ == rhs.index_;
+    }
+
+    [[nodiscard]] inline bool operator!=(
+        const const_iterator& rhs) const noexcept {
+      return index_ != rhs.index_;
+    }
 
-  [[nodiscard]] inline std::vector<PointCharge>::const_iterator find(
-      const AtomID& id) const {
-    return util::find_if_ex(pointCharges_.begin(), pointCharges_.end(),
-                            [&id](const auto& pc) { return pc.id == id; });
+    [[nodiscard]] inline bool operator<(
+        const const_iterator& rhs) const noexcept {
+      return index_ < rhs.index_;
+    }
+
+    [[nodiscard]] inline bool operator>(
+        const const_iterator& rhs) const noexcept {
+      return index_ > rhs.index_;
+    }
+
+    [[nodiscard]] inline bool operator<=(
+        const const_iterator& rhs) const noexcept {
+      return index_ <= rhs.index_;
+    }
+
+    [[nodiscard]] inline bool operator>=(
+        const const_iterator& rhs) const noexcept {
+      return index_ >= rhs.index_;
+    }
+
+   private:
+    const Frame* frame_{nullptr};
+    difference_type index_{0};
+  };
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  inline Frame(std::shared_ptr<const Topology> topology,
+               std::vector<Eigen::Vector3d> coordinates) {
+    if (topology->size() != coordinates.size()) {
+      throw cpet::value_error(
+          "Frame needs one coordinate per atom of its topology");
+    }
+    coordinates_ = {coordinates.data(), coordinates.size()};
+    storage_ = ownedStorage(std::move(coordinates));
+    topology_ = std::move(topology);
   }
 
-  [[nodiscard]] inline const_iterator begin() const noexcept {
-    return pointCharges_.begin();
+  /* A view of one coordinate per atom of topology in storage, typically a
+   * block of a CoordinateArena */
+  inline Frame(std::shared_ptr<const Topology> topology,
+               CoordinateStorage storage) noexcept
+      : topology_(std::move(topology)),
+        storage_(std::move(storage)),
+        coordinates_(storage_.get(), topology_->size()) {}
+
+  /* Copies own their coordinates, so that they may be changed without
+   * affecting the frames sharing a slab with the original */
+  inline Frame(const Frame& rhs) : topology_(rhs.topology_) {
+    if (rhs.singlePrecision()) {
+      compactStorage_ = ownedStorage(std::vector<Eigen::Vector3f>(
+          rhs.compact_.begin(), rhs.compact_.end()));
+      compact_ = {compactStorage_.get(), rhs.compact_.size()};
+    } else {
+      storage_ = ownedStorage(std::vector<Eigen::Vector3d>(
+          rhs.coordinates_.begin(), rhs.coordinates_.end()));
+      coordinates_ = {storage_.get(), rhs.coordinates_.size()};
+    }
   }
 
-  [[nodiscard]] inline const_iterator end() const noexcept {
-    return pointCharges_.end();
+  inline Frame(Frame&& rhs) noexcept
+      : topology_(std::move(rhs.topology_)),
+        storage_(std::move(rhs.storage_)),
+        coordinates_(std::exchange(rhs.coordinates_, {})),
+        compactStorage_(std::move(rhs.compactStorage_)),
+        compact_(std::exchange(rhs.compact_, {})) {}
+
+  inline Frame& operator=(const Frame& rhs) {
+    if (this != &rhs) {
+      *this = Frame(rhs);
+    }
+    return *this;
+  }
+
+  inline Frame& operator=(Frame&& rhs) noexcept {
+    topology_ = std::move(rhs.topology_);
+    storage_ = std::move(rhs.storage_);
+    coordinates_ = std::exchange(rhs.coordinates_, {});
+    compactStorage_ = std::move(rhs.compactStorage_);
+    compact_ = std::exchange(rhs.compact_, {});
+    return *this;
+  }
+
+  ~Frame() = default;
+
+  /* A frame with a topology of its own */
+  explicit Frame(const std::vector<PointCharge>& pcs)
+      : Frame(fromPointCharges_(pcs)) {}
+
+  [[nodiscard]] inline const_iterator find(const AtomID& id) const {
+    if (const auto index = topology_->indexOf(id)) {
+      return {this, *index};
+    }
+    throw cpet::value_not_found("Could not find element in container");
   }
 
-  [[nodiscard]] inline iterator begin() noexcept {
-    return pointCharges_.begin();
+  [[nodiscard]] inline PointChargeRef operator[](
+      const size_t i) const noexcept {
+    return {coordinate(i), topology_->charge(i), topology_->id(i)};
   }
 
-  [[nodiscard]] inline iterator end() noexcept { return pointCharges_.end(); }
+  [[nodiscard]] inline size_t size() const noexcept {
+    return singlePrecision() ? compact_.size() : coordinates_.size();
+  }
+
+  /* Coordinate of atom i in either precision */
+  [[nodiscard]] inline Eigen::Vector3d coordinate(
+      const size_t i) const noexcept {
+    return singlePrecision() ? compact_[i].cast<double>()
+                             : coordinates_[i];
+  }
+
+  [[nodiscard]] inline const_iterator begin() const noexcept {
+    return {this, 0};
+  }
+
+  [[nodiscard]] inline const_iterator end() const noexcept {
+    return {this, size()};
+  }
 
   [[nodiscard]] inline const_reverse_iterator rbegin() const noexcept {
-    return pointCharges_.rbegin();
+    return const_reverse_iterator(end());
   }
 
   [[nodiscard]] inline const_reverse_iterator rend() const noexcept {
-    return pointCharges_.rend();
+    return const_reverse_iterator(begin());
   }
 
-  [[nodiscard]] inline reverse_iterator rbegin() noexcept {
-    return pointCharges_.rbegin();
+  [[nodiscard]] inline const Topology& topology() const noexcept {
+    return *topology_;
   }
 
-  [[nodiscard]] inline reverse_iterator rend() noexcept {
-    return pointCharges_.rend();
+  [[nodiscard]] inline const std::shared_ptr<const Topology>& sharedTopology()
+      const noexcept {
+    return topology_;
   }
 
-  inline void updateCharges(const std::vector<double>& charges) {
-    if (pointCharges_.size() != charges.size()) {
-      SPDLOG_ERROR("Structure size: {}, number of charges: {}",
-                   pointCharges_.size(), charges.size());
+  /* Swaps in another topology for the same atoms */
+  inline void setTopology(std::shared_ptr<const Topology> topology) {
+    if (topology->size() != size()) {
       throw cpet::value_error(
-          "Inconsistent number of point charges in trajectory and in charge "
-          "file");
+          "Frame needs one coordinate per atom of its topology");
     }
-    for (size_t i = 0; i < pointCharges_.size(); i++) {
-      pointCharges_[i].charge = charges[i];
+    topology_ = std::move(topology);
+  }
+
+  /* Double precision coordinates, empty once the frame has been converted
+   * to single precision */
+  [[nodiscard]] inline util::Span<const Eigen::Vector3d> coordinates()
+      const noexcept {
+    return coordinates_;
+  }
+
+  [[nodiscard]] inline util::Span<Eigen::Vector3d> coordinates() noexcept {
+    return coordinates_;
+  }
+
+  [[nodiscard]] inline util::Span<const Eigen::Vector3f> compactCoordinates()
+      const noexcept {
+    return compact_;
+  }
+
+  [[nodiscard]] inline bool singlePrecision() const noexcept {
+    return compactStorage_ != nullptr;
+  }
+
+  /* Keeps the coordinates as floats from arena, halving their memory. PDB
+   * coordinates have three decimals, which a float holds exactly enough
+   * for anything short of 10^4 Angstrom. */
+  inline void toSinglePrecision(CompactArena& arena) {
+    if (singlePrecision()) {
+      return;
     }
+    compactStorage_ = arena.allocate(coordinates_.size());
+    compact_ = {compactStorage_.get(), coordinates_.size()};
+    std::transform(coordinates_.begin(), coordinates_.end(), compact_.begin(),
+                   [](const Eigen::Vector3d& coordinate) -> Eigen::Vector3f {
+                     return coordinate.cast<float>();
+                   });
+    storage_.reset();
+    coordinates_ = {};
   }
 
-  inline void push_back(const PointCharge& value) {
-    pointCharges_.push_back(value);
+  inline void updateCharges(const std::vector<double>& charges) {
+    topology_ = topology_->withCharges(charges);
   }
 
-  inline void push_Back(PointCharge&& value) {
-    pointCharges_.push_back(std::move(value));
+  /* Replaces the charges of every frame; frames that shared a topology
+   * share the updated one, so this is one copy per distinct topology */
+  static inline void updateCharges(std::vector<Frame>& frames,
+                                   const std::vector<double>& charges) {
+    std::shared_ptr<const Topology> original;
+    std::shared_ptr<const Topology> updated;
+    for (auto& frame : frames) {
+      if (frame.topology_ != original) {
+        original = frame.topology_;
+        updated = original->withCharges(charges);
+      }
+      frame.topology_ = updated;
+    }
   }
 
-  [[nodiscard]] inline static std::vector<Frame> loadFramesFromFile(
-      const std::string& file, const int start, const int skip) {
-    SPDLOG_DEBUG("Loading point charge trajectory from {} ...", file);
-    std::vector<PointCharge> tmpHolder;
-    std::vector<Frame> frameTrajectory;
+  /* Byte range [begin, end) of one model in a trajectory file */
+  struct Model {
+    size_t begin;
+    size_t end;
+    size_t firstLine;
+    bool terminated;
+  };
 
-    std::function<void(const std::string& line)> addPointCharge;
+  /* Two phase loader: the memory mapped file is first scanned for ENDMDL
+   * records to find the selected models, which are then parsed in parallel.
+   * Lines are string_views. Models whose atoms match the first model share
+   * its topology, so past it the only allocations are the coordinates.
+   * With useIndex the scan is replaced by the persistent model index (see
+   * cache::selectModels) so unselected models are never read. */
+  [[nodiscard]] static std::vector<Frame> loadFramesFromFile(
+      const std::string& file, int start, int skip, int numberOfThreads = 1,
+      bool useIndex = false);
 
-    if (util::endswith(file, ".pqr")) {
-      addPointCharge = [&](const std::string& line) {
-        const auto tokens = util::split(line, ' ');
-        tmpHolder.emplace_back(
-            Eigen::Vector3d({std::stod(tokens[constants::PQR_XCOORD_INDEX]),
-                             std::stod(tokens[constants::PQR_YCOORD_INDEX]),
-                             std::stod(tokens[constants::PQR_ZCOORD_INDEX])}),
-            std::stod(tokens[constants::PQR_CHARGE_INDEX]),
-            AtomID::generateID(line, constants::FileType::pqr));
-      };
-    } else {
-      /* Assume we have a pdb then */
-      addPointCharge = [&](const std::string& line) {
-        tmpHolder.emplace_back(
-            Eigen::Vector3d(
-                {std::stod(line.substr(constants::PDB_XCOORD_START,
-                                       constants::PDB_COORD_WIDTH)),
-                 std::stod(line.substr(constants::PDB_YCOORD_START,
-                                       constants::PDB_COORD_WIDTH)),
-                 std::stod(line.substr(constants::PDB_ZCOORD_START,
-                                       constants::PDB_COORD_WIDTH))}),
-            std::stod(line.substr(constants::PDB_CHARGE_START,
-                                  constants::PDB_CHARGE_WIDTH)),
-            AtomID::generateID(line, constants::FileType::pdb));
-      };
-    }
-
-    util::forEachLineIn(
-        file, [&, structureIndex = 0](const std::string& line) mutable {
-          if (structureIndex < start || (start - structureIndex) % skip != 0) {
-            /* No need to collect frames */
-            if (util::startswith(line, "ENDMDL")) {
-              ++structureIndex;
-            }
-          } else if (util::startswith(line, "ENDMDL")) {
-            frameTrajectory.emplace_back(tmpHolder);
-            tmpHolder.clear();
-            ++structureIndex;
-          } else if (util::startswith(line, "ATOM") ||
-                     util::startswith(line, "HETATM")) {
-            addPointCharge(line);
-          }
-        });
-    if (!tmpHolder.empty()) {
-      frameTrajectory.emplace_back(tmpHolder);
-    }
-    return frameTrajectory;
+  /* Streaming counterpart of loadFramesFromFile: frames are parsed in
+   * batches of numberOfThreads and handed to func one at a time, in order, so
+   * at most one batch is held in memory */
+  static void forEachFrameInFile(const std::string& file, int start, int skip,
+                                 int numberOfThreads,
+                                 const std::function<void(Frame)>& func,
+                                 bool useIndex = false);
+
+  /* Models kept after applying start and skip; terminated is false for
+   * trailing records after the last ENDMDL (or a file without any) */
+  [[nodiscard]] static std::vector<Model> indexModels(
+      std::string_view contents, int start, int skip);
+
+  /* Whether the model at index is kept by start/skip */
+  [[nodiscard]] static inline bool isSelected(const size_t index,
+                                              const int start,
+                                              const int skip) noexcept {
+    const auto first = static_cast<size_t>(std::max(start, 0));
+    return index >= first &&
+           (index - first) % static_cast<size_t>(std::max(skip, 1)) == 0;
   }
 
+  [[nodiscard]] static PointCharge parsePointCharge(std::string_view line,
+                                                    constants::FileType ft);
+
  private:
-  std::vector<PointCharge> pointCharges_;
+  std::shared_ptr<const Topology> topology_;
+  CoordinateStorage storage_;
+  util::Span<Eigen::Vector3d> coordinates_;
+  CompactStorage compactStorage_;
+  util::Span<Eigen::Vector3f> compact_;
+
+  [[nodiscard]] static inline Frame fromPointCharges_(
+      const std::vector<PointCharge>& pcs) {
+    std::vector<AtomID> ids;
+    std::vector<double> charges;
+    std::vector<Eigen::Vector3d> coordinates;
+    ids.reserve(pcs.size());
+    charges.reserve(pcs.size());
+    coordinates.reserve(pcs.size());
+    for (const auto& pc : pcs) {
+      ids.emplace_back(pc.id);
+      charges.emplace_back(pc.charge);
+      coordinates.emplace_back(pc.coordinate);
+    }
+    return {std::make_shared<const Topology>(std::move(ids),
+                                             std::move(charges)),
+            std::move(coordinates)};
+  }
 };
 
 }  // namespace cpet
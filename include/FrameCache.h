@@ -0,0 +1,154 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+/* C++ STL HEADER FILES */
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Frame.h"
+#include "Trajectory.h"
+
+namespace cpet::cache {
+
+constexpr std::string_view EXTENSION = ".cpetbin";
+constexpr uint32_t VERSION = 1;
+
+/* What a cache remembers about the text trajectory it was built from */
+struct Source {
+  uint64_t size;
+  int64_t modified;
+  uint64_t hash;
+};
+
+/* Fixed 64 byte header of a .cpetbin file. It is followed by the atom ids
+ * (newline terminated, padded to 8 bytes), the charges as doubles, and then
+ * one block of 3 * numberOfAtoms doubles per frame holding all x, then all
+ * y, then all z coordinates. */
+struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t numberOfAtoms;
+  uint64_t numberOfFrames;
+  uint64_t sourceSize;
+  int64_t sourceModified;
+  uint64_t sourceHash;
+  uint64_t idBytes;
+};
+static_assert(sizeof(Header) == 64);
+
+[[nodiscard]] inline std::string cacheFileFor(const std::string& source) {
+  return source + std::string(EXTENSION);
+}
+
+/* Size and modification time of file; the hash is only computed when
+ * withHash is set since it requires reading the whole file */
+[[nodiscard]] Source describe(const std::string& file, bool withHash = true);
+
+/* Memory mapped .cpetbin file. Frames are decoded without any parsing, the
+ * coordinates of a frame are a contiguous (structure of arrays) block. */
+class FrameCache final : public trajectory::Reader {
+ public:
+  explicit FrameCache(const std::string& file);
+
+  [[nodiscard]] size_t numberOfFrames() const noexcept override {
+    return header_.numberOfFrames;
+  }
+
+  [[nodiscard]] size_t numberOfAtoms() const noexcept override {
+    return header_.numberOfAtoms;
+  }
+
+  using Reader::read;
+
+  void read(size_t frame,
+            util::Span<Eigen::Vector3d> coordinates) const override;
+
+  /* x, y and z of frame as three consecutive arrays of numberOfAtoms */
+  [[nodiscard]] const double* coordinates(size_t frame) const;
+
+  [[nodiscard]] const double* charges() const noexcept { return charges_; }
+
+  /* Frame with the cached ids and charges, and the first frame coordinates */
+  [[nodiscard]] Frame topology() const;
+
+  [[nodiscard]] inline const Header& header() const noexcept {
+    return header_;
+  }
+
+  /* True when the cache was built from source as it is now. Size and
+   * modification time are compared first; when only the time differs the
+   * source is hashed. */
+  [[nodiscard]] bool isCurrentFor(const std::string& source) const;
+
+  /* Stores the modification time of a source that isCurrentFor, so that a
+   * touched source is not hashed again next time. A cache that cannot be
+   * written is left as it is. */
+  void refreshSource(const Source& current);
+
+ private:
+  Header header_{};
+  std::string_view ids_;
+  const double* charges_{nullptr};
+  const double* frames_{nullptr};
+};
+
+/* Appends frames to a new cache. The file is written next to its final
+ * location and only renamed into place by finish, so readers never see a
+ * partial cache. Frames that do not share the ids and charges of the first
+ * frame cannot be cached; the writer then silently gives up. */
+class Writer {
+ public:
+  Writer(std::string file, const Source& source);
+
+  Writer(const Writer&) = delete;
+  Writer(Writer&&) = delete;
+  Writer& operator=(const Writer&) = delete;
+  Writer& operator=(Writer&&) = delete;
+
+  ~Writer();
+
+  void add(const Frame& frame);
+
+  /* Returns false (and removes the partial file) if nothing was cached */
+  bool finish();
+
+ private:
+  std::string file_;
+  std::string temporaryFile_;
+  std::ofstream outFile_;
+  Header header_{};
+  std::shared_ptr<const Topology> topology_;
+  std::vector<double> buffer_;
+  bool failed_{false};
+
+  void writeHeader_(const Frame& frame);
+
+  [[nodiscard]] bool matches_(const Frame& frame) const;
+};
+
+/* Frames of a pdb/pqr trajectory selected by start and skip. A current
+ * cache next to file is used when there is one; otherwise the text is
+ * parsed in full and the cache is written along the way. */
+[[nodiscard]] std::vector<Frame> loadFrames(const std::string& file, int start,
+                                            int skip, int numberOfThreads);
+
+/* Streaming counterpart of loadFrames, see Frame::forEachFrameInFile */
+void forEachFrame(const std::string& file, int start, int skip,
+                  int numberOfThreads, const std::function<void(Frame)>& func);
+}  // namespace cpet::cache
+#endif  // FRAMECACHE_H
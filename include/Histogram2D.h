@@ -10,14 +10,47 @@
 #include <cassert>
 #include <algorithm>
 #include <numeric>
+#include <optional>
+#include <string>
 
 namespace cpet::histo {
 
+/* Normalized, flattened histograms of a trajectory together with the binning
+ * used to construct them */
+struct HistogramSet {
+  std::array<int, 2> bins;
+  std::array<double, 2> xlim;
+  std::array<double, 2> ylim;
+  std::vector<std::vector<double>> histograms;
+};
+
+void writeHistograms(const std::string& file, const HistogramSet& set);
+
+[[nodiscard]] HistogramSet readHistograms(const std::string& file);
+
 [[nodiscard]] std::vector<std::vector<int>> construct2DHistogram(
     const std::vector<double>& x, const std::vector<double>& y,
     const std::array<int, 2>& bins, const std::array<double, 2>& xlim,
     const std::array<double, 2>& ylim) noexcept;
 
+/* Constructs a histogram for every requested resolution in a single pass
+ * over the data. Resolutions that nest into a finer requested one by a power
+ * of two are derived by summing blocks of the finer histogram. */
+[[nodiscard]] std::vector<std::vector<std::vector<int>>> construct2DHistograms(
+    const std::vector<double>& x, const std::vector<double>& y,
+    const std::vector<std::array<int, 2>>& bins,
+    const std::array<double, 2>& xlim,
+    const std::array<double, 2>& ylim) noexcept;
+
+[[nodiscard]] constexpr bool nestsByPowerOfTwo(const int fine,
+                                               const int coarse) noexcept {
+  if (coarse <= 0 || fine < coarse || fine % coarse != 0) {
+    return false;
+  }
+  const auto factor = static_cast<unsigned int>(fine / coarse);
+  return (factor & (factor - 1)) == 0;
+}
+
 [[nodiscard]] inline std::vector<double> constructEdges(const double min,
                                                         const double max,
                                                         const int bins) {
@@ -52,6 +85,23 @@ namespace cpet::histo {
   return result;
 }
 
+enum class Metric { chi, hellinger, jensenShannon, l1 };
+
+[[nodiscard]] std::optional<Metric> decodeMetric(const std::string& metric);
+
+[[nodiscard]] std::string metricName(Metric metric) noexcept;
+
+/* One slot per Metric; a metric list holds each metric at most once */
+constexpr size_t METRIC_COUNT = 4;
+using Distances = std::array<double, METRIC_COUNT>;
+
+/* Computes every requested metric between two normalized histograms in a
+ * single sweep over the bins, without allocating. result[m] holds the
+ * distance for metrics[m]; metrics must not repeat a metric. */
+void distances(const std::vector<double>& normHist1,
+               const std::vector<double>& normHist2,
+               const std::vector<Metric>& metrics, Distances& result) noexcept;
+
 [[nodiscard]] inline double chiDistance(
     const std::vector<double>& normHist1,
     const std::vector<double>& normHist2) noexcept {
@@ -0,0 +1,61 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+/* C++ STL HEADER FILES */
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cpet::util {
+
+/* Read-only memory map of an entire file. The contents are exposed as a
+ * string_view that stays valid for the lifetime of the MappedFile. */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& file);
+
+  MappedFile(MappedFile&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  ~MappedFile();
+
+  [[nodiscard]] inline std::string_view view() const noexcept {
+    return {static_cast<const char*>(data_), size_};
+  }
+
+  [[nodiscard]] inline size_t size() const noexcept { return size_; }
+
+ private:
+  void* data_{nullptr};
+  size_t size_{0};
+};
+
+/* Calls func with every line of contents, without the trailing newline (or
+ * carriage return). Lines are views into contents, nothing is copied. */
+template <class Function>
+void forEachLineOf(const std::string_view contents, Function&& func) {
+  const char* current = contents.data();
+  const char* const last = current + contents.size();
+  while (current < last) {
+    const auto* newline = static_cast<const char*>(
+        std::memchr(current, '\n', static_cast<size_t>(last - current)));
+    const char* lineEnd = (newline == nullptr) ? last : newline;
+    auto length = static_cast<size_t>(lineEnd - current);
+    if (length > 0 && current[length - 1] == '\r') {
+      --length;
+    }
+    func(std::string_view(current, length));
+    current = lineEnd + 1;
+  }
+}
+}  // namespace cpet::util
+#endif  // MAPPEDFILE_H
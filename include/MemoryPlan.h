@@ -0,0 +1,70 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef MEMORYPLAN_H
+#define MEMORYPLAN_H
+
+/* C++ STL HEADER FILES */
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Option.h"
+
+namespace cpet::memory {
+
+/* Size of the trajectory that will be processed */
+struct Workload {
+  size_t numberOfAtoms;
+  size_t numberOfFrames;
+  /* Per coordinate, smaller with --single-precision */
+  size_t coordinateBytes{sizeof(Eigen::Vector3d)};
+};
+
+/* One contribution to the footprint, e.g. "frames" */
+struct Item {
+  std::string name;
+  uint64_t bytes;
+};
+
+/* How to run within a memory budget, and what it is expected to take */
+struct Plan {
+  bool stream;
+  int numberOfThreads;
+  std::vector<Item> items;
+
+  [[nodiscard]] uint64_t footprint() const noexcept;
+
+  /* One line per item, largest first */
+  [[nodiscard]] std::string describe() const;
+};
+
+/* Bytes in a size such as 512M, 8G or 8GiB; suffixes are powers of 1024 and
+ * a plain number is in bytes */
+[[nodiscard]] uint64_t parseSize(std::string_view size);
+
+/* 1.5 GiB and the like */
+[[nodiscard]] std::string formatSize(uint64_t bytes);
+
+/* Estimated peak memory of the calculations in option, running either on
+ * every frame at once or streaming them in batches of numberOfThreads.
+ * Only what grows with the atoms, frames, grid or samples is counted.
+ * Topology analyses that read samples or histograms from files are not,
+ * as their size is not known before they are read. Adaptive plot3d grids
+ * count the points of refining every cell to their maximum depth. */
+[[nodiscard]] Plan estimate(const Option& option, const Workload& workload,
+                            bool stream, int numberOfThreads);
+
+/* The plan closest to the requested one that fits in budget: streaming is
+ * switched on first, then the number of threads reduced. Throws a
+ * value_error listing the footprint when even streaming on one thread
+ * does not fit. */
+[[nodiscard]] Plan makePlan(const Option& option, const Workload& workload,
+                            uint64_t budget, bool stream, int numberOfThreads);
+}  // namespace cpet::memory
+#endif  // MEMORYPLAN_H
@@ -0,0 +1,39 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef MODELINDEX_H
+#define MODELINDEX_H
+
+/* C++ STL HEADER FILES */
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* CPET HEADER FILES */
+#include "Frame.h"
+
+namespace cpet::cache {
+
+constexpr std::string_view INDEX_EXTENSION = ".cpetidx";
+
+[[nodiscard]] inline std::string indexFileFor(const std::string& source) {
+  return source + std::string(INDEX_EXTENSION);
+}
+
+/* Scans every model of a pdb/pqr trajectory and writes the byte offsets to
+ * the index next to it */
+std::vector<Frame::Model> buildIndex(const std::string& file);
+
+/* All models of file, or nullopt when its index is missing or was written
+ * for a different size or modification time of file */
+[[nodiscard]] std::optional<std::vector<Frame::Model>> readIndex(
+    const std::string& file);
+
+/* Models selected by start and skip. They come from the index when it is
+ * current, so nothing outside of them is read; otherwise contents is
+ * scanned and the index saved for the next run. */
+[[nodiscard]] std::vector<Frame::Model> selectModels(
+    const std::string& file, std::string_view contents, int start, int skip);
+}  // namespace cpet::cache
+#endif  // MODELINDEX_H
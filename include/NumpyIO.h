@@ -0,0 +1,86 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef NUMPYIO_H
+#define NUMPYIO_H
+
+/* C++ STL HEADER FILES */
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Span.h"
+#include "Utilities.h"
+
+namespace cpet::util {
+
+constexpr std::string_view NPY_EXTENSION = ".npy";
+constexpr std::string_view NPZ_EXTENSION = ".npz";
+
+/* Outputs named like this are written for NumPy instead of as text */
+[[nodiscard]] inline bool isNpyFile(const std::string_view file) noexcept {
+  return file.size() > NPY_EXTENSION.size() && endswith(file, NPY_EXTENSION);
+}
+
+[[nodiscard]] inline bool isNpzFile(const std::string_view file) noexcept {
+  return file.size() > NPZ_EXTENSION.size() && endswith(file, NPZ_EXTENSION);
+}
+
+/* The row-major float64 data of an array, as one or more consecutive runs
+ * so that e.g. the rows of a std::vector<std::vector<double>> need not be
+ * copied into one block first */
+using Chunks = std::vector<Span<const double>>;
+
+/* points as one (n, 3) block, Eigen::Vector3d is three packed doubles */
+[[nodiscard]] inline Span<const double> flatView(
+    const std::vector<Eigen::Vector3d>& points) noexcept {
+  static_assert(sizeof(Eigen::Vector3d) == 3 * sizeof(double));
+  return {points.empty() ? nullptr : points.front().data(), 3 * points.size()};
+}
+
+/* .npy file (format version 1.0) holding data with the given shape */
+void writeNpy(const std::string& file, const std::vector<size_t>& shape,
+              const Chunks& data);
+
+/* Uncompressed .npz archive, as written by numpy.savez. Arrays are written
+ * as they are added; finish writes the zip directory, without it the archive
+ * cannot be read. */
+class NpzWriter {
+ public:
+  explicit NpzWriter(const std::string& file);
+
+  /* Next run of the data of an array, empty once all of it is written */
+  using Producer = std::function<Span<const double>()>;
+
+  /* name is the key of the array in numpy.load, without the extension */
+  void add(const std::string& name, const std::vector<size_t>& shape,
+           const Chunks& data);
+
+  /* As above, with the data generated while it is written so that it never
+   * has to be held in memory as a whole */
+  void add(const std::string& name, const std::vector<size_t>& shape,
+           const Producer& next);
+
+  void finish();
+
+ private:
+  struct Entry {
+    std::string name;
+    uint32_t crc;
+    uint64_t size;
+    uint64_t offset;
+  };
+
+  std::string file_;
+  std::ofstream outFile_;
+  std::vector<Entry> entries_;
+};
+}  // namespace cpet::util
+#endif  // NUMPYIO_H
@@ -0,0 +1,46 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef OCTREE_H
+#define OCTREE_H
+
+/* C++ STL HEADER FILES */
+#include <functional>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Volume.h"
+
+namespace cpet::octree {
+
+/* How far to refine the cells of a grid, see refine */
+struct Refinement {
+  int maxDepth;
+  double tolerance;
+};
+
+/* Deepest refinement accepted, each level costing up to 8x the points */
+constexpr int MAX_DEPTH = 10;
+
+/* Points of a refined grid and the field at each of them */
+struct Sample {
+  std::vector<Eigen::Vector3d> points;
+  std::vector<Eigen::Vector3d> fields;
+};
+
+using Field = std::function<Eigen::Vector3d(const Eigen::Vector3d&)>;
+
+/* The points of grid, then those added by recursively splitting each cell
+ * (eight neighbouring grid points) into eight across which the field
+ * varies: the magnitudes at its corners differ by more than tolerance
+ * relative to the largest, or the directions by more than tolerance
+ * radians. Cells are split at most maxDepth times and shared corners are
+ * computed once. Fields are computed over numberOfThreads, and the order
+ * of the points does not depend on it. */
+[[nodiscard]] Sample refine(const Grid& grid, const Refinement& refinement,
+                            const Field& field, int numberOfThreads = 1);
+}  // namespace cpet::octree
+#endif  // OCTREE_H
@@ -31,5 +31,29 @@ struct PointCharge {
            (id == pc.id);
   }
 } __attribute__((aligned(128)));
+
+/* A point charge of a Frame, viewed in place: the charge belongs to its
+ * shared Topology. The coordinate is a copy since the frame may hold it in
+ * single precision, and the id is made from the packed id of the topology. */
+struct PointChargeRef {
+  Eigen::Vector3d coordinate;
+
+  double charge;
+
+  AtomID id;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  inline operator PointCharge() const { return {coordinate, charge, id}; }
+
+  [[nodiscard]] inline bool operator==(const PointChargeRef& pc) const {
+    return (coordinate == pc.coordinate) && (charge == pc.charge) &&
+           (id == pc.id);
+  }
+
+  [[nodiscard]] inline bool operator==(const PointCharge& pc) const {
+    return (coordinate == pc.coordinate) && (charge == pc.charge) &&
+           (id == pc.id);
+  }
+};
 }  // namespace cpet
 #endif  // POINTCHARGE_H
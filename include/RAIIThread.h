@@ -5,8 +5,11 @@
 #define RAIITHREAD_H
 
 /* C++ STL HEADER FILES */
+#include <algorithm>
+#include <exception>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace cpet {
 namespace util {
@@ -60,6 +63,44 @@ class RAIIThread {
   std::thread thread_;
 };
 
+/* Splits [0, size) into one contiguous chunk per thread and calls
+ * func(begin, end, threadIndex) on each. An exception thrown by any chunk is
+ * rethrown on the calling thread once every worker has finished. */
+template <typename Function>
+inline void forEachChunk(const size_t size, const int numberOfThreads,
+                         const Function& func) {
+  const auto nThreads =
+      std::clamp<size_t>(static_cast<size_t>(std::max(numberOfThreads, 1)), 1,
+                         std::max<size_t>(size, 1));
+  if (nThreads == 1) {
+    func(size_t{0}, size, size_t{0});
+    return;
+  }
+
+  const size_t chunk = (size + nThreads - 1) / nThreads;
+  std::vector<std::exception_ptr> errors(nThreads);
+  {
+    std::vector<RAIIThread> workers;
+    workers.reserve(nThreads);
+    for (size_t t = 0; t < nThreads; ++t) {
+      const size_t begin = std::min(size, t * chunk);
+      const size_t end = std::min(size, begin + chunk);
+      workers.emplace_back([&func, &errors, begin, end, t]() {
+        try {
+          func(begin, end, t);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 }  // namespace util
 }  // namespace cpet
 #endif  // RAIITHREAD_H
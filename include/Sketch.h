@@ -0,0 +1,44 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#ifndef SKETCH_H
+#define SKETCH_H
+
+/* C++ STL HEADER FILES */
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+namespace cpet::sketch {
+
+constexpr int DEFAULT_SKETCH_SIZE = 64;
+constexpr int DEFAULT_NUMBER_OF_TREES = 8;
+
+struct Options {
+  int neighbors;
+  int sketchSize{DEFAULT_SKETCH_SIZE};
+  int numberOfTrees{DEFAULT_NUMBER_OF_TREES};
+  bool refine{false};
+};
+
+struct Neighbor {
+  size_t index;
+  double distance;
+};
+
+using Graph = std::vector<std::vector<Neighbor>>;
+
+/* Random Gaussian projection of the square-root histograms. Euclidean
+ * distances between columns approximate sqrt(2) times the Hellinger
+ * distance between the original normalized histograms. */
+[[nodiscard]] Eigen::MatrixXd construct(
+    const std::vector<std::vector<double>>& histograms, int sketchSize);
+
+/* Approximate k-nearest-neighbor graph built from a random projection forest
+ * over the sketches. Distances are Hellinger estimates, or exact chi
+ * distances when options.refine is set. */
+[[nodiscard]] Graph nearestNeighbors(
+    const std::vector<std::vector<double>>& histograms, const Options& options,
+    int numberOfThreads);
+}  // namespace cpet::sketch
+#endif  // SKETCH_H
@@ -0,0 +1,70 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef SPAN_H
+#define SPAN_H
+
+/* C++ STL HEADER FILES */
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace cpet::util {
+
+/* A pointer and a number of elements that follow it, standing in for the
+ * C++20 std::span. A Span<T> converts to a Span<const T>, and any contiguous
+ * container (std::vector, std::array) converts to a Span of its elements. */
+template <typename T>
+class Span {
+ public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using iterator = T*;
+
+  constexpr Span() noexcept = default;
+
+  constexpr Span(T* data, const size_t size) noexcept
+      : data_(data), size_(size) {}
+
+  template <typename Container,
+            typename = std::enable_if_t<std::is_convertible_v<
+                decltype(std::data(std::declval<Container&>())), T*>>>
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr Span(Container& container) noexcept
+      : data_(std::data(container)), size_(std::size(container)) {}
+
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible_v<U (*)[], T (*)[]>>>
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr Span(const Span<U>& other) noexcept
+      : data_(other.data()), size_(other.size()) {}
+
+  [[nodiscard]] constexpr T* data() const noexcept { return data_; }
+
+  [[nodiscard]] constexpr size_t size() const noexcept { return size_; }
+
+  [[nodiscard]] constexpr size_t size_bytes() const noexcept {
+    return size_ * sizeof(T);
+  }
+
+  [[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] constexpr T& operator[](const size_t index) const noexcept {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  [[nodiscard]] constexpr iterator begin() const noexcept { return data_; }
+
+  [[nodiscard]] constexpr iterator end() const noexcept {
+    return data_ + size_;
+  }
+
+ private:
+  T* data_{nullptr};
+  size_t size_{0};
+};
+}  // namespace cpet::util
+#endif  // SPAN_H
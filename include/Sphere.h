@@ -0,0 +1,71 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef SPHERE_H
+#define SPHERE_H
+
+/* C++ STL HEADER FILES */
+#include <string>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "Volume.h"
+namespace cpet {
+class Sphere final : public Volume {
+ public:
+  explicit inline Sphere(const double radius,
+                         const Eigen::Vector3d& center = {0, 0, 0})
+      : radius_(radius), radiusSquared_(radius * radius) {
+    if (!(radius_ > 0.0)) {
+      SPDLOG_ERROR("Invalid value for sphere radius {}", radius_);
+      throw cpet::value_error("Invalid value for sphere radius");
+    }
+    center_ = center;
+  }
+
+  [[nodiscard]] inline const double& maxDim() const noexcept override {
+    return radius_;
+  }
+
+  [[nodiscard]] inline double diagonal() const noexcept {
+    return 2 * radius_;
+  }
+
+  [[nodiscard]] inline bool isInside(
+      const Eigen::Vector3d& position) const override {
+    return (position - center_).squaredNorm() < radiusSquared_;
+  }
+
+  [[nodiscard]] inline Eigen::Vector3d randomPoint() const noexcept override {
+    return radius_ * randomUnitBallPoint_() + center_;
+  }
+
+  [[nodiscard]] inline std::string description() const noexcept override {
+    return "Sphere: " + std::to_string(radius_);
+  }
+
+  [[nodiscard]] inline int randomDistance(
+      double stepSize) const noexcept override {
+    return randomSteps_(diagonal(), stepSize);
+  }
+
+  [[nodiscard]] inline std::string type() const noexcept override {
+    return "sphere";
+  }
+
+  [[nodiscard]] inline Grid grid(
+      const std::array<int, 3>& density) const override {
+    return boundingGrid_({radius_, radius_, radius_}, density)
+        .filter([this](const Eigen::Vector3d& p) { return isInside(p); });
+  }
+
+ private:
+  double radius_;
+  double radiusSquared_;
+};
+}  // namespace cpet
+#endif  // SPHERE_H
@@ -38,15 +38,27 @@ class System {
       int numOfThreads, const Volume& volume, const double stepsize,
       const int numberOfSamples) const;
 
-  inline void transformToUserSpace() {
-    translateSystemToCenter_();
-    transformToUserBasis_();
-  }
+  /* From here on positions are given in, and fields returned in, the user
+   * basis centered on center(). The charges are never moved; query points
+   * are mapped back into the frame instead, which is far cheaper than
+   * rewriting every coordinate of the frame. */
+  inline void transformToUserSpace() noexcept { userSpace_ = true; }
 
   [[nodiscard]] inline Eigen::Vector3d transformToUserSpace(
       const Eigen::Vector3d& vec) const noexcept {
-    const Eigen::Matrix3d inverse = basisMatrix_.inverse();
-    return inverse * (vec - center_);
+    return inverse_ * (vec - center_);
+  }
+
+  [[nodiscard]] inline Eigen::Vector3d transformToDefaultSpace(
+      const Eigen::Vector3d& vec) const noexcept {
+    return basisMatrix_ * vec + center_;
+  }
+
+  /* Position of atom i in the space the system is currently in */
+  [[nodiscard]] inline Eigen::Vector3d coordinate(
+      const size_t i) const noexcept {
+    const auto position = frame_.coordinate(i);
+    return userSpace_ ? transformToUserSpace(position) : position;
   }
 
   inline void printCenterAndBasis() const noexcept {
@@ -80,48 +92,19 @@ class System {
   [[nodiscard]] double curvatureAt_(const Eigen::Vector3d& alpha_0,
                                     double stepSize) const noexcept;
 
-  [[nodiscard]] PathSample sampleElectricFieldTopologyIn_(
-      const Volume& region, double stepSize) const noexcept;
+  /* Region is the concrete volume, see visitVolume */
+  template <typename Region>
+  [[nodiscard]] std::vector<PathSample> electricFieldTopologyIn_(
+      int numOfThreads, const Region& region, double stepsize,
+      int numberOfSamples) const;
 
-  inline void forEachPointCharge_(
-      const std::function<void(PointCharge&)>& func) {
-    std::for_each(pointCharges_.begin(), pointCharges_.end(), func);
-    std::for_each(frame_.begin(), frame_.end(), func);
-  }
-
-  inline void translateSystemTo_(const Eigen::Vector3d& position) {
-    forEachPointCharge_(
-        [&position](PointCharge& pc) { pc.coordinate -= position; });
-  }
-
-  inline void translateSystemToCenter_() {
-    SPDLOG_DEBUG("Translating to the center");
-    SPDLOG_DEBUG("[center] ==>> {}", center_.transpose());
-    translateSystemTo_(center_);
-  }
-
-  [[maybe_unused]] inline void translateSystemToOrigin_() {
-    SPDLOG_DEBUG("Translating to the Origin");
-    translateSystemTo_(-1 * (center_));
-  }
-
-  inline void transformToUserBasis_() {
-    SPDLOG_DEBUG("Translating to user basis");
-
-    Eigen::Matrix3d inverse = basisMatrix_.inverse();
-    SPDLOG_DEBUG("[User Basis]");
-    SPDLOG_DEBUG(inverse);
-    forEachPointCharge_([&inverse](PointCharge& pc) {
-      pc.coordinate = inverse * pc.coordinate;
-    });
-  }
+  template <typename Region>
+  [[nodiscard]] PathSample sampleElectricFieldTopologyIn_(
+      const Region& region, double stepSize) const noexcept;
 
-  [[maybe_unused]] inline void transformToDefaultBasis_() {
-    SPDLOG_DEBUG("Translating to default basis");
-    forEachPointCharge_([this](PointCharge& pc) {
-      pc.coordinate = basisMatrix_ * pc.coordinate;
-    });
-  }
+  /* Field at a position in the coordinates of the frame */
+  [[nodiscard]] Eigen::Vector3d electricFieldInFrameAt_(
+      const Eigen::Vector3d& position) const noexcept;
 
   [[nodiscard]] inline Eigen::Vector3d nextPoint_(
       const Eigen::Vector3d& pos, const double stepSize) const noexcept {
@@ -131,9 +114,10 @@ class System {
   }
 
   Frame frame_;
-  std::vector<PointCharge> pointCharges_;
   Eigen::Vector3d center_;
   Eigen::Matrix3d basisMatrix_;
+  Eigen::Matrix3d inverse_;
+  bool userSpace_{false};
 };
 }  // namespace cpet
 #endif  // SYSTEM_H
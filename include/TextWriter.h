@@ -0,0 +1,135 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+#include <spdlog/fmt/fmt.h>
+
+/* CPET HEADER FILES */
+#include "RAIIThread.h"
+
+namespace cpet::util {
+
+/* Text formatted with fmt instead of an ostream. Every append produces
+ * exactly the characters the equivalent stream insertion would. */
+class TextBuffer {
+ public:
+  /* Precision of a freshly constructed stream */
+  static constexpr int STREAM_PRECISION = 6;
+
+  inline void append(const char c) { buffer_.push_back(c); }
+
+  inline void append(const std::string_view str) { buffer_.append(str); }
+
+  /* As a stream in its default float field, i.e. printf's %.{precision}g */
+  inline void appendGeneral(const double value,
+                            const int precision = STREAM_PRECISION) {
+    std::array<char, MAX_LENGTH> storage;
+    append(format_(value, Notation::general, precision, storage));
+  }
+
+  /* As a stream set to std::fixed, i.e. printf's %.{precision}f */
+  inline void appendFixed(const double value, const int precision) {
+    std::array<char, MAX_LENGTH> storage;
+    append(format_(value, Notation::fixed, precision, storage));
+  }
+
+  /* As Eigen prints a vector transposed with its default IOFormat: the
+   * coefficients right aligned to the widest one, separated by a space */
+  inline void appendAligned(const Eigen::Vector3d& vector,
+                            const int precision = STREAM_PRECISION) {
+    std::array<std::array<char, MAX_LENGTH>, 3> storage;
+    std::array<std::string_view, 3> coefficients;
+    size_t width = 0;
+    for (size_t i = 0; i < 3; ++i) {
+      coefficients[i] = format_(vector[static_cast<long>(i)],
+                                Notation::general, precision, storage[i]);
+      width = std::max(width, coefficients[i].size());
+    }
+    for (size_t i = 0; i < 3; ++i) {
+      if (i != 0) {
+        append(' ');
+      }
+      buffer_.append(width - coefficients[i].size(), ' ');
+      append(coefficients[i]);
+    }
+  }
+
+  inline void clear() noexcept { buffer_.clear(); }
+
+  [[nodiscard]] inline std::string_view view() const noexcept {
+    return buffer_;
+  }
+
+  inline void writeTo(std::ostream& outFile) const {
+    outFile.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  }
+
+ private:
+  /* Longest fixed notation of a double with a small precision */
+  static constexpr size_t MAX_LENGTH = 352;
+
+  std::string buffer_;
+
+  enum class Notation { general, fixed };
+
+  [[nodiscard]] static inline std::string_view format_(
+      const double value, const Notation notation, const int precision,
+      std::array<char, MAX_LENGTH>& storage) {
+    const auto result =
+        (notation == Notation::fixed)
+            ? fmt::format_to_n(storage.data(), storage.size(), "{:.{}f}",
+                               value, precision)
+            : fmt::format_to_n(storage.data(), storage.size(), "{:.{}g}",
+                               value, precision);
+    return {storage.data(), std::min(result.size, storage.size())};
+  }
+};
+
+/* Writes rows [0, size) to outFile in order, row i being whatever
+ * format(buffer, i) appends. Blocks of rows are formatted concurrently and
+ * only one block per thread is held in memory at a time. */
+template <typename Function>
+void writeRows(std::ostream& outFile, const size_t size,
+               const int numberOfThreads, const Function& format) {
+  constexpr size_t ROWS_PER_BLOCK = size_t{1} << 14;
+  const auto nThreads = static_cast<size_t>(std::max(numberOfThreads, 1));
+  const size_t rowsPerBatch = nThreads * ROWS_PER_BLOCK;
+
+  std::vector<TextBuffer> blocks(std::min(
+      nThreads, (size + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK));
+  for (size_t first = 0; first < size; first += rowsPerBatch) {
+    const auto last = std::min(size, first + rowsPerBatch);
+    const auto numberOfBlocks =
+        (last - first + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+    forEachChunk(numberOfBlocks, numberOfThreads,
+                 [&](const size_t begin, const size_t end, size_t) {
+                   for (size_t b = begin; b < end; ++b) {
+                     auto& block = blocks[b];
+                     block.clear();
+                     const auto blockBegin = first + b * ROWS_PER_BLOCK;
+                     const auto blockEnd =
+                         std::min(last, blockBegin + ROWS_PER_BLOCK);
+                     for (size_t row = blockBegin; row < blockEnd; ++row) {
+                       format(block, row);
+                     }
+                   }
+                 });
+    for (size_t b = 0; b < numberOfBlocks; ++b) {
+      blocks[b].writeTo(outFile);
+    }
+  }
+}
+}  // namespace cpet::util
+#endif  // TEXTWRITER_H
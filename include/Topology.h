@@ -0,0 +1,165 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "AtomID.h"
+#include "Exceptions.h"
+
+namespace cpet {
+
+/* Atom ids and charges of a trajectory. They are the same in every frame, so
+ * frames share one immutable Topology and only own their coordinates. Ids
+ * are stored packed, 16 bytes an atom; only the ids that do not pack keep
+ * their string. */
+class Topology {
+ public:
+  inline Topology(const std::vector<AtomID>& ids, std::vector<double> charges)
+      : charges_(std::move(charges)) {
+    if (ids.size() != charges_.size()) {
+      throw cpet::value_error("Topology needs one charge per atom id");
+    }
+    if (ids.size() >= EMPTY) {
+      throw cpet::value_error("Too many atoms in topology");
+    }
+    ids_.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (const auto packed = ids[i].packed()) {
+        ids_.emplace_back(*packed);
+      } else {
+        ids_.emplace_back();
+        unpacked_.emplace(static_cast<uint32_t>(i), ids[i]);
+      }
+    }
+    index_();
+  }
+
+  [[nodiscard]] inline size_t size() const noexcept { return ids_.size(); }
+
+  /* Made on demand, without allocating for ids that pack */
+  [[nodiscard]] inline AtomID id(const size_t i) const {
+    if (ids_[i].empty()) {
+      return unpacked_.at(static_cast<uint32_t>(i));
+    }
+    return AtomID(ids_[i]);
+  }
+
+  /* Whether atom i has id, without making the AtomID of atom i */
+  [[nodiscard]] inline bool hasID(const size_t i,
+                                  const AtomID& id) const noexcept {
+    if (!ids_[i].empty()) {
+      const auto packed = id.packed();
+      return packed && *packed == ids_[i];
+    }
+    const auto unpacked = unpacked_.find(static_cast<uint32_t>(i));
+    return unpacked != unpacked_.end() && unpacked->second == id;
+  }
+
+  [[nodiscard]] inline double charge(const size_t i) const noexcept {
+    return charges_[i];
+  }
+
+  [[nodiscard]] inline const std::vector<double>& charges() const noexcept {
+    return charges_;
+  }
+
+  /* Atoms with a non-zero charge, the only ones that add a field */
+  [[nodiscard]] inline const std::vector<uint32_t>& chargedAtoms()
+      const noexcept {
+    return charged_;
+  }
+
+  [[nodiscard]] inline std::optional<size_t> indexOf(
+      const AtomID& id) const noexcept {
+    const auto mask = slots_.size() - 1;
+    for (auto slot = id.hash() & mask; slots_[slot] != EMPTY;
+         slot = (slot + 1) & mask) {
+      if (hasID(slots_[slot], id)) {
+        return slots_[slot];
+      }
+    }
+    return std::nullopt;
+  }
+
+  /* Same atoms with charges replaced, e.g. from an external charge file */
+  [[nodiscard]] std::shared_ptr<const Topology> withCharges(
+      std::vector<double> charges) const {
+    if (charges.size() != charges_.size()) {
+      SPDLOG_ERROR("Structure size: {}, number of charges: {}",
+                   charges_.size(), charges.size());
+      throw cpet::value_error(
+          "Inconsistent number of point charges in trajectory and in charge "
+          "file");
+    }
+    auto result = std::make_shared<Topology>(*this);
+    result->charges_ = std::move(charges);
+    result->index_();
+    return result;
+  }
+
+  [[nodiscard]] inline bool operator==(const Topology& rhs) const noexcept {
+    return (charges_ == rhs.charges_) && (ids_ == rhs.ids_) &&
+           (unpacked_ == rhs.unpacked_);
+  }
+
+ private:
+  static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+  /* A power of two, so that a hash is masked into a slot */
+  static constexpr size_t MIN_SLOTS = 8;
+
+  /* Empty where the id did not pack, its AtomID is in unpacked_ instead */
+  std::vector<PackedAtomID> ids_;
+  std::unordered_map<uint32_t, AtomID> unpacked_;
+  std::vector<double> charges_;
+  std::vector<uint32_t> slots_;
+  std::vector<uint32_t> charged_;
+
+  [[nodiscard]] inline uint32_t hash_(const size_t i) const noexcept {
+    return ids_[i].empty() ? unpacked_.find(static_cast<uint32_t>(i))
+                                 ->second.hash()
+                           : ids_[i].hash();
+  }
+
+  /* Open addressing over the precomputed id hashes, at most half full.
+   * Duplicate ids resolve to the first atom, as a linear search would. */
+  inline void index_() {
+    size_t capacity = MIN_SLOTS;
+    while (capacity < 2 * ids_.size()) {
+      capacity *= 2;
+    }
+    slots_.assign(capacity, EMPTY);
+    const auto mask = slots_.size() - 1;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+      auto slot = hash_(i) & mask;
+      while (slots_[slot] != EMPTY && !hasID(slots_[slot], id(i))) {
+        slot = (slot + 1) & mask;
+      }
+      if (slots_[slot] == EMPTY) {
+        slots_[slot] = static_cast<uint32_t>(i);
+      }
+    }
+    charged_.clear();
+    for (size_t i = 0; i < charges_.size(); ++i) {
+      if (charges_[i] != 0.0) {
+        charged_.push_back(static_cast<uint32_t>(i));
+      }
+    }
+  }
+};
+}  // namespace cpet
+#endif  // TOPOLOGY_H
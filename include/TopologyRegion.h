@@ -14,6 +14,10 @@
 /* CPET HEADER FILES */
 #include "Volume.h"
 #include "PathSample.h"
+#include "Cluster.h"
+#include "Sketch.h"
+#include "Histogram2D.h"
+#include "NumpyIO.h"
 
 namespace cpet {
 
@@ -35,15 +39,34 @@ class TopologyRegion {
            "; Volume: " + volume_->description();
   }
 
+  /* Incremental form of computeTopologyWith; systems are fed one at a time
+   * and only their path samples are retained until finish() */
+  class Stream {
+   public:
+    Stream(const TopologyRegion& region, int numberOfThreads);
+
+    void add(const System& system);
+
+    void finish();
+
+   private:
+    const TopologyRegion& region_;
+    int numberOfThreads_;
+    int index_{0};
+    std::vector<std::vector<PathSample>> sampleResults_;
+    std::optional<util::NpzWriter> samples_;
+  };
+
   void computeTopologyWith(const std::vector<System>& systems,
                            int numberOfThreads) const;
 
   [[nodiscard]] constexpr bool computeMatrix() const noexcept {
-    return static_cast<bool>(bins_);
+    return static_cast<bool>(bins_) || static_cast<bool>(histogramInput_);
   }
 
   [[nodiscard]] constexpr bool analysisOnly() const noexcept {
-    return static_cast<bool>(sampleInput_);
+    return static_cast<bool>(sampleInput_) ||
+           static_cast<bool>(histogramInput_);
   }
 
   [[nodiscard]] constexpr int numberOfSamples() const noexcept {
@@ -74,6 +97,42 @@ class TopologyRegion {
     return sampleInput_;
   }
 
+  inline void histogramOutput(const std::string& str) noexcept {
+    if (!str.empty()) {
+      histogramOutput_ = str;
+    }
+  }
+
+  [[nodiscard]] constexpr const std::optional<std::string>& histogramOutput()
+      const noexcept {
+    return histogramOutput_;
+  }
+
+  inline void histogramInput(const std::string& str) noexcept {
+    if (!str.empty()) {
+      histogramInput_ = str;
+    }
+  }
+
+  [[nodiscard]] constexpr const std::optional<std::string>& histogramInput()
+      const noexcept {
+    return histogramInput_;
+  }
+
+  [[nodiscard]] inline const std::vector<histo::Metric>& metrics()
+      const noexcept {
+    return metrics_;
+  }
+
+  /* The one of metrics() whose distance matrix is clustered */
+  [[nodiscard]] constexpr histo::Metric clusterMetric() const noexcept {
+    return clusterMetric_;
+  }
+
+  [[nodiscard]] constexpr bool binaryMatrix() const noexcept {
+    return binaryMatrix_;
+  }
+
   inline void matrixOutput(const std::string& str) noexcept {
     if (!str.empty()) {
       matrixOutput_ = str;
@@ -85,6 +144,43 @@ class TopologyRegion {
     return bins_;
   }
 
+  [[nodiscard]] constexpr const std::vector<std::array<int, 2>>& resolutions()
+      const noexcept {
+    return resolutions_;
+  }
+
+  [[nodiscard]] constexpr const std::optional<cluster::Options>& cluster()
+      const noexcept {
+    return cluster_;
+  }
+
+  inline void clusterOutput(const std::string& str) noexcept {
+    if (!str.empty()) {
+      clusterOutput_ = str;
+    }
+  }
+
+  [[nodiscard]] constexpr const std::optional<std::string>& clusterOutput()
+      const noexcept {
+    return clusterOutput_;
+  }
+
+  [[nodiscard]] constexpr const std::optional<sketch::Options>& approximate()
+      const noexcept {
+    return approximate_;
+  }
+
+  inline void neighborsOutput(const std::string& str) noexcept {
+    if (!str.empty()) {
+      neighborsOutput_ = str;
+    }
+  }
+
+  [[nodiscard]] constexpr const std::optional<std::string>& neighborsOutput()
+      const noexcept {
+    return neighborsOutput_;
+  }
+
   [[nodiscard]] static TopologyRegion fromSimple(
       const std::vector<std::string>& options);
 
@@ -97,20 +193,58 @@ class TopologyRegion {
   double stepSize_{DEFAULT_STEP_SIZE};
   std::optional<std::string> sampleOutput_{std::nullopt};
   std::optional<std::string> sampleInput_{std::nullopt};
+  std::optional<std::string> histogramOutput_{std::nullopt};
+  std::optional<std::string> histogramInput_{std::nullopt};
   std::optional<std::string> matrixOutput_{std::nullopt};
+  std::vector<histo::Metric> metrics_{histo::Metric::chi};
+  histo::Metric clusterMetric_{histo::Metric::chi};
+  bool binaryMatrix_{false};
   std::optional<std::array<int, 2>> bins_{std::nullopt};
+  std::vector<std::array<int, 2>> resolutions_;
+  std::optional<cluster::Options> cluster_{std::nullopt};
+  std::optional<std::string> clusterOutput_{std::nullopt};
+  std::optional<sketch::Options> approximate_{std::nullopt};
+  std::optional<std::string> neighborsOutput_{std::nullopt};
 
   void writeSampleOutput_(const std::vector<PathSample>& data, int index) const;
 
-  void writeMatrixOutput_(const std::vector<std::vector<double>>& matrix) const;
+  void writeMatrixOutput_(const std::vector<std::vector<double>>& matrix,
+                          const std::array<int, 2>& bins,
+                          histo::Metric metric, int numberOfThreads) const;
+
+  void writeClusterOutput_(const cluster::Result& clusters,
+                           const std::array<int, 2>& bins) const;
+
+  [[nodiscard]] std::string resolutionFile_(
+      const std::string& file, const std::array<int, 2>& bins) const;
+
+  static void writeBinaryMatrix_(const std::string& file,
+                                 const std::vector<std::vector<double>>& matrix,
+                                 const std::array<int, 2>& bins,
+                                 histo::Metric metric);
+
+  void writeNeighborsOutput_(const sketch::Graph& graph,
+                             const std::array<int, 2>& bins) const;
+
+  void analyze_(std::vector<std::vector<PathSample>> sampleResults,
+                int numberOfThreads) const;
+
+  void analyzeDistanceMatrix_(const histo::HistogramSet& histograms,
+                              int numberOfThreads) const;
+
+  void analyzeNeighborGraph_(const histo::HistogramSet& histograms,
+                             int numberOfThreads) const;
 
-  [[nodiscard]] std::vector<std::vector<PathSample>> loadSampleData_() const;
+  [[nodiscard]] std::vector<std::vector<PathSample>> loadSampleData_(
+      int numberOfThreads) const;
 
-  [[nodiscard]] std::vector<std::vector<double>> constructHistograms_(
+  [[nodiscard]] std::vector<histo::HistogramSet> constructHistograms_(
       const std::vector<std::vector<PathSample>>& sampleData) const;
 
-  [[nodiscard]] static std::vector<std::vector<double>> constructMatrix_(
-      const std::vector<std::vector<double>>& histograms);
+  [[nodiscard]] static std::vector<std::vector<std::vector<double>>>
+  constructMatrices_(const std::vector<std::vector<double>>& histograms,
+                     const std::vector<histo::Metric>& metrics,
+                     int numberOfThreads);
 };
 }  // namespace cpet
 #endif  // TOPOLOGYREGION_H
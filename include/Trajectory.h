@@ -0,0 +1,143 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+/* C++ STL HEADER FILES */
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Frame.h"
+#include "MappedFile.h"
+#include "Span.h"
+
+namespace cpet::trajectory {
+
+enum class Format { dcd, xtc };
+
+/* Binary coordinate trajectories are recognized by their extension */
+[[nodiscard]] std::optional<Format> formatOf(const std::string& file) noexcept;
+
+/* Random access reader over a memory mapped coordinate trajectory. Frames
+ * are located up front so any frame can be decoded without touching the
+ * others; read is const and safe to call concurrently. Coordinates are
+ * returned in Angstroms. */
+class Reader {
+ public:
+  explicit Reader(const std::string& file) : file_(file), mappedFile_(file) {}
+
+  Reader(const Reader&) = delete;
+  Reader(Reader&&) = delete;
+  Reader& operator=(const Reader&) = delete;
+  Reader& operator=(Reader&&) = delete;
+
+  virtual ~Reader() = default;
+
+  [[nodiscard]] virtual size_t numberOfFrames() const noexcept = 0;
+
+  [[nodiscard]] virtual size_t numberOfAtoms() const noexcept = 0;
+
+  /* coordinates must hold exactly numberOfAtoms elements */
+  virtual void read(size_t frame,
+                    util::Span<Eigen::Vector3d> coordinates) const = 0;
+
+  inline void read(const size_t frame,
+                   std::vector<Eigen::Vector3d>& coordinates) const {
+    coordinates.resize(numberOfAtoms());
+    read(frame, util::Span<Eigen::Vector3d>(coordinates));
+  }
+
+  [[nodiscard]] static std::unique_ptr<Reader> open(const std::string& file);
+
+ protected:
+  std::string file_;
+  util::MappedFile mappedFile_;
+
+  void checkRead_(size_t frame,
+                  util::Span<const Eigen::Vector3d> coordinates) const;
+};
+
+/* CHARMM/NAMD/X-PLOR DCD, either endianness. Every frame has the same size
+ * so seeking is a single multiplication. */
+class DCDReader final : public Reader {
+ public:
+  explicit DCDReader(const std::string& file);
+
+  [[nodiscard]] size_t numberOfFrames() const noexcept override {
+    return numberOfFrames_;
+  }
+
+  [[nodiscard]] size_t numberOfAtoms() const noexcept override {
+    return numberOfAtoms_;
+  }
+
+  using Reader::read;
+
+  void read(size_t frame,
+            util::Span<Eigen::Vector3d> coordinates) const override;
+
+ private:
+  bool swapped_{false};
+  size_t numberOfAtoms_{0};
+  size_t numberOfFrames_{0};
+  size_t firstFrame_{0};
+  size_t frameSize_{0};
+  size_t unitCellSize_{0};
+};
+
+/* GROMACS XTC with the xdrfile integer decompression. Frame offsets come
+ * from hopping over the compressed byte counts in each frame header. */
+class XTCReader final : public Reader {
+ public:
+  explicit XTCReader(const std::string& file);
+
+  [[nodiscard]] size_t numberOfFrames() const noexcept override {
+    return offsets_.size();
+  }
+
+  [[nodiscard]] size_t numberOfAtoms() const noexcept override {
+    return numberOfAtoms_;
+  }
+
+  using Reader::read;
+
+  void read(size_t frame,
+            util::Span<Eigen::Vector3d> coordinates) const override;
+
+ private:
+  size_t numberOfAtoms_{0};
+  std::vector<size_t> offsets_;
+};
+
+/* Frames selected by start and skip, with atom ids and charges taken from
+ * topology and coordinates from the trajectory file */
+[[nodiscard]] std::vector<Frame> loadFrames(const std::string& file,
+                                            const Frame& topology, int start,
+                                            int skip, int numberOfThreads);
+
+/* As above, for a reader that is already open */
+[[nodiscard]] std::vector<Frame> loadFrames(const Reader& reader,
+                                            const Frame& topology, int start,
+                                            int skip, int numberOfThreads);
+
+/* Streaming counterpart of loadFrames, see Frame::forEachFrameInFile */
+void forEachFrame(const std::string& file, const Frame& topology, int start,
+                  int skip, int numberOfThreads,
+                  const std::function<void(Frame)>& func);
+
+void forEachFrame(const Reader& reader, const Frame& topology, int start,
+                  int skip, int numberOfThreads,
+                  const std::function<void(Frame)>& func);
+
+/* First model of a pdb/pqr file, used for the ids and charges */
+[[nodiscard]] Frame loadTopology(const std::string& file);
+}  // namespace cpet::trajectory
+#endif  // TRAJECTORY_H
@@ -5,14 +5,27 @@
 #define UTILITIES_H
 
 /* C++ STL HEADER FILES */
+#include <array>
+#include <cctype>
+#include <charconv>
 #include <fstream>
 #include <functional>
+#include <optional>
 #include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#if __has_include(<fast_float/fast_float.h>)
+#include <fast_float/fast_float.h>
+#endif
 
 /* CPET HEADER FILES */
 #include "Exceptions.h"
@@ -71,6 +84,125 @@ std::vector<std::string> split(std::string_view str, char delim);
 
 [[nodiscard]] bool isDouble(std::string str) noexcept;
 
+/* The double at the start of [first, last), with the semantics of the
+ * floating point std::from_chars which g++ only has from 11 and libc++ not at
+ * all. fast_float does the parsing when it is available; otherwise strtod
+ * does, on a copy of the number with its '.' in the decimal point of the
+ * current C locale so that a program changing the locale cannot change what
+ * is read. */
+[[nodiscard]] inline std::from_chars_result fromChars(const char* first,
+                                                      const char* last,
+                                                      double& value) noexcept {
+#if __has_include(<fast_float/fast_float.h>)
+  const auto [ptr, ec] = fast_float::from_chars(first, last, value);
+  return {ptr, ec};
+#else
+  /* Longer than any double needs, the rest is left unparsed */
+  constexpr size_t MAX_LENGTH = 64;
+  std::array<char, MAX_LENGTH + 1> buffer{};
+  auto length = std::min(static_cast<size_t>(last - first), MAX_LENGTH);
+  /* from_chars reads neither the locale decimal point nor hexadecimal, and
+   * takes neither leading whitespace nor a plus sign */
+  const char point = *std::localeconv()->decimal_point;
+  length = static_cast<size_t>(
+      std::find_if(first, first + length,
+                   [point](const char c) {
+                     return (c == point && point != '.') || c == 'x' ||
+                            c == 'X';
+                   }) -
+      first);
+  if (length == 0 || *first == '+' ||
+      std::isspace(static_cast<unsigned char>(*first)) != 0) {
+    return {first, std::errc::invalid_argument};
+  }
+  std::replace_copy(first, first + length, buffer.begin(), '.', point);
+
+  char* end = nullptr;
+  errno = 0;
+  const double result = std::strtod(buffer.data(), &end);
+  if (end == buffer.data()) {
+    return {first, std::errc::invalid_argument};
+  }
+  const auto* ptr = first + (end - buffer.data());
+  if (errno == ERANGE) {
+    return {ptr, std::errc::result_out_of_range};
+  }
+  value = result;
+  return {ptr, std::errc()};
+#endif
+}
+
+/* Allocation free replacement for std::stod on a fixed width field; leading
+ * whitespace (and a plus sign) are skipped, trailing characters ignored */
+[[nodiscard]] inline double parseDouble(std::string_view str) {
+  const auto first = str.find_first_not_of(" \t");
+  if (first != std::string_view::npos) {
+    str.remove_prefix(first);
+    if (str.front() == '+') {
+      str.remove_prefix(1);
+    }
+  }
+
+  double result{0};
+  if (const auto [ptr, ec] =
+          fromChars(str.data(), str.data() + str.size(), result);
+      first == std::string_view::npos || ec != std::errc()) {
+    throw cpet::value_error("Could not parse number from: " +
+                            std::string(str));
+  }
+  return result;
+}
+
+/* Allocation free counterpart of isDouble followed by std::stod. Apart from
+ * surrounding whitespace the whole of str has to be the number. */
+[[nodiscard]] inline std::optional<double> toDouble(
+    std::string_view str) noexcept {
+  constexpr std::string_view whitespace = " \t\n\r\f\v";
+  const auto first = str.find_first_not_of(whitespace);
+  if (first == std::string_view::npos) {
+    return std::nullopt;
+  }
+  str = str.substr(first, str.find_last_not_of(whitespace) - first + 1);
+  /* fromChars also accepts inf and nan, a stream does not */
+  const size_t sign = (str.front() == '+' || str.front() == '-') ? 1 : 0;
+  if (str.size() == sign ||
+      (std::isdigit(static_cast<unsigned char>(str[sign])) == 0 &&
+       str[sign] != '.')) {
+    return std::nullopt;
+  }
+  if (str.front() == '+') {
+    str.remove_prefix(1);
+  }
+
+  double result{0};
+  if (const auto [ptr, ec] =
+          fromChars(str.data(), str.data() + str.size(), result);
+      ec != std::errc() || ptr != str.data() + str.size()) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+/* Splits str on delim into at most N views, skipping empty tokens like split
+ * does. Returns the number of tokens found. */
+template <size_t N>
+size_t tokenize(const std::string_view str, const char delim,
+                std::array<std::string_view, N>& tokens) noexcept {
+  size_t count = 0;
+  size_t start = 0;
+  while (count < N && start < str.size()) {
+    auto end = str.find(delim, start);
+    if (end == std::string_view::npos) {
+      end = str.size();
+    }
+    if (end != start) {
+      tokens[count++] = str.substr(start, end - start);
+    }
+    start = end + 1;
+  }
+  return count;
+}
+
 template <class InputIt, class UnaryPredicate>
 InputIt find_if_ex(const InputIt first, const InputIt last,
                    const UnaryPredicate p) {
@@ -5,14 +5,124 @@
 #define VOLUME_H
 
 /* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <random>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include <Eigen/Dense>
 
+/* CPET HEADER FILES */
+#include "Utilities.h"
+
 namespace cpet {
+
+/* Structured grid, the product of one list of coordinates per axis. Points
+ * are computed from their index when needed rather than stored, so a grid
+ * of n points takes memory proportional to the cube root of n. Indices run
+ * over z fastest, then y, then x. A filtered grid keeps the points it
+ * selected as runs of consecutive indices; the points of a convex volume
+ * form one run per (x, y) column, so its memory follows the number of
+ * columns rather than of points. */
+class Grid {
+ public:
+  Grid() = default;
+
+  explicit Grid(std::array<std::vector<double>, 3> axes) noexcept
+      : axes_(std::move(axes)) {}
+
+  [[nodiscard]] inline size_t size() const noexcept {
+    return runs_ ? selectedSize_ : structuredSize_();
+  }
+
+  [[nodiscard]] inline bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] inline Eigen::Vector3d operator[](
+      const size_t index) const noexcept {
+    return structuredPoint_(structuredIndex(index));
+  }
+
+  /* Index of point i among all the points of the axes */
+  [[nodiscard]] inline size_t structuredIndex(const size_t i) const noexcept {
+    if (!runs_) {
+      return i;
+    }
+    const auto run = std::prev(std::upper_bound(
+        runs_->begin(), runs_->end(), i,
+        [](const size_t j, const Run& r) { return j < r.offset; }));
+    return run->first + (i - run->offset);
+  }
+
+  /* The points for which keep is true, in the same order */
+  template <typename Predicate>
+  [[nodiscard]] Grid filter(const Predicate& keep) const {
+    Grid result(axes_);
+    auto& runs = result.runs_.emplace();
+    auto& count = result.selectedSize_;
+    for (size_t i = 0; i < size(); ++i) {
+      if (const auto point = (*this)[i]; !keep(point)) {
+        continue;
+      }
+      const auto structured = structuredIndex(i);
+      if (runs.empty() ||
+          runs.back().first + (count - runs.back().offset) != structured) {
+        runs.push_back({structured, count});
+      }
+      ++count;
+    }
+    runs.shrink_to_fit();
+    return result;
+  }
+
+  /* Runs of consecutive indices a filtered grid is stored as, 1 otherwise */
+  [[nodiscard]] inline size_t numberOfRuns() const noexcept {
+    return runs_ ? runs_->size() : 1;
+  }
+
+  [[nodiscard]] inline const std::array<std::vector<double>, 3> &axes()
+      const noexcept {
+    return axes_;
+  }
+
+  /* Every point, in index order */
+  [[nodiscard]] inline std::vector<Eigen::Vector3d> points() const {
+    std::vector<Eigen::Vector3d> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+      result.emplace_back((*this)[i]);
+    }
+    return result;
+  }
+
+ private:
+  [[nodiscard]] inline size_t structuredSize_() const noexcept {
+    return axes_[0].size() * axes_[1].size() * axes_[2].size();
+  }
+
+  [[nodiscard]] inline Eigen::Vector3d structuredPoint_(
+      const size_t index) const noexcept {
+    const auto zs = axes_[2].size();
+    const auto ys = axes_[1].size();
+    return {axes_[0][index / (ys * zs)], axes_[1][(index / zs) % ys],
+            axes_[2][index % zs]};
+  }
+
+  struct Run {
+    size_t first;   // Index among all the points of the first point
+    size_t offset;  // Number of selected points before the run
+  };
+
+  std::array<std::vector<double>, 3> axes_;
+  std::optional<std::vector<Run>> runs_;
+  size_t selectedSize_{0};
+};
+
 class Volume {
  public:
   Volume() = default;
@@ -40,13 +150,63 @@ class Volume {
 
   [[nodiscard]] virtual std::string type() const noexcept = 0;
 
-  [[nodiscard]] virtual std::vector<Eigen::Vector3d> partition(
-      const std::array<int, 3> &density) const noexcept = 0;
+  [[nodiscard]] virtual Grid grid(const std::array<int, 3> &density) const = 0;
+
+  [[nodiscard]] inline std::vector<Eigen::Vector3d> partition(
+      const std::array<int, 3> &density) const noexcept {
+    return grid(density).points();
+  }
 
   static std::unique_ptr<Volume> generateVolume(
       const std::vector<std::string> &options);
 
  protected:
+  /* Uniform over the ball of radius 1 around the origin, by a normally
+   * distributed direction and a radius distributed as the cube root */
+  [[nodiscard]] static inline Eigen::Vector3d randomUnitBallPoint_() noexcept {
+    auto& generator = *util::randomNumberGenerator();
+    std::normal_distribution<double> normal;
+    Eigen::Vector3d direction;
+    do {
+      direction = {normal(generator), normal(generator), normal(generator)};
+    } while (direction.squaredNorm() == 0.0);
+    std::uniform_real_distribution<double> uniform;
+    return std::cbrt(uniform(generator)) * direction.normalized();
+  }
+
+  /* Number of streamline steps, up to the longest chord of the volume */
+  [[nodiscard]] static inline int randomSteps_(
+      const double longestChord, const double stepSize) noexcept {
+    std::uniform_int_distribution<int> distribution(
+        1, std::max(static_cast<int>(longestChord / stepSize), 1));
+    return distribution(*util::randomNumberGenerator());
+  }
+
+  /* Grid over the box center_ +- halfSides, each side divided into density
+   * steps. Coordinates accumulate step by step along each axis, and the z
+   * step goes through a float, as they always have. */
+  [[nodiscard]] inline Grid boundingGrid_(
+      const std::array<double, 3> &halfSides,
+      const std::array<int, 3> &density) const {
+    /* Prevents division by zero later */
+    constexpr auto is_zero = [](const int dens) -> bool { return dens == 0; };
+    if (std::any_of(density.begin(), density.end(), is_zero)) {
+      return {};
+    }
+
+    const std::array<double, 3> steps = {
+        halfSides[0] / density[0], halfSides[1] / density[1],
+        static_cast<double>(static_cast<float>(halfSides[2] / density[2]))};
+    std::array<std::vector<double>, 3> axes;
+    for (size_t i = 0; i < axes.size(); ++i) {
+      const auto index = static_cast<long>(i);
+      for (double x = -1 * halfSides[i]; x <= halfSides[i]; x += steps[i]) {
+        axes[i].emplace_back(x + center_[index]);
+      }
+    }
+    return Grid{std::move(axes)};
+  }
+
   Eigen::Vector3d center_{0, 0, 0};
 };
 }  // namespace cpet
@@ -0,0 +1,43 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef VOLUMES_H
+#define VOLUMES_H
+
+/* C++ STL HEADER FILES */
+#include <utility>
+
+/* CPET HEADER FILES */
+#include "Box.h"
+#include "Cavity.h"
+#include "Cylinder.h"
+#include "Ellipsoid.h"
+#include "Sphere.h"
+#include "Volume.h"
+
+namespace cpet {
+
+/* Calls func with volume as its concrete shape. The shapes are final, so
+ * isInside and the like inline into whatever func loops over instead of
+ * being a virtual call per step. Other volumes are passed on as they are. */
+template <typename Func>
+decltype(auto) visitVolume(const Volume& volume, Func&& func) {
+  if (const auto* box = dynamic_cast<const Box*>(&volume)) {
+    return std::forward<Func>(func)(*box);
+  }
+  if (const auto* sphere = dynamic_cast<const Sphere*>(&volume)) {
+    return std::forward<Func>(func)(*sphere);
+  }
+  if (const auto* cylinder = dynamic_cast<const Cylinder*>(&volume)) {
+    return std::forward<Func>(func)(*cylinder);
+  }
+  if (const auto* ellipsoid = dynamic_cast<const Ellipsoid*>(&volume)) {
+    return std::forward<Func>(func)(*ellipsoid);
+  }
+  if (const auto* cavity = dynamic_cast<const Cavity*>(&volume)) {
+    return std::forward<Func>(func)(*cavity);
+  }
+  return std::forward<Func>(func)(volume);
+}
+}  // namespace cpet
+#endif  // VOLUMES_H
@@ -0,0 +1,13 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#ifndef CONFIG_H_IN
+#define CONFIG_H_IN
+
+constexpr const char* PROJECT_NAME = "CPET";
+constexpr const char* PROJECT_VER = "0.4.2";
+constexpr const char* PROJECT_VER_MAJOR = "0";
+constexpr const char* PROJECT_VER_MINOR = "4";
+constexpr const char* PTOJECT_VER_PATCH = "2";
+
+#endif // CONFIG_H_IN
@@ -3,6 +3,7 @@
 
 /* C++ STL HEADER FILES */
 #include <fstream>
+#include <optional>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include "spdlog/fmt/ostr.h"
@@ -16,19 +17,46 @@
 #include "System.h"
 #include "Utilities.h"
 #include "Constants.h"
+#include "Trajectory.h"
+#include "FrameCache.h"
+#include "MappedFile.h"
+#include "ModelIndex.h"
 
 namespace cpet {
 
+namespace {
+/* Single precision coordinates per slab, 12 MiB */
+constexpr size_t COMPACT_SLAB_SIZE = size_t{1} << 20;
+}  // namespace
+
 Calculator::Calculator(std::string proteinFile, const std::string& optionFile,
-                       std::string chargesFile, int nThreads)
+                       std::string chargesFile, int nThreads, bool stream,
+                       std::string topologyFile, bool cache,
+                       std::optional<uint64_t> maxMemory,
+                       bool singlePrecision)
     : proteinFile_(std::move(proteinFile)),
       option_(optionFile),
       chargeFile_(std::move(chargesFile)),
-      numberOfThreads_(nThreads) {
-  loadPointChargeTrajectory_();
+      numberOfThreads_(nThreads),
+      stream_(stream),
+      topologyFile_(std::move(topologyFile)),
+      cache_(cache),
+      singlePrecision_(singlePrecision) {
+  if (maxMemory) {
+    planMemory_(*maxMemory);
+  }
+  /* Streaming reads the trajectory during compute, one batch at a time */
+  if (!stream_) {
+    loadPointChargeTrajectory_();
+  }
 }
 
 void Calculator::compute() {
+  if (stream_) {
+    computeStreaming_();
+    return;
+  }
+
   if (!chargeFile_.empty()) {
     fixCharges_();
   }
@@ -57,7 +85,7 @@ void Calculator::computeTopology_() const {
 
 void Calculator::computeEField_() const {
   for (const auto& fieldLocations : option_.calculateFieldLocations()) {
-    fieldLocations.computeEFieldsWith(systems_);
+    fieldLocations.computeEFieldsWith(systems_, numberOfThreads_);
   }
 }
 
@@ -65,7 +93,185 @@ void Calculator::computeVolume_() const {
   std::for_each(
       option_.calculateEFieldVolumes().begin(),
       option_.calculateEFieldVolumes().end(),
-      [this](const auto& volume) { volume.computeVolumeWith(systems_); });
+      [this](const auto& volume) {
+        volume.computeVolumeWith(systems_, numberOfThreads_);
+      });
+}
+
+void Calculator::computeStreaming_() const {
+  std::optional<std::vector<double>> realCharges;
+  if (!chargeFile_.empty()) {
+    realCharges = loadChargesFile_();
+  }
+
+  /* Each block keeps only its per-frame results, frames are released as
+   * soon as every block has seen them */
+  std::vector<TopologyRegion::Stream> topologies;
+  topologies.reserve(option_.calculateEFieldTopology().size());
+  for (const auto& region : option_.calculateEFieldTopology()) {
+    topologies.emplace_back(region, numberOfThreads_);
+  }
+  std::vector<FieldLocations::Stream> fields;
+  fields.reserve(option_.calculateFieldLocations().size());
+  for (const auto& fieldLocations : option_.calculateFieldLocations()) {
+    fields.emplace_back(fieldLocations, numberOfThreads_);
+  }
+  std::vector<EFieldVolume::Stream> volumes;
+  volumes.reserve(option_.calculateEFieldVolumes().size());
+  for (const auto& volume : option_.calculateEFieldVolumes()) {
+    volumes.emplace_back(volume, numberOfThreads_);
+  }
+
+  /* Frames share their topology, so the charges only need replacing once */
+  std::shared_ptr<const Topology> original;
+  std::shared_ptr<const Topology> updated;
+  CompactArena arena(COMPACT_SLAB_SIZE);
+  forEachFrame_([&](Frame frame) {
+    if (singlePrecision_) {
+      frame.toSinglePrecision(arena);
+    }
+    if (realCharges) {
+      if (frame.sharedTopology() != original) {
+        original = frame.sharedTopology();
+        updated = original->withCharges(*realCharges);
+      }
+      frame.setTopology(updated);
+    }
+    System system{std::move(frame), option_};
+    system.transformToUserSpace();
+
+    for (auto& topology : topologies) {
+      topology.add(system);
+    }
+    for (auto& field : fields) {
+      field.add(system);
+    }
+    for (auto& volume : volumes) {
+      volume.add(system);
+    }
+  });
+
+  for (auto& topology : topologies) {
+    topology.finish();
+  }
+  for (const auto& field : fields) {
+    field.finish();
+  }
+  for (auto& volume : volumes) {
+    volume.finish();
+  }
+}
+
+void Calculator::loadPointChargeTrajectory_() {
+  /* Frames are converted batch by batch as they are read, so the double
+   * precision coordinates of the whole trajectory never exist at once */
+  if (singlePrecision_) {
+    CompactArena arena(COMPACT_SLAB_SIZE);
+    forEachFrame_([&](Frame frame) {
+      frame.toSinglePrecision(arena);
+      frameTrajectory_.push_back(std::move(frame));
+    });
+    return;
+  }
+
+  if (trajectory::formatOf(proteinFile_)) {
+    frameTrajectory_ = trajectory::loadFrames(
+        proteinFile_, loadTopology_(), option_.coordinatesStartIndex(),
+        option_.coordinatesStepSize(), numberOfThreads_);
+  } else if (cache_) {
+    frameTrajectory_ = cache::loadFrames(
+        proteinFile_, option_.coordinatesStartIndex(),
+        option_.coordinatesStepSize(), numberOfThreads_);
+  } else {
+    frameTrajectory_ = Frame::loadFramesFromFile(
+        proteinFile_, option_.coordinatesStartIndex(),
+        option_.coordinatesStepSize(), numberOfThreads_, true);
+  }
+}
+
+void Calculator::planMemory_(const uint64_t maxMemory) {
+  auto workload = workload_();
+  if (singlePrecision_) {
+    workload.coordinateBytes = sizeof(Eigen::Vector3f);
+  }
+  SPDLOG_DEBUG("Planning for {} frames of {} atoms", workload.numberOfFrames,
+               workload.numberOfAtoms);
+  const auto plan = memory::makePlan(option_, workload, maxMemory, stream_,
+                                     numberOfThreads_);
+  if (plan.stream != stream_) {
+    SPDLOG_WARN("Streaming frames to stay within --max-memory");
+  }
+  if (plan.numberOfThreads != numberOfThreads_) {
+    SPDLOG_WARN("Using {} threads to stay within --max-memory",
+                plan.numberOfThreads);
+  }
+  SPDLOG_INFO("[Memory] ==>> {} of {}", memory::formatSize(plan.footprint()),
+              memory::formatSize(maxMemory));
+  SPDLOG_DEBUG("Estimated memory use:\n{}", plan.describe());
+  stream_ = plan.stream;
+  numberOfThreads_ = plan.numberOfThreads;
+}
+
+memory::Workload Calculator::workload_() const {
+  const auto selected = [this](const size_t total) -> size_t {
+    const auto first =
+        static_cast<size_t>(std::max(option_.coordinatesStartIndex(), 0));
+    const auto step =
+        static_cast<size_t>(std::max(option_.coordinatesStepSize(), 1));
+    return (total > first) ? (total - first + step - 1) / step : 0;
+  };
+
+  if (trajectory::formatOf(proteinFile_)) {
+    const auto reader = trajectory::Reader::open(proteinFile_);
+    return {reader->numberOfAtoms(), selected(reader->numberOfFrames())};
+  }
+
+  /* The models are located through the index, which loading reuses, and
+   * the atoms of the first one are counted without parsing them */
+  const util::MappedFile mappedFile(proteinFile_);
+  const auto contents = mappedFile.view();
+  const auto models =
+      cache::selectModels(proteinFile_, contents,
+                          option_.coordinatesStartIndex(),
+                          option_.coordinatesStepSize());
+  size_t atoms = 0;
+  if (!models.empty()) {
+    const auto& first = models.front();
+    util::forEachLineOf(contents.substr(first.begin, first.end - first.begin),
+                        [&atoms](const std::string_view line) {
+                          if (util::startswith(line, "ATOM") ||
+                              util::startswith(line, "HETATM")) {
+                            ++atoms;
+                          }
+                        });
+  }
+  return {atoms, models.size()};
+}
+
+void Calculator::forEachFrame_(const std::function<void(Frame)>& func) const {
+  if (trajectory::formatOf(proteinFile_)) {
+    trajectory::forEachFrame(proteinFile_, loadTopology_(),
+                             option_.coordinatesStartIndex(),
+                             option_.coordinatesStepSize(), numberOfThreads_,
+                             func);
+  } else if (cache_) {
+    cache::forEachFrame(proteinFile_, option_.coordinatesStartIndex(),
+                        option_.coordinatesStepSize(), numberOfThreads_, func);
+  } else {
+    Frame::forEachFrameInFile(proteinFile_, option_.coordinatesStartIndex(),
+                              option_.coordinatesStepSize(), numberOfThreads_,
+                              func, true);
+  }
+}
+
+Frame Calculator::loadTopology_() const {
+  /* Binary trajectories only carry coordinates */
+  if (topologyFile_.empty()) {
+    throw cpet::invalid_option(
+        "DCD and XTC trajectories require a pdb/pqr topology file (-T) for "
+        "atom ids and charges");
+  }
+  return trajectory::loadTopology(topologyFile_);
 }
 
 std::vector<double> Calculator::loadChargesFile_() const {
@@ -98,8 +304,6 @@ std::vector<double> Calculator::loadChargesFile_() const {
 void Calculator::fixCharges_() {
   SPDLOG_DEBUG("Fixing charges in structure file with real charges...");
   auto realCharges = loadChargesFile_();
-  std::for_each(
-      frameTrajectory_.begin(), frameTrajectory_.end(),
-      [&realCharges](auto& frame) { frame.updateCharges(realCharges); });
+  Frame::updateCharges(frameTrajectory_, realCharges);
 }
 }  // namespace cpet
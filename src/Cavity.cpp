@@ -0,0 +1,253 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Cavity.h"
+
+/* C++ STL HEADER FILES */
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Utilities.h"
+
+namespace cpet {
+
+Cavity::Cavity(const double radius, std::vector<std::string> selections)
+    : radius_(radius),
+      selections_(std::move(selections)),
+      voxel_(radius / VOXELS_PER_RADIUS) {
+  if (!(radius_ > 0.0)) {
+    SPDLOG_ERROR("Invalid value for cavity probe radius {}", radius_);
+    throw cpet::value_error("Invalid value for cavity probe radius");
+  }
+  if (selections_.empty()) {
+    throw cpet::invalid_option(
+        "Invalid Option: Cavity requires at least one atom, residue or "
+        "position");
+  }
+
+  for (const auto& selection : selections_) {
+    const auto tokens = util::split(selection, ':');
+    if (tokens.size() == 2 && util::toDouble(tokens[1])) {
+      residues_.emplace_back(selection + ':');
+    } else if (AtomID::isVector(selection)) {
+      positions_.emplace_back(*AtomID(selection).position());
+    } else if (AtomID::validID(selection)) {
+      atoms_.emplace_back(selection);
+    } else {
+      throw cpet::invalid_option("Invalid Option: Cavity selection " +
+                                 selection +
+                                 " is not an atom, residue or position");
+    }
+  }
+
+  if (placed()) {
+    voxelize_(positions_);
+  }
+}
+
+Cavity::Cavity(const double radius, std::vector<Eigen::Vector3d> centers,
+               std::vector<std::string> selections)
+    : radius_(radius),
+      selections_(std::move(selections)),
+      positions_(std::move(centers)),
+      voxel_(radius / VOXELS_PER_RADIUS) {
+  voxelize_(positions_);
+}
+
+void Cavity::voxelize_(const std::vector<Eigen::Vector3d>& centers) {
+  Eigen::Vector3d lower =
+      Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+  Eigen::Vector3d upper = -lower;
+  for (const auto& center : centers) {
+    lower = lower.cwiseMin(center);
+    upper = upper.cwiseMax(center);
+  }
+  lower.array() -= radius_;
+  upper.array() += radius_;
+
+  origin_ = lower;
+  center_ = (lower + upper) / 2;
+  const Eigen::Vector3d extent = upper - lower;
+  maxDim_ = extent.maxCoeff() / 2;
+  diagonal_ = extent.norm();
+
+  for (size_t i = 0; i < 3; ++i) {
+    dimensions_[i] = std::max<size_t>(
+        static_cast<size_t>(std::ceil(extent[static_cast<long>(i)] / voxel_)),
+        1);
+  }
+  const auto total = dimensions_[0] * dimensions_[1] * dimensions_[2];
+  if (total > std::numeric_limits<uint32_t>::max()) {
+    throw cpet::value_error("Cavity needs too many voxels, " +
+                            std::to_string(total) +
+                            "; use a larger probe radius");
+  }
+  occupied_.assign(total, false);
+  interior_.assign(total, false);
+
+  /* Voxels whose nearest point lies within the probe radius of a sphere
+   * center, and whose farthest corner does too, searching only the voxels
+   * around each sphere */
+  const auto radiusSquared = radius_ * radius_;
+  const auto half = voxel_ / 2;
+  const auto reach = static_cast<long>(std::ceil(VOXELS_PER_RADIUS)) + 1;
+  for (const auto& center : centers) {
+    std::array<long, 3> first{};
+    std::array<long, 3> last{};
+    for (size_t i = 0; i < 3; ++i) {
+      const auto index = static_cast<long>(i);
+      const auto voxel =
+          static_cast<long>((center[index] - origin_[index]) / voxel_);
+      first[i] = std::max(voxel - reach, 0L);
+      last[i] = std::min(voxel + reach,
+                         static_cast<long>(dimensions_[i]) - 1);
+    }
+    for (auto x = first[0]; x <= last[0]; ++x) {
+      for (auto y = first[1]; y <= last[1]; ++y) {
+        for (auto z = first[2]; z <= last[2]; ++z) {
+          const Eigen::Vector3d voxelCenter =
+              origin_ +
+              voxel_ * Eigen::Vector3d(static_cast<double>(x) + 0.5,
+                                       static_cast<double>(y) + 0.5,
+                                       static_cast<double>(z) + 0.5);
+          const Eigen::Array3d offset = (voxelCenter - center).cwiseAbs();
+          const auto nearest = (offset - half).max(0.0).matrix().squaredNorm();
+          if (nearest > radiusSquared) {
+            continue;
+          }
+          const auto index = (static_cast<size_t>(x) * dimensions_[1] +
+                              static_cast<size_t>(y)) *
+                                 dimensions_[2] +
+                             static_cast<size_t>(z);
+          occupied_[index] = true;
+          if ((offset + half).matrix().squaredNorm() <= radiusSquared) {
+            interior_[index] = true;
+          }
+        }
+      }
+    }
+  }
+
+  voxels_.clear();
+  for (size_t i = 0; i < occupied_.size(); ++i) {
+    if (occupied_[i]) {
+      voxels_.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  SPDLOG_DEBUG("Cavity of {} spheres fills {} of {} voxels", centers.size(),
+               voxels_.size(), total);
+
+  /* Counting sort of the centers by cell */
+  for (size_t i = 0; i < 3; ++i) {
+    cells_[i] =
+        static_cast<size_t>(extent[static_cast<long>(i)] / radius_) + 1;
+  }
+  const auto cellIndex = [this](const std::array<long, 3>& cell) {
+    return (static_cast<size_t>(cell[0]) * cells_[1] +
+            static_cast<size_t>(cell[1])) *
+               cells_[2] +
+           static_cast<size_t>(cell[2]);
+  };
+  cellStarts_.assign(cells_[0] * cells_[1] * cells_[2] + 1, 0);
+  for (const auto& center : centers) {
+    ++cellStarts_[cellIndex(cellOf_(center)) + 1];
+  }
+  std::partial_sum(cellStarts_.begin(), cellStarts_.end(),
+                   cellStarts_.begin());
+  auto next = cellStarts_;
+  cellCenters_.resize(centers.size());
+  for (const auto& center : centers) {
+    cellCenters_[next[cellIndex(cellOf_(center))]++] = center;
+  }
+}
+
+std::array<long, 3> Cavity::cellOf_(
+    const Eigen::Vector3d& position) const noexcept {
+  std::array<long, 3> cell{};
+  for (size_t i = 0; i < 3; ++i) {
+    const auto index = static_cast<long>(i);
+    cell[i] = static_cast<long>(
+        std::floor((position[index] - origin_[index]) / radius_));
+  }
+  return cell;
+}
+
+bool Cavity::inSphere_(const Eigen::Vector3d& position) const noexcept {
+  const auto radiusSquared = radius_ * radius_;
+  const auto cell = cellOf_(position);
+  const auto inRange = [this](const long c, const size_t i) {
+    return c >= 0 && c < static_cast<long>(cells_[i]);
+  };
+  for (auto x = cell[0] - 1; x <= cell[0] + 1; ++x) {
+    for (auto y = cell[1] - 1; y <= cell[1] + 1; ++y) {
+      for (auto z = cell[2] - 1; z <= cell[2] + 1; ++z) {
+        if (!inRange(x, 0) || !inRange(y, 1) || !inRange(z, 2)) {
+          continue;
+        }
+        const auto index = (static_cast<size_t>(x) * cells_[1] +
+                            static_cast<size_t>(y)) *
+                               cells_[2] +
+                           static_cast<size_t>(z);
+        for (auto k = cellStarts_[index]; k < cellStarts_[index + 1]; ++k) {
+          if ((cellCenters_[k] - position).squaredNorm() <= radiusSquared) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+Eigen::Vector3d Cavity::randomPoint() const noexcept {
+  if (voxels_.empty()) {
+    return center_;
+  }
+  auto& generator = *util::randomNumberGenerator();
+  std::uniform_int_distribution<size_t> pick(0, voxels_.size() - 1);
+  std::uniform_real_distribution<double> uniform;
+
+  for (;;) {
+    const auto index = static_cast<size_t>(voxels_[pick(generator)]);
+    const auto z = index % dimensions_[2];
+    const auto y = (index / dimensions_[2]) % dimensions_[1];
+    const auto x = index / (dimensions_[2] * dimensions_[1]);
+    const Eigen::Vector3d point =
+        origin_ +
+        voxel_ * Eigen::Vector3d(static_cast<double>(x) + uniform(generator),
+                                 static_cast<double>(y) + uniform(generator),
+                                 static_cast<double>(z) + uniform(generator));
+    if (interior_[index] || inSphere_(point)) {
+      return point;
+    }
+  }
+}
+
+std::string Cavity::description() const noexcept {
+  std::string result = "Cavity: " + std::to_string(radius_);
+  for (const auto& selection : selections_) {
+    result += ' ' + selection;
+  }
+  return result;
+}
+
+int Cavity::randomDistance(const double stepSize) const noexcept {
+  return randomSteps_(diagonal_, stepSize);
+}
+
+Grid Cavity::grid(const std::array<int, 3>& density) const {
+  if (!placed()) {
+    throw cpet::invalid_option(
+        "Invalid Option: plot3d cavities must be given by positions, atoms "
+        "move between frames");
+  }
+  return boundingGrid_({maxDim_, maxDim_, maxDim_}, density)
+      .filter([this](const Eigen::Vector3d& p) { return isInside(p); });
+}
+}  // namespace cpet
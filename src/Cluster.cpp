@@ -0,0 +1,353 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Cluster.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "RAIIThread.h"
+#include "Utilities.h"
+
+namespace cpet::cluster {
+
+namespace {
+constexpr int MAX_SWAP_ITERATIONS = 100;
+constexpr double SWAP_TOLERANCE = 1e-12;
+
+struct Candidate {
+  double value{std::numeric_limits<double>::infinity()};
+  size_t medoidIndex{0};
+  size_t point{0};
+};
+
+[[nodiscard]] Candidate bestOf(const std::vector<Candidate>& candidates) {
+  return *std::min_element(
+      candidates.begin(), candidates.end(),
+      [](const auto& c1, const auto& c2) { return c1.value < c2.value; });
+}
+
+struct Assignment {
+  std::vector<size_t> nearest;
+  std::vector<double> nearestDistance;
+  std::vector<double> secondDistance;
+};
+
+[[nodiscard]] Assignment assign(
+    const std::vector<std::vector<double>>& distances,
+    const std::vector<size_t>& medoids) {
+  const auto n = distances.size();
+  constexpr double infinity = std::numeric_limits<double>::infinity();
+  Assignment result{std::vector<size_t>(n, 0), std::vector<double>(n, infinity),
+                    std::vector<double>(n, infinity)};
+
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t i = 0; i < medoids.size(); ++i) {
+      const double d = distances[j][medoids[i]];
+      if (d < result.nearestDistance[j]) {
+        result.secondDistance[j] = result.nearestDistance[j];
+        result.nearestDistance[j] = d;
+        result.nearest[j] = i;
+      } else if (d < result.secondDistance[j]) {
+        result.secondDistance[j] = d;
+      }
+    }
+  }
+  return result;
+}
+
+[[nodiscard]] std::vector<size_t> buildMedoids(
+    const std::vector<std::vector<double>>& distances,
+    const size_t numberOfClusters, const int numberOfThreads) {
+  const auto n = distances.size();
+  std::vector<size_t> medoids;
+  medoids.reserve(numberOfClusters);
+  std::vector<bool> isMedoid(n, false);
+  std::vector<double> nearestDistance(n,
+                                      std::numeric_limits<double>::infinity());
+
+  while (medoids.size() < numberOfClusters) {
+    std::vector<Candidate> threadBest(
+        static_cast<size_t>(std::max(numberOfThreads, 1)));
+
+    util::forEachChunk(
+        n, numberOfThreads,
+        [&](const size_t begin, const size_t end, const size_t t) {
+          Candidate best;
+          for (size_t c = begin; c < end; ++c) {
+            if (isMedoid[c]) {
+              continue;
+            }
+            /* Total cost if c were added; lower is a larger reduction */
+            double value = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+              value += std::min(distances[j][c], nearestDistance[j]);
+            }
+            if (value < best.value) {
+              best = {value, 0, c};
+            }
+          }
+          threadBest[t] = best;
+        });
+
+    const auto chosen = bestOf(threadBest).point;
+    medoids.emplace_back(chosen);
+    isMedoid[chosen] = true;
+    for (size_t j = 0; j < n; ++j) {
+      nearestDistance[j] = std::min(nearestDistance[j], distances[j][chosen]);
+    }
+  }
+  return medoids;
+}
+
+[[nodiscard]] std::vector<size_t> medoidsOf(
+    const std::vector<std::vector<double>>& distances,
+    const std::vector<size_t>& labels, const size_t numberOfClusters) {
+  std::vector<std::vector<size_t>> members(numberOfClusters);
+  for (size_t j = 0; j < labels.size(); ++j) {
+    members[labels[j]].emplace_back(j);
+  }
+
+  std::vector<size_t> medoids;
+  medoids.reserve(numberOfClusters);
+  for (const auto& cluster : members) {
+    const auto intraDistance = [&](const size_t m) {
+      return std::accumulate(cluster.begin(), cluster.end(), 0.0,
+                             [&](const double sum, const size_t j) {
+                               return sum + distances[m][j];
+                             });
+    };
+    medoids.emplace_back(*std::min_element(
+        cluster.begin(), cluster.end(), [&](const size_t m1, const size_t m2) {
+          return intraDistance(m1) < intraDistance(m2);
+        }));
+  }
+  return medoids;
+}
+
+[[nodiscard]] size_t findRoot(std::vector<size_t>& parents, size_t i) {
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+}  // namespace
+
+std::optional<Method> decodeMethod(const std::string& method) {
+  static const std::unordered_map<std::string, Method> methodHash = {
+      {"kmedoids", Method::kmedoids},
+      {"pam", Method::kmedoids},
+      {"average", Method::average},
+      {"hierarchical", Method::average},
+      {"upgma", Method::average}};
+
+  if (const auto iter = methodHash.find(util::tolower(method));
+      iter != methodHash.end()) {
+    return iter->second;
+  }
+  return std::nullopt;
+}
+
+std::string methodName(const Method method) noexcept {
+  switch (method) {
+    case Method::average:
+      return "average";
+    case Method::kmedoids:
+    default:
+      return "kmedoids";
+  }
+}
+
+Result kMedoids(const std::vector<std::vector<double>>& distances,
+                size_t numberOfClusters, const int numberOfThreads) {
+  const auto n = distances.size();
+  if (n == 0) {
+    return {};
+  }
+  numberOfClusters = std::clamp<size_t>(numberOfClusters, 1, n);
+
+  Result result;
+  result.medoids = buildMedoids(distances, numberOfClusters, numberOfThreads);
+
+  for (int iteration = 0; iteration < MAX_SWAP_ITERATIONS; ++iteration) {
+    const auto assignment = assign(distances, result.medoids);
+    std::vector<bool> isMedoid(n, false);
+    for (const auto& m : result.medoids) {
+      isMedoid[m] = true;
+    }
+
+    std::vector<Candidate> threadBest(
+        static_cast<size_t>(std::max(numberOfThreads, 1)));
+    util::forEachChunk(
+        n, numberOfThreads,
+        [&](const size_t begin, const size_t end, const size_t t) {
+          Candidate best;
+          std::vector<double> deltas(numberOfClusters);
+          for (size_t h = begin; h < end; ++h) {
+            if (isMedoid[h]) {
+              continue;
+            }
+            std::fill(deltas.begin(), deltas.end(), 0.0);
+            double shared = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+              const double d = distances[j][h];
+              const double dn = assignment.nearestDistance[j];
+              const auto nearest = assignment.nearest[j];
+              deltas[nearest] +=
+                  std::min(d, assignment.secondDistance[j]) - dn;
+              if (d < dn) {
+                shared += d - dn;
+                deltas[nearest] -= d - dn;
+              }
+            }
+            for (size_t i = 0; i < numberOfClusters; ++i) {
+              if (deltas[i] + shared < best.value) {
+                best = {deltas[i] + shared, i, h};
+              }
+            }
+          }
+          threadBest[t] = best;
+        });
+
+    const auto swap = bestOf(threadBest);
+    if (swap.value >= -SWAP_TOLERANCE) {
+      SPDLOG_DEBUG("k-medoids converged after {} swaps", iteration);
+      break;
+    }
+    result.medoids[swap.medoidIndex] = swap.point;
+  }
+
+  result.labels = assign(distances, result.medoids).nearest;
+  return result;
+}
+
+Result averageLinkage(std::vector<std::vector<double>> distances,
+                      size_t numberOfClusters) {
+  const auto n = distances.size();
+  if (n == 0) {
+    return {};
+  }
+  numberOfClusters = std::clamp<size_t>(numberOfClusters, 1, n);
+
+  for (const auto& row : distances) {
+    if (std::any_of(row.begin(), row.end(),
+                    [](const double value) { return std::isnan(value); })) {
+      throw cpet::value_error("Distance matrix for clustering contains NaN");
+    }
+  }
+
+  struct Merge {
+    double height;
+    size_t a;
+    size_t b;
+  };
+
+  /* Cluster distances are updated in the upper triangle while the lower
+   * triangle keeps the frame distances, so the matrix is never copied */
+  const auto linkage = [&distances](const size_t x, const size_t y) -> double& {
+    return (x < y) ? distances[x][y] : distances[y][x];
+  };
+  std::vector<size_t> sizes(n, 1);
+  std::vector<bool> active(n, true);
+  std::vector<Merge> merges;
+  merges.reserve(n - 1);
+  std::vector<size_t> chain;
+  chain.reserve(n);
+  std::vector<size_t> isolated;
+
+  size_t remaining = n;
+  while (remaining > 1) {
+    if (chain.empty()) {
+      chain.emplace_back(static_cast<size_t>(
+          std::find(active.begin(), active.end(), true) - active.begin()));
+    }
+    const auto a = chain.back();
+    const auto previous = (chain.size() > 1) ? chain[chain.size() - 2] : n;
+
+    /* Prefer the previous chain element on ties so reciprocal pairs close */
+    double best = (previous != n) ? linkage(a, previous)
+                                  : std::numeric_limits<double>::infinity();
+    size_t b = previous;
+    for (size_t c = 0; c < n; ++c) {
+      if (active[c] && c != a && linkage(a, c) < best) {
+        best = linkage(a, c);
+        b = c;
+      }
+    }
+
+    if (b == n) {
+      /* a is infinitely far from every other cluster and stays so as they
+       * merge, so it is set aside and joined last at an infinite height */
+      isolated.emplace_back(a);
+      active[a] = false;
+      --remaining;
+      chain.clear();
+      continue;
+    }
+    if (b != previous) {
+      chain.emplace_back(b);
+      continue;
+    }
+
+    chain.resize(chain.size() - 2);
+    merges.push_back({best, a, b});
+
+    /* Lance-Williams update for average linkage, a absorbs b */
+    const auto sizeA = static_cast<double>(sizes[a]);
+    const auto sizeB = static_cast<double>(sizes[b]);
+    for (size_t c = 0; c < n; ++c) {
+      if (active[c] && c != a && c != b) {
+        linkage(a, c) =
+            (sizeA * linkage(a, c) + sizeB * linkage(b, c)) / (sizeA + sizeB);
+      }
+    }
+    sizes[a] += sizes[b];
+    active[b] = false;
+    --remaining;
+  }
+
+  const auto last = static_cast<size_t>(
+      std::find(active.begin(), active.end(), true) - active.begin());
+  for (const auto& i : isolated) {
+    merges.push_back({std::numeric_limits<double>::infinity(), last, i});
+  }
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      distances[i][j] = distances[j][i];
+    }
+  }
+
+  /* Average linkage is reducible, so sorting the merges by height recovers
+   * the dendrogram; applying the lowest n - k merges cuts it at k clusters */
+  std::stable_sort(
+      merges.begin(), merges.end(),
+      [](const auto& m1, const auto& m2) { return m1.height < m2.height; });
+
+  std::vector<size_t> parents(n);
+  std::iota(parents.begin(), parents.end(), 0);
+  for (size_t i = 0; i < n - numberOfClusters; ++i) {
+    parents[findRoot(parents, merges[i].b)] = findRoot(parents, merges[i].a);
+  }
+
+  Result result;
+  result.labels.reserve(n);
+  std::unordered_map<size_t, size_t> rootToLabel;
+  for (size_t j = 0; j < n; ++j) {
+    const auto [iter, inserted] =
+        rootToLabel.try_emplace(findRoot(parents, j), rootToLabel.size());
+    result.labels.emplace_back(iter->second);
+  }
+  result.medoids = medoidsOf(distances, result.labels, numberOfClusters);
+  return result;
+}
+}  // namespace cpet::cluster
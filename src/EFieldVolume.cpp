@@ -3,6 +3,7 @@
 #include "EFieldVolume.h"
 
 /* C++ STL HEADER FILES */
+#include <charconv>
 #include <utility>
 #include <fstream>
 
@@ -12,11 +13,40 @@
 /* CPET HEADER FILES */
 #include "System.h"
 #include "Box.h"
+#include "TextWriter.h"
 
 namespace cpet {
 
 constexpr int DENSITY_PARAMETERS = 3;
 
+namespace {
+/* Adds the (size, 3) array whose row i is row(i) to npz, computing it in
+ * blocks of rows spread over the threads */
+template <typename Function>
+void addRows(util::NpzWriter& npz, const std::string& name, const size_t size,
+             const int numberOfThreads, const Function& row) {
+  constexpr size_t ROWS_PER_THREAD = size_t{1} << 14;
+  const auto rowsPerBlock =
+      ROWS_PER_THREAD * static_cast<size_t>(std::max(numberOfThreads, 1));
+  std::vector<double> block;
+  size_t first = 0;
+  npz.add(name, {size, 3}, [&]() -> util::Span<const double> {
+    const auto last = std::min(size, first + rowsPerBlock);
+    block.resize(3 * (last - first));
+    util::forEachChunk(last - first, numberOfThreads,
+                       [&](const size_t begin, const size_t end, size_t) {
+                         for (size_t i = begin; i < end; ++i) {
+                           const Eigen::Vector3d value = row(first + i);
+                           std::copy(value.begin(), value.end(),
+                                     block.begin() + 3 * static_cast<long>(i));
+                         }
+                       });
+    first = last;
+    return block;
+  });
+}
+}  // namespace
+
 EFieldVolume EFieldVolume::fromSimple(const std::vector<std::string>& options) {
   constexpr bool plot = true;
   constexpr size_t MIN_EFIELDVOLUME_OPTIONS = 5;
@@ -56,11 +86,13 @@ EFieldVolume EFieldVolume::fromBlock(const std::vector<std::string>& options) {
   std::optional<std::array<int, DENSITY_PARAMETERS>> density;
   bool plot = false;
   std::optional<std::string> output;
+  std::optional<octree::Refinement> refinement;
 
   constexpr const char* SHOW_PLOT_KEY = "show";
   constexpr const char* VOLUME_KEY = "volume";
   constexpr const char* DENSITY_KEY = "density";
   constexpr const char* OUTPUT_KEY = "output";
+  constexpr const char* ADAPTIVE_KEY = "adaptive";
 
   for (const auto& line : options) {
     const auto tokens = util::split(line, ' ');
@@ -96,6 +128,30 @@ EFieldVolume EFieldVolume::fromBlock(const std::vector<std::string>& options) {
                      to_int);
     } else if (key == OUTPUT_KEY) {
       output = *key_options.begin();
+    } else if (key == ADAPTIVE_KEY) {
+      if (key_options.size() < 2 || !util::isDouble(key_options[1])) {
+        throw cpet::invalid_option(
+            "Invalid Option: adaptive requires a depth and a tolerance");
+      }
+      /* The whole token has to be the depth, so 2.7 is not read as 2 */
+      const auto& depthToken = key_options[0];
+      const auto* depthEnd = depthToken.data() + depthToken.size();
+      int depth{0};
+      if (const auto [ptr, ec] =
+              std::from_chars(depthToken.data(), depthEnd, depth);
+          ec != std::errc() || ptr != depthEnd) {
+        throw cpet::invalid_option(
+            "Invalid Option: adaptive depth must be an integer");
+      }
+      refinement = {depth, std::stod(key_options[1])};
+      if (refinement->maxDepth < 0 ||
+          refinement->maxDepth > octree::MAX_DEPTH ||
+          !(refinement->tolerance > 0)) {
+        throw cpet::invalid_option(
+            "Invalid Option: adaptive depth must be 0 to " +
+            std::to_string(octree::MAX_DEPTH) +
+            " and its tolerance positive");
+      }
     } else {
       SPDLOG_WARN("Unknown key specified in block plot3d: {}", key);
     }
@@ -110,30 +166,99 @@ EFieldVolume EFieldVolume::fromBlock(const std::vector<std::string>& options) {
         "Invalid Option: No volume specified for 3d plot");
   }
 
-  return {std::move(vol), *density, plot, output};
+  return {std::move(vol), *density, plot, output, refinement};
+}
+
+void EFieldVolume::computeVolumeWith(const std::vector<System>& systems,
+                                     const int numberOfThreads) const {
+  Stream stream(*this, numberOfThreads);
+  for (const auto& system : systems) {
+    stream.add(system);
+  }
+  stream.finish();
+}
+
+EFieldVolume::Stream::Stream(const EFieldVolume& volume,
+                             const int numberOfThreads)
+    : volume_(volume), numberOfThreads_(numberOfThreads) {
+  if (!volume_.output_) {
+    return;
+  }
+
+  const auto& file = *volume_.output_;
+  /* One archive of the grid points and each frame's center, basis and field
+   * instead of the text file */
+  if (util::isNpzFile(file)) {
+    npz_.emplace(file);
+    if (!volume_.refinement_) {
+      addRows(*npz_, "points", volume_.grid_.size(), numberOfThreads_,
+              [this](const size_t i) { return volume_.grid_[i]; });
+    }
+    return;
+  }
+
+  outFile_.open(file, std::ios::out);
+  if (!outFile_.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+  outFile_ << '#' << volume_.details() << '\n';
 }
 
-void EFieldVolume::computeVolumeWith(const std::vector<System>& systems) const {
-  std::vector<std::vector<Eigen::Vector3d>> volumeResults;
-  volumeResults.reserve(systems.size());
-  const auto compute_volume_data = [this](const System& system) {
-    system.printCenterAndBasis();
-    auto tmpSystemResults = system.computeElectricFieldIn(*this);
-    if (showPlot_) {
-      plot_(tmpSystemResults);
+void EFieldVolume::Stream::add(const System& system) {
+  system.printCenterAndBasis();
+  const auto write = [&](const size_t size, const auto& point,
+                         const auto& field) {
+    if (npz_) {
+      volume_.writeFrame_(*npz_, index_, system, size, point, field,
+                          numberOfThreads_);
+    } else if (outFile_.is_open()) {
+      volume_.writeFrame_(outFile_, index_, system, size, point, field,
+                          numberOfThreads_);
     }
-    return tmpSystemResults;
   };
-  std::transform(systems.begin(), systems.end(),
-                 std::back_inserter(volumeResults), compute_volume_data);
-  if (output_) {
-    writeOutput_(systems, volumeResults);
+  const auto gridPoint = [this](const size_t i) { return volume_.grid_[i]; };
+
+  if (volume_.refinement_) {
+    const auto sample = octree::refine(
+        volume_.grid_, *volume_.refinement_,
+        [&system](const Eigen::Vector3d& p) {
+          return system.electricFieldAt(p);
+        },
+        numberOfThreads_);
+    SPDLOG_INFO("[Adaptive] ==>> {} points from a grid of {}",
+                sample.points.size(), volume_.grid_.size());
+    if (volume_.showPlot_) {
+      volume_.plot_(sample.points, sample.fields);
+    }
+    write(
+        sample.points.size(),
+        [&sample](const size_t i) { return sample.points[i]; },
+        [&sample](const size_t i) { return sample.fields[i]; });
+  } else if (volume_.showPlot_) {
+    const auto results = system.computeElectricFieldIn(volume_);
+    volume_.plot_(volume_.grid_.points(), results);
+    write(volume_.grid_.size(), gridPoint,
+          [&results](const size_t i) { return results[i]; });
+  } else {
+    write(volume_.grid_.size(), gridPoint, [&](const size_t i) {
+      return system.electricFieldAt(volume_.grid_[i]);
+    });
+  }
+  ++index_;
+}
+
+void EFieldVolume::Stream::finish() {
+  if (npz_) {
+    npz_->finish();
+    npz_.reset();
   }
 }
 
 void EFieldVolume::plot_(
+    const std::vector<Eigen::Vector3d>& points,
     const std::vector<Eigen::Vector3d>& electricField) const {
-  const auto numberOfPoints = points_.size();
+  const auto numberOfPoints = points.size();
   std::array<std::vector<double>, 3> rotatedPositions;
   std::for_each(rotatedPositions.begin(), rotatedPositions.end(),
                 [&numberOfPoints](auto& vec) { vec.reserve(numberOfPoints); });
@@ -146,7 +271,7 @@ void EFieldVolume::plot_(
         [&index](const Eigen::Vector3d& vector) -> double {
       return vector[static_cast<long>(index)];
     };
-    std::transform(points_.begin(), points_.end(),
+    std::transform(points.begin(), points.end(),
                    std::back_inserter(rotatedPositions.at(index)),
                    extract_index);
     std::transform(electricField.begin(), electricField.end(),
@@ -171,38 +296,48 @@ void EFieldVolume::plot_(
   matplot::show();
 }
 
-void EFieldVolume::writeOutput_(
-    const std::vector<System>& systems,
-    const std::vector<std::vector<Eigen::Vector3d>>& results) const {
-  if (!output_) {
-    return;
+template <typename Point, typename Field>
+void EFieldVolume::writeFrame_(util::NpzWriter& npz, const size_t index,
+                               const System& system, const size_t size,
+                               const Point& point, const Field& field,
+                               const int numberOfThreads) const {
+  const auto suffix = '_' + std::to_string(index);
+  const Eigen::Vector3d center = system.center();
+  /* Row major, as the basis is printed in the text output */
+  const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> basis =
+      system.basisMatrix();
+  npz.add("center" + suffix, {3}, {{center.data(), 3}});
+  npz.add("basis" + suffix, {3, 3}, {{basis.data(), 9}});
+  if (refinement_) {
+    addRows(npz, "points" + suffix, size, numberOfThreads, point);
   }
+  addRows(npz, "field" + suffix, size, numberOfThreads, field);
+}
 
-  const auto file = *output_;
-  std::ofstream outFile(file, std::ios::out);
-
-  const Eigen::IOFormat fmt(6, Eigen::DontAlignCols, " ", " ", "", "", "", "");
+template <typename Point, typename Field>
+void EFieldVolume::writeFrame_(std::ostream& outFile, const size_t index,
+                               const System& system, const size_t size,
+                               const Point& point, const Field& field,
+                               const int numberOfThreads) const {
   const Eigen::IOFormat commentFmt(6, 0, " ", "\n", "#", "");
 
-  if (outFile.is_open()) {
-    outFile << '#' << this->details() << '\n';
-
-    for (size_t i = 0; i < systems.size(); i++) {
-      outFile << "#Frame " << i << '\n';
-      outFile << "#Center: " << systems[i].center().transpose() << '\n';
-      outFile << "#Basis Matrix:\n"
-              << systems[i].basisMatrix().format(commentFmt) << '\n';
-
-      for (size_t j = 0; j < results[i].size(); j++) {
-        outFile << points_[j].transpose().format(fmt) << ' '
-                << results[i][j].transpose().format(fmt) << '\n';
-      }
-    }
-    outFile << std::flush;
-
-  } else {
-    SPDLOG_ERROR("Could not open file {}", file);
-    throw cpet::io_error("Could not open file " + file);
-  }
+  outFile << "#Frame " << index << '\n';
+  outFile << "#Center: " << system.center().transpose() << '\n';
+  outFile << "#Basis Matrix:\n"
+          << system.basisMatrix().format(commentFmt) << '\n';
+
+  /* Same text as Eigen::IOFormat(6, Eigen::DontAlignCols, " ", " ") */
+  util::writeRows(outFile, size, numberOfThreads,
+                  [&](util::TextBuffer& buffer, const size_t j) {
+                    const Eigen::Vector3d position = point(j);
+                    const Eigen::Vector3d value = field(j);
+                    for (const double x : {position[0], position[1],
+                                           position[2], value[0], value[1]}) {
+                      buffer.appendGeneral(x);
+                      buffer.append(' ');
+                    }
+                    buffer.appendGeneral(value[2]);
+                    buffer.append('\n');
+                  });
 }
 }  // namespace cpet
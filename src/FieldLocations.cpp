@@ -8,7 +8,9 @@
 #include <matplot/matplot.h>
 
 /* CPET HEADER FILES */
+#include "NumpyIO.h"
 #include "System.h"
+#include "TextWriter.h"
 
 namespace cpet {
 
@@ -56,47 +58,98 @@ FieldLocations FieldLocations::fromBlock(
   }
   return fl;
 }
-void FieldLocations::computeEFieldsWith(
-    const std::vector<System>& systems) const {
-  std::vector<std::vector<Eigen::Vector3d>> results;
-  for (const auto& point : locations_) {
-    SPDLOG_INFO("=~=~=~=~[Field at {}]=~=~=~=~", point.ID());
-    std::vector<Eigen::Vector3d> fieldTrajectoryAtPoint;
-
-    for (const auto& system : systems) {
-      Eigen::Vector3d location;
-      if (point.position()) {
-        location = *(point.position());
-      } else {
-        location = system.frame().find(point)->coordinate;
-      }
-
-      Eigen::Vector3d field = system.electricFieldAt(location);
+void FieldLocations::computeEFieldsWith(const std::vector<System>& systems,
+                                        const int numberOfThreads) const {
+  Stream stream(*this, numberOfThreads);
+  for (const auto& system : systems) {
+    stream.add(system);
+  }
+  stream.finish();
+}
+
+FieldLocations::Stream::Stream(const FieldLocations& fieldLocations,
+                               const int numberOfThreads)
+    : fieldLocations_(fieldLocations),
+      numberOfThreads_(numberOfThreads),
+      results_(fieldLocations.locations_.size()) {}
+
+void FieldLocations::Stream::add(const System& system) {
+  const auto& frame = system.frame();
+  if (frame.sharedTopology() != topology_) {
+    resolveIndices_(frame.sharedTopology());
+  }
+  for (size_t i = 0; i < fieldLocations_.locations_.size(); ++i) {
+    const auto& point = fieldLocations_.locations_[i];
+    Eigen::Vector3d location;
+    if (point.position()) {
+      location = *(point.position());
+    } else {
+      location = system.coordinate(indices_[i]);
+    }
+    results_[i].emplace_back(system.electricFieldAt(location));
+  }
+}
+
+void FieldLocations::Stream::resolveIndices_(
+    const std::shared_ptr<const Topology>& topology) {
+  const auto& locations = fieldLocations_.locations_;
+  indices_.assign(locations.size(), 0);
+  for (size_t i = 0; i < locations.size(); ++i) {
+    if (locations[i].position()) {
+      continue;
+    }
+    const auto index = topology->indexOf(locations[i]);
+    if (!index) {
+      throw cpet::value_not_found("Could not find element in container");
+    }
+    indices_[i] = *index;
+  }
+  topology_ = topology;
+}
+
+void FieldLocations::Stream::finish() const {
+  for (size_t i = 0; i < fieldLocations_.locations_.size(); ++i) {
+    SPDLOG_INFO("=~=~=~=~[Field at {}]=~=~=~=~",
+                fieldLocations_.locations_[i].ID());
+    for (const auto& field : results_[i]) {
       SPDLOG_INFO("{} [{}]", field.transpose(), field.norm());
-      fieldTrajectoryAtPoint.emplace_back(field);
     }
-    results.push_back(fieldTrajectoryAtPoint);
   }
-  if (output_) {
-    writeOutput_(results);
+  if (fieldLocations_.output_) {
+    fieldLocations_.writeOutput_(results_, numberOfThreads_);
   }
-  if (showPlots()) {
-    plot_(results);
+  if (fieldLocations_.showPlots()) {
+    fieldLocations_.plot_(results_);
   }
 }
+
 void FieldLocations::writeOutput_(
-    const std::vector<std::vector<Eigen::Vector3d>>& results) const {
+    const std::vector<std::vector<Eigen::Vector3d>>& results,
+    const int numberOfThreads) const {
   if (!output_) {
     return;
   }
 
+  /* (location, frame, 3) array instead of the text file */
+  if (util::isNpyFile(*output_)) {
+    const auto frames = results.empty() ? 0 : results.front().size();
+    util::Chunks data;
+    std::transform(results.begin(), results.end(), std::back_inserter(data),
+                   [](const auto& fields) { return util::flatView(fields); });
+    util::writeNpy(*output_, {results.size(), frames, 3}, data);
+    return;
+  }
+
   std::ofstream outFile(*output_, std::ios::out);
   if (outFile.is_open()) {
     for (size_t i = 0; i < results.size(); i++) {
       outFile << '#' << locations_[i].ID() << '\n';
-      for (const Eigen::Vector3d& field : results[i]) {
-        outFile << field.transpose() << '\n';
-      }
+      const auto& fields = results[i];
+      util::writeRows(outFile, fields.size(), numberOfThreads,
+                      [&](util::TextBuffer& buffer, const size_t j) {
+                        buffer.appendAligned(fields[j]);
+                        buffer.append('\n');
+                      });
     }
     outFile << std::flush;
   } else {
@@ -0,0 +1,282 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Frame.h"
+
+/* C++ STL HEADER FILES */
+#include <array>
+
+/* CPET HEADER FILES */
+#include "Instrumentation.h"
+#include "MappedFile.h"
+#include "ModelIndex.h"
+#include "RAIIThread.h"
+
+namespace cpet {
+
+namespace {
+constexpr std::string_view END_MODEL = "ENDMDL";
+
+[[nodiscard]] size_t findRecord(const std::string_view contents,
+                                const std::string_view record, size_t from) {
+  while ((from = contents.find(record, from)) != std::string_view::npos) {
+    if (from == 0 || contents[from - 1] == '\n') {
+      return from;
+    }
+    ++from;
+  }
+  return std::string_view::npos;
+}
+
+/* Coordinates of one model. While the model matches the reference topology
+ * they are written straight into storage reserved for it; ids, charges and
+ * coordinates are only kept separately once it differs. */
+struct ParsedModel {
+  CoordinateStorage storage;
+  size_t size{0};
+  std::vector<Eigen::Vector3d> coordinates;
+  std::vector<AtomID> ids;
+  std::vector<double> charges;
+  bool matchesReference{false};
+};
+
+[[nodiscard]] ParsedModel parseModel(const std::string_view contents,
+                                     const Frame::Model& model,
+                                     const constants::FileType ft,
+                                     const std::string& file,
+                                     const Topology* reference,
+                                     CoordinateStorage storage) {
+  ParsedModel result;
+  result.storage = std::move(storage);
+  result.matchesReference = (reference != nullptr);
+  const auto keepReference = [&](const size_t count) {
+    result.matchesReference = false;
+    const auto last = static_cast<long>(count);
+    result.ids.clear();
+    result.ids.reserve(count);
+    for (size_t j = 0; j < count; ++j) {
+      result.ids.emplace_back(reference->id(j));
+    }
+    result.charges.assign(reference->charges().begin(),
+                          reference->charges().begin() + last);
+    result.coordinates.assign(result.storage.get(),
+                              result.storage.get() + last);
+    result.storage.reset();
+  };
+
+  util::forEachLineOf(
+      contents.substr(model.begin, model.end - model.begin),
+      [&, lineNumber = model.firstLine](const std::string_view line) mutable {
+        if (util::startswith(line, "ATOM") ||
+            util::startswith(line, "HETATM")) {
+          try {
+            auto pc = Frame::parsePointCharge(line, ft);
+            const auto i = result.size++;
+            if (result.matchesReference &&
+                (i >= reference->size() || pc.charge != reference->charge(i) ||
+                 !reference->hasID(i, pc.id))) {
+              keepReference(i);
+            }
+            if (result.matchesReference) {
+              result.storage[static_cast<long>(i)] = pc.coordinate;
+            } else {
+              result.ids.emplace_back(std::move(pc.id));
+              result.charges.emplace_back(pc.charge);
+              result.coordinates.emplace_back(pc.coordinate);
+            }
+          } catch (const cpet::value_error& e) {
+            SPDLOG_ERROR("Could not parse line {} of {}", lineNumber, file);
+            throw cpet::value_error(file + ':' + std::to_string(lineNumber) +
+                                    ": " + e.what());
+          }
+        }
+        ++lineNumber;
+      });
+
+  if (result.matchesReference && result.size != reference->size()) {
+    keepReference(result.size);
+  }
+  return result;
+}
+
+[[nodiscard]] Frame toFrame(ParsedModel&& parsed,
+                            const std::shared_ptr<const Topology>& reference) {
+  if (parsed.matchesReference) {
+    return {reference, std::move(parsed.storage)};
+  }
+  return {std::make_shared<const Topology>(std::move(parsed.ids),
+                                           std::move(parsed.charges)),
+          std::move(parsed.coordinates)};
+}
+
+/* Parses models [begin, end) concurrently, preserving their order. Unless a
+ * reference topology is given, the first model is parsed on its own and
+ * becomes the reference that the others share when their atoms match. The
+ * coordinates of the matching models are one arena allocation. */
+[[nodiscard]] std::vector<Frame> parseModels(
+    const std::string_view contents, const std::vector<Frame::Model>& models,
+    size_t begin, const size_t end, const constants::FileType ft,
+    const std::string& file, const int numberOfThreads,
+    std::shared_ptr<const Topology>& reference) {
+  std::vector<Frame> frames;
+  frames.reserve(end - begin);
+  if (!reference && begin < end) {
+    frames.emplace_back(toFrame(
+        parseModel(contents, models[begin], ft, file, nullptr, nullptr),
+        nullptr));
+    if (frames.back().size() > 0) {
+      reference = frames.back().sharedTopology();
+    }
+    ++begin;
+  }
+
+  /* The atom count is known from the reference, so the storage of every
+   * model is reserved before parsing */
+  const size_t atoms = reference ? reference->size() : 0;
+  CoordinateArena arena((end - begin) * atoms);
+  std::vector<CoordinateStorage> storage(end - begin);
+  if (reference) {
+    std::generate(storage.begin(), storage.end(),
+                  [&] { return arena.allocate(atoms); });
+  }
+
+  std::vector<ParsedModel> parsed(end - begin);
+  util::forEachChunk(
+      parsed.size(), numberOfThreads,
+      [&](const size_t first, const size_t last, size_t) {
+        for (size_t i = first; i < last; ++i) {
+          parsed[i] = parseModel(contents, models[begin + i], ft, file,
+                                 reference.get(), std::move(storage[i]));
+        }
+      });
+  for (auto& model : parsed) {
+    frames.emplace_back(toFrame(std::move(model), reference));
+  }
+  return frames;
+}
+
+[[nodiscard]] constants::FileType fileTypeOf(const std::string& file) {
+  return util::endswith(file, ".pqr") ? constants::FileType::pqr
+                                      : constants::FileType::pdb;
+}
+}  // namespace
+
+std::vector<Frame> Frame::loadFramesFromFile(const std::string& file,
+                                             const int start, const int skip,
+                                             const int numberOfThreads,
+                                             const bool useIndex) {
+  Timer t;
+  SPDLOG_DEBUG("Loading point charge trajectory from {} ...", file);
+  const util::MappedFile mappedFile(file);
+  const auto contents = mappedFile.view();
+
+  const auto models = useIndex
+                           ? cache::selectModels(file, contents, start, skip)
+                           : indexModels(contents, start, skip);
+  SPDLOG_DEBUG("Parsing {} models with {} threads", models.size(),
+               numberOfThreads);
+
+  std::shared_ptr<const Topology> reference;
+  auto frames = parseModels(contents, models, 0, models.size(),
+                            fileTypeOf(file), file, numberOfThreads, reference);
+
+  std::vector<Frame> frameTrajectory;
+  frameTrajectory.reserve(models.size());
+  for (size_t i = 0; i < models.size(); ++i) {
+    /* Trailing records only form a frame when they contain atoms */
+    if (models[i].terminated || frames[i].size() > 0) {
+      frameTrajectory.emplace_back(std::move(frames[i]));
+    }
+  }
+  return frameTrajectory;
+}
+
+void Frame::forEachFrameInFile(const std::string& file, const int start,
+                               const int skip, const int numberOfThreads,
+                               const std::function<void(Frame)>& func,
+                               const bool useIndex) {
+  SPDLOG_DEBUG("Streaming point charge trajectory from {} ...", file);
+  const util::MappedFile mappedFile(file);
+  const auto contents = mappedFile.view();
+
+  const auto models = useIndex
+                           ? cache::selectModels(file, contents, start, skip)
+                           : indexModels(contents, start, skip);
+  std::shared_ptr<const Topology> reference;
+  const auto batchSize = static_cast<size_t>(std::max(numberOfThreads, 1));
+  for (size_t begin = 0; begin < models.size(); begin += batchSize) {
+    const auto end = std::min(models.size(), begin + batchSize);
+    auto frames = parseModels(contents, models, begin, end, fileTypeOf(file),
+                              file, numberOfThreads, reference);
+    for (size_t i = begin; i < end; ++i) {
+      auto& frame = frames[i - begin];
+      if (models[i].terminated || frame.size() > 0) {
+        func(std::move(frame));
+      }
+    }
+  }
+}
+
+std::vector<Frame::Model> Frame::indexModels(const std::string_view contents,
+                                             const int start, const int skip) {
+  std::vector<Model> models;
+  size_t position = 0;
+  size_t lineNumber = 1;
+  for (int structureIndex = 0; position < contents.size(); ++structureIndex) {
+    const auto endModel = findRecord(contents, END_MODEL, position);
+    const bool terminated = (endModel != std::string_view::npos);
+    if (isSelected(static_cast<size_t>(structureIndex), start, skip)) {
+      models.push_back({position, terminated ? endModel : contents.size(),
+                        lineNumber, terminated});
+    }
+    if (!terminated) {
+      break;
+    }
+
+    const auto newline = contents.find('\n', endModel);
+    const auto next =
+        (newline == std::string_view::npos) ? contents.size() : newline + 1;
+    lineNumber += static_cast<size_t>(
+        std::count(contents.begin() + static_cast<long>(position),
+                   contents.begin() + static_cast<long>(next), '\n'));
+    position = next;
+  }
+  return models;
+}
+
+PointCharge Frame::parsePointCharge(const std::string_view line,
+                                    const constants::FileType ft) {
+  if (ft == constants::FileType::pqr) {
+    std::array<std::string_view, constants::PQR_CHARGE_INDEX + 1> tokens;
+    if (util::tokenize(line, ' ', tokens) < tokens.size()) {
+      throw cpet::value_error("pqr line too short: " + std::string(line));
+    }
+    return {Eigen::Vector3d(
+                {util::parseDouble(tokens[constants::PQR_XCOORD_INDEX]),
+                 util::parseDouble(tokens[constants::PQR_YCOORD_INDEX]),
+                 util::parseDouble(tokens[constants::PQR_ZCOORD_INDEX])}),
+            util::parseDouble(tokens[constants::PQR_CHARGE_INDEX]),
+            AtomID::generateID(line, ft)};
+  }
+
+  /* Assume we have a pdb then */
+  const auto field = [&line](const size_t begin, const size_t width) {
+    if (begin >= line.size()) {
+      throw cpet::value_error("pdb line too short: " + std::string(line));
+    }
+    return line.substr(begin, width);
+  };
+  return {Eigen::Vector3d({util::parseDouble(field(
+                               constants::PDB_XCOORD_START,
+                               constants::PDB_COORD_WIDTH)),
+                           util::parseDouble(field(
+                               constants::PDB_YCOORD_START,
+                               constants::PDB_COORD_WIDTH)),
+                           util::parseDouble(field(
+                               constants::PDB_ZCOORD_START,
+                               constants::PDB_COORD_WIDTH))}),
+          util::parseDouble(
+              field(constants::PDB_CHARGE_START, constants::PDB_CHARGE_WIDTH)),
+          AtomID::generateID(line, ft)};
+}
+}  // namespace cpet
@@ -0,0 +1,366 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "FrameCache.h"
+
+/* C++ STL HEADER FILES */
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+/* SYSTEM HEADER FILES */
+#include <unistd.h>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "BinaryIO.h"
+#include "Exceptions.h"
+#include "MappedFile.h"
+
+namespace cpet::cache {
+
+namespace {
+constexpr std::array<char, 8> MAGIC = {'C', 'P', 'E', 'T',
+                                       'B', 'I', 'N', '\0'};
+/* Reads back as something else on a machine of the other endianness */
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t ALIGNMENT = sizeof(double);
+
+[[nodiscard]] constexpr size_t padded(const size_t size) noexcept {
+  return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/* 64-bit FNV-1a over whole words, with a shift to fold the high bits back
+ * down. Only used to notice changed files, it is not cryptographic. */
+[[nodiscard]] uint64_t hashOf(const std::string_view data) noexcept {
+  constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ULL;
+  constexpr uint64_t PRIME = 0x100000001b3ULL;
+  constexpr unsigned int FOLD = 29;
+
+  uint64_t hash = OFFSET_BASIS;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, sizeof(word));
+    hash = (hash ^ word) * PRIME;
+    hash ^= hash >> FOLD;
+  }
+  for (; i < data.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * PRIME;
+  }
+  return hash;
+}
+
+[[nodiscard]] std::unique_ptr<FrameCache> openCurrent(
+    const std::string& cacheFile, const std::string& source) {
+  if (!std::filesystem::exists(cacheFile)) {
+    return nullptr;
+  }
+  try {
+    auto cache = std::make_unique<FrameCache>(cacheFile);
+    if (cache->isCurrentFor(source)) {
+      cache->refreshSource(describe(source, false));
+      return cache;
+    }
+    SPDLOG_INFO("Frame cache {} is out of date, rebuilding it", cacheFile);
+  } catch (const cpet::exception& e) {
+    SPDLOG_WARN("Ignoring frame cache {}: {}", cacheFile, e.what());
+  }
+  return nullptr;
+}
+
+/* Parses every frame of the text trajectory, writing the cache as it goes,
+ * and hands the selected ones to func */
+void parseAndCache(const std::string& file, const int start, const int skip,
+                   const int numberOfThreads,
+                   const std::function<void(Frame)>& func) {
+  std::unique_ptr<Writer> writer;
+  try {
+    writer = std::make_unique<Writer>(cacheFileFor(file), describe(file));
+  } catch (const cpet::io_error& e) {
+    SPDLOG_WARN("Not caching {}: {}", file, e.what());
+  }
+
+  size_t index = 0;
+  Frame::forEachFrameInFile(
+      file, 0, 1, numberOfThreads,
+      [&](Frame frame) {
+        if (writer) {
+          writer->add(frame);
+        }
+        if (Frame::isSelected(index++, start, skip)) {
+          func(std::move(frame));
+        }
+      },
+      true);
+
+  if (writer) {
+    try {
+      if (writer->finish()) {
+        SPDLOG_INFO("Wrote frame cache {}", cacheFileFor(file));
+      }
+    } catch (const cpet::io_error& e) {
+      SPDLOG_WARN("Not caching {}: {}", file, e.what());
+    }
+  }
+}
+}  // namespace
+
+Source describe(const std::string& file, const bool withHash) {
+  std::error_code error;
+  const auto size = std::filesystem::file_size(file, error);
+  const auto modified = std::filesystem::last_write_time(file, error);
+  if (error) {
+    throw cpet::io_error("Could not stat file " + file);
+  }
+
+  /* In nanoseconds whatever the unit of the file clock */
+  Source source{size,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    modified.time_since_epoch())
+                    .count(),
+                0};
+  if (withHash) {
+    source.hash = hashOf(util::MappedFile(file).view());
+  }
+  return source;
+}
+
+FrameCache::FrameCache(const std::string& file) : Reader(file) {
+  const auto data = mappedFile_.view();
+  if (data.size() < sizeof(Header)) {
+    throw cpet::value_error(file_ + " is not a frame cache");
+  }
+  std::memcpy(&header_, data.data(), sizeof(Header));
+  if (header_.magic != MAGIC || header_.byteOrder != BYTE_ORDER_MARK) {
+    throw cpet::value_error(file_ + " is not a frame cache");
+  }
+  if (header_.version != VERSION) {
+    throw cpet::value_error("Unsupported frame cache version " +
+                            std::to_string(header_.version) + " in " + file_);
+  }
+
+  /* Rejects sizes that would overflow the layout computation below */
+  const auto atoms = header_.numberOfAtoms;
+  if (header_.idBytes > data.size() || atoms > data.size() ||
+      header_.numberOfFrames > data.size()) {
+    throw cpet::value_error("Corrupt frame cache " + file_);
+  }
+  const auto idBlock = padded(header_.idBytes);
+  if (data.size() != sizeof(Header) + idBlock +
+                         sizeof(double) * atoms *
+                             (1 + 3 * header_.numberOfFrames)) {
+    throw cpet::value_error("Truncated frame cache " + file_);
+  }
+
+  ids_ = data.substr(sizeof(Header), header_.idBytes);
+  charges_ = reinterpret_cast<const double*>(data.data() + sizeof(Header) +
+                                             idBlock);
+  frames_ = charges_ + atoms;
+}
+
+const double* FrameCache::coordinates(const size_t frame) const {
+  if (frame >= header_.numberOfFrames) {
+    throw cpet::value_error("Frame " + std::to_string(frame) +
+                            " is out of range for " + file_);
+  }
+  return frames_ + 3 * header_.numberOfAtoms * frame;
+}
+
+void FrameCache::read(const size_t frame,
+                      util::Span<Eigen::Vector3d> coordinates) const {
+  checkRead_(frame, coordinates);
+  const auto atoms = header_.numberOfAtoms;
+  const auto* x = this->coordinates(frame);
+  const auto* y = x + atoms;
+  const auto* z = y + atoms;
+
+  for (size_t i = 0; i < atoms; ++i) {
+    coordinates[i] = {x[i], y[i], z[i]};
+  }
+}
+
+Frame FrameCache::topology() const {
+  std::vector<Eigen::Vector3d> coordinates(header_.numberOfAtoms,
+                                           Eigen::Vector3d::Zero());
+  if (header_.numberOfFrames > 0) {
+    read(0, coordinates);
+  }
+
+  std::vector<AtomID> ids;
+  ids.reserve(header_.numberOfAtoms);
+  util::forEachLineOf(ids_, [&](const std::string_view id) {
+    if (ids.size() >= header_.numberOfAtoms) {
+      throw cpet::value_error("Too many atom ids in frame cache " + file_);
+    }
+    ids.emplace_back(std::string(id));
+  });
+  if (ids.size() != header_.numberOfAtoms) {
+    throw cpet::value_error("Too few atom ids in frame cache " + file_);
+  }
+  return {std::make_shared<const Topology>(
+              std::move(ids),
+              std::vector<double>(charges_, charges_ + header_.numberOfAtoms)),
+          std::move(coordinates)};
+}
+
+bool FrameCache::isCurrentFor(const std::string& source) const {
+  const auto current = describe(source, false);
+  if (current.size != header_.sourceSize) {
+    return false;
+  }
+  if (current.modified == header_.sourceModified) {
+    return true;
+  }
+  /* Same contents when the source was only touched */
+  return describe(source).hash == header_.sourceHash;
+}
+
+void FrameCache::refreshSource(const Source& current) {
+  if (current.modified == header_.sourceModified) {
+    return;
+  }
+  std::fstream cacheFile(file_,
+                         std::ios::binary | std::ios::in | std::ios::out);
+  if (cacheFile) {
+    cacheFile.seekp(offsetof(Header, sourceModified));
+    util::writeBinary(cacheFile, &current.modified, 1);
+  }
+  if (!cacheFile) {
+    SPDLOG_WARN("Could not refresh the source time in frame cache {}, the "
+                "source will be hashed on every load",
+                file_);
+    return;
+  }
+  header_.sourceModified = current.modified;
+}
+
+Writer::Writer(std::string file, const Source& source)
+    : file_(std::move(file)),
+      temporaryFile_(file_ + '.' + std::to_string(::getpid())) {
+  outFile_.open(temporaryFile_, std::ios::binary | std::ios::trunc);
+  if (!outFile_) {
+    throw cpet::io_error("Could not open file " + temporaryFile_);
+  }
+  header_.magic = MAGIC;
+  header_.version = VERSION;
+  header_.byteOrder = BYTE_ORDER_MARK;
+  header_.sourceSize = source.size;
+  header_.sourceModified = source.modified;
+  header_.sourceHash = source.hash;
+}
+
+Writer::~Writer() {
+  if (outFile_.is_open()) {
+    outFile_.close();
+    std::error_code error;
+    std::filesystem::remove(temporaryFile_, error);
+  }
+}
+
+void Writer::add(const Frame& frame) {
+  if (failed_) {
+    return;
+  }
+  if (header_.numberOfFrames == 0) {
+    writeHeader_(frame);
+  } else if (!matches_(frame)) {
+    SPDLOG_DEBUG("Frame {} differs in atoms or charges, not caching",
+                 header_.numberOfFrames);
+    failed_ = true;
+    return;
+  }
+
+  const auto atoms = header_.numberOfAtoms;
+  for (size_t i = 0; i < atoms; ++i) {
+    const auto coordinate = frame.coordinate(i);
+    buffer_[i] = coordinate[0];
+    buffer_[atoms + i] = coordinate[1];
+    buffer_[2 * atoms + i] = coordinate[2];
+  }
+  util::writeBinary(outFile_, buffer_.data(), buffer_.size());
+  ++header_.numberOfFrames;
+}
+
+bool Writer::finish() {
+  if (failed_ || header_.numberOfFrames == 0) {
+    outFile_.close();
+    std::error_code error;
+    std::filesystem::remove(temporaryFile_, error);
+    return false;
+  }
+
+  outFile_.seekp(offsetof(Header, numberOfFrames));
+  util::writeBinary(outFile_, &header_.numberOfFrames, 1);
+  outFile_.close();
+
+  std::error_code error;
+  if (!outFile_) {
+    std::filesystem::remove(temporaryFile_, error);
+    throw cpet::io_error("Could not write file " + temporaryFile_);
+  }
+  std::filesystem::rename(temporaryFile_, file_, error);
+  if (error) {
+    std::filesystem::remove(temporaryFile_, error);
+    throw cpet::io_error("Could not create file " + file_);
+  }
+  return true;
+}
+
+void Writer::writeHeader_(const Frame& frame) {
+  topology_ = frame.sharedTopology();
+  for (size_t i = 0; i < topology_->size(); ++i) {
+    header_.idBytes += topology_->id(i).ID().size() + 1;
+  }
+  header_.numberOfAtoms = topology_->size();
+  buffer_.resize(3 * topology_->size());
+
+  util::writeBinary(outFile_, &header_, 1);
+  for (size_t i = 0; i < topology_->size(); ++i) {
+    outFile_ << topology_->id(i).ID() << '\n';
+  }
+  const std::array<char, ALIGNMENT> zeros{};
+  util::writeBinary(outFile_, zeros.data(),
+                    padded(header_.idBytes) - header_.idBytes);
+  util::writeBinary(outFile_, topology_->charges().data(), topology_->size());
+}
+
+bool Writer::matches_(const Frame& frame) const {
+  /* Frames of one trajectory normally share their topology */
+  return frame.sharedTopology() == topology_ ||
+         frame.topology() == *topology_;
+}
+
+std::vector<Frame> loadFrames(const std::string& file, const int start,
+                              const int skip, const int numberOfThreads) {
+  const auto cacheFile = cacheFileFor(file);
+  if (const auto cache = openCurrent(cacheFile, file)) {
+    SPDLOG_DEBUG("Loading point charge trajectory from {} ...", cacheFile);
+    return trajectory::loadFrames(*cache, cache->topology(), start, skip,
+                                  numberOfThreads);
+  }
+
+  std::vector<Frame> frames;
+  parseAndCache(file, start, skip, numberOfThreads, [&frames](Frame frame) {
+    frames.emplace_back(std::move(frame));
+  });
+  return frames;
+}
+
+void forEachFrame(const std::string& file, const int start, const int skip,
+                  const int numberOfThreads,
+                  const std::function<void(Frame)>& func) {
+  const auto cacheFile = cacheFileFor(file);
+  if (const auto cache = openCurrent(cacheFile, file)) {
+    SPDLOG_DEBUG("Streaming point charge trajectory from {} ...", cacheFile);
+    trajectory::forEachFrame(*cache, cache->topology(), start, skip,
+                             numberOfThreads, func);
+    return;
+  }
+  parseAndCache(file, start, skip, numberOfThreads, func);
+}
+}  // namespace cpet::cache
@@ -1,21 +1,352 @@
 // Copyright(c) 2020-Present, Matthew R. Hennefarth
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 
+#include "Histogram2D.h"
+
+/* C++ STL HEADER FILES */
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
 #include <spdlog/spdlog.h>
 
-#include "Histogram2D.h"
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "BinaryIO.h"
+#include "NumpyIO.h"
+#include "Utilities.h"
 
 namespace cpet::histo {
+
+namespace {
+/* Binary layout (native endianness):
+ *   char[8]  magic "CPETHIST"
+ *   uint32   version
+ *   int32[2] bins
+ *   f64[2]   xlim
+ *   f64[2]   ylim
+ *   uint64   number of histograms
+ *   uint64   number of elements per histogram
+ *   f64[]    histograms, one after another */
+constexpr std::array<char, 8> HISTOGRAM_MAGIC = {'C', 'P', 'E', 'T',
+                                                 'H', 'I', 'S', 'T'};
+constexpr uint32_t HISTOGRAM_VERSION = 1;
+
+/* histograms is (number of histograms, y bins, x bins), xlim and ylim are
+ * (2,) */
+void writeNpzHistograms(const std::string& file, const HistogramSet& set) {
+  const auto histogramSize = static_cast<size_t>(set.bins[0]) *
+                             static_cast<size_t>(set.bins[1]);
+  util::Chunks data;
+  for (const auto& histogram : set.histograms) {
+    if (histogram.size() != histogramSize) {
+      throw cpet::value_error("Inconsistent histogram sizes in " + file);
+    }
+    data.emplace_back(histogram);
+  }
+
+  util::NpzWriter npz(file);
+  npz.add("histograms",
+          {set.histograms.size(), static_cast<size_t>(set.bins[1]),
+           static_cast<size_t>(set.bins[0])},
+          data);
+  npz.add("xlim", {2}, {set.xlim});
+  npz.add("ylim", {2}, {set.ylim});
+  npz.finish();
+}
+
+[[nodiscard]] constexpr size_t slot(const Metric metric) noexcept {
+  return static_cast<size_t>(metric);
+}
+
+[[nodiscard]] constexpr unsigned int metricBit(const Metric metric) noexcept {
+  return 1U << slot(metric);
+}
+
+/* Adds one bin's contribution to the raw sums of the metrics in Mask. The
+ * metric selection is a compile time constant so that each instantiation only
+ * carries the arithmetic it needs. */
+template <unsigned int Mask>
+inline void accumulate(const double f, const double g, double& chiSum,
+                       double& hellingerSum, double& jensenShannonSum,
+                       double& l1Sum) noexcept {
+  const auto diff = f - g;
+  const auto sum = f + g;
+
+  if constexpr ((Mask & metricBit(Metric::chi)) != 0) {
+    chiSum += sum > 0.0001 ? (diff * diff) / sum : 0.0;
+  }
+  if constexpr ((Mask & metricBit(Metric::hellinger)) != 0) {
+    const auto rootDiff = std::sqrt(f) - std::sqrt(g);
+    hellingerSum += rootDiff * rootDiff;
+  }
+  if constexpr ((Mask & metricBit(Metric::jensenShannon)) != 0) {
+    /* 0 log 0 is taken as 0 */
+    if (f > 0.0) {
+      jensenShannonSum += f * std::log2(2.0 * f / sum);
+    }
+    if (g > 0.0) {
+      jensenShannonSum += g * std::log2(2.0 * g / sum);
+    }
+  }
+  if constexpr ((Mask & metricBit(Metric::l1)) != 0) {
+    l1Sum += std::abs(diff);
+  }
+}
+
+/* Bins are summed in SWEEP_LANES independent partial sums so the compiler may
+ * vectorize the cheap metrics without reassociating a single sum */
+constexpr size_t SWEEP_LANES = 4;
+
+template <unsigned int Mask>
+void sweep(const double* f, const double* g, const size_t size,
+           Distances& sums) noexcept {
+  std::array<double, SWEEP_LANES> chi{};
+  std::array<double, SWEEP_LANES> hellinger{};
+  std::array<double, SWEEP_LANES> jensenShannon{};
+  std::array<double, SWEEP_LANES> l1{};
+
+  const size_t blocked = size - size % SWEEP_LANES;
+  for (size_t i = 0; i < blocked; i += SWEEP_LANES) {
+    for (size_t l = 0; l < SWEEP_LANES; ++l) {
+      accumulate<Mask>(f[i + l], g[i + l], chi[l], hellinger[l],
+                       jensenShannon[l], l1[l]);
+    }
+  }
+  for (size_t i = blocked; i < size; ++i) {
+    accumulate<Mask>(f[i], g[i], chi[0], hellinger[0], jensenShannon[0],
+                     l1[0]);
+  }
+
+  const auto total = [](const std::array<double, SWEEP_LANES>& lanes) {
+    return std::accumulate(lanes.begin(), lanes.end(), 0.0);
+  };
+  sums[slot(Metric::chi)] = total(chi);
+  sums[slot(Metric::hellinger)] = total(hellinger);
+  sums[slot(Metric::jensenShannon)] = total(jensenShannon);
+  sums[slot(Metric::l1)] = total(l1);
+}
+
+/* Maps a runtime metric mask onto its sweep instantiation */
+template <unsigned int Mask = 0>
+void sweepFor(const unsigned int mask, const double* f, const double* g,
+              const size_t size, Distances& sums) noexcept {
+  if constexpr (Mask < (1U << METRIC_COUNT)) {
+    if (mask == Mask) {
+      sweep<Mask>(f, g, size, sums);
+    } else {
+      sweepFor<Mask + 1>(mask, f, g, size, sums);
+    }
+  }
+}
+}  // namespace
+
+void writeHistograms(const std::string& file, const HistogramSet& set) {
+  SPDLOG_DEBUG("Writing histograms to {}", file);
+  if (util::isNpzFile(file)) {
+    writeNpzHistograms(file, set);
+    return;
+  }
+  std::ofstream outFile(file, std::ios::out | std::ios::binary);
+  if (!outFile.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+
+  const uint64_t numberOfHistograms = set.histograms.size();
+  const uint64_t histogramSize =
+      set.histograms.empty() ? 0 : set.histograms.front().size();
+  const std::array<int32_t, 2> bins = {set.bins[0], set.bins[1]};
+
+  util::writeBinary(outFile, HISTOGRAM_MAGIC.data(), HISTOGRAM_MAGIC.size());
+  util::writeBinary(outFile, &HISTOGRAM_VERSION, 1);
+  util::writeBinary(outFile, bins.data(), bins.size());
+  util::writeBinary(outFile, set.xlim.data(), set.xlim.size());
+  util::writeBinary(outFile, set.ylim.data(), set.ylim.size());
+  util::writeBinary(outFile, &numberOfHistograms, 1);
+  util::writeBinary(outFile, &histogramSize, 1);
+  for (const auto& histogram : set.histograms) {
+    if (histogram.size() != histogramSize) {
+      throw cpet::value_error("Inconsistent histogram sizes in " + file);
+    }
+    util::writeBinary(outFile, histogram.data(), histogram.size());
+  }
+  outFile << std::flush;
+}
+
+HistogramSet readHistograms(const std::string& file) {
+  SPDLOG_DEBUG("Reading histograms from {}", file);
+  std::ifstream inFile(file, std::ios::in | std::ios::binary);
+  if (!inFile.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+
+  std::array<char, 8> magic{};
+  util::readBinary(inFile, magic.data(), magic.size(), file);
+  if (magic != HISTOGRAM_MAGIC) {
+    throw cpet::value_error("Not a cpet histogram file: " + file);
+  }
+  uint32_t version = 0;
+  util::readBinary(inFile, &version, 1, file);
+  if (version != HISTOGRAM_VERSION) {
+    throw cpet::value_error("Unsupported histogram file version in " + file);
+  }
+
+  HistogramSet result{};
+  std::array<int32_t, 2> bins{};
+  util::readBinary(inFile, bins.data(), bins.size(), file);
+  result.bins = {bins[0], bins[1]};
+  util::readBinary(inFile, result.xlim.data(), result.xlim.size(), file);
+  util::readBinary(inFile, result.ylim.data(), result.ylim.size(), file);
+
+  uint64_t numberOfHistograms = 0;
+  uint64_t histogramSize = 0;
+  util::readBinary(inFile, &numberOfHistograms, 1, file);
+  util::readBinary(inFile, &histogramSize, 1, file);
+  if (bins[0] <= 0 || bins[1] <= 0) {
+    throw cpet::value_error("Invalid histogram bins in " + file);
+  }
+  if (histogramSize !=
+      static_cast<uint64_t>(bins[0]) * static_cast<uint64_t>(bins[1])) {
+    throw cpet::value_error("Histogram size does not match bins in " + file);
+  }
+
+  /* A corrupt count must not allocate more than the file could hold */
+  std::error_code error;
+  const auto fileSize = std::filesystem::file_size(file, error);
+  const auto offset = static_cast<uint64_t>(inFile.tellg());
+  if (error || offset > fileSize) {
+    throw cpet::io_error("Could not stat file " + file);
+  }
+  const auto remaining = (fileSize - offset) / sizeof(double);
+  if (histogramSize > remaining ||
+      numberOfHistograms > remaining / histogramSize) {
+    throw cpet::value_error("Histogram count exceeds the size of " + file);
+  }
+
+  result.histograms.resize(numberOfHistograms,
+                           std::vector<double>(histogramSize));
+  for (auto& histogram : result.histograms) {
+    util::readBinary(inFile, histogram.data(), histogram.size(), file);
+  }
+  return result;
+}
+std::optional<Metric> decodeMetric(const std::string& metric) {
+  static const std::unordered_map<std::string, Metric> metricHash = {
+      {"chi", Metric::chi},
+      {"hellinger", Metric::hellinger},
+      {"js", Metric::jensenShannon},
+      {"jensenshannon", Metric::jensenShannon},
+      {"l1", Metric::l1}};
+
+  if (const auto iter = metricHash.find(util::tolower(metric));
+      iter != metricHash.end()) {
+    return iter->second;
+  }
+  return std::nullopt;
+}
+
+std::string metricName(const Metric metric) noexcept {
+  switch (metric) {
+    case Metric::hellinger:
+      return "hellinger";
+    case Metric::jensenShannon:
+      return "js";
+    case Metric::l1:
+      return "l1";
+    case Metric::chi:
+    default:
+      return "chi";
+  }
+}
+
+void distances(const std::vector<double>& normHist1,
+               const std::vector<double>& normHist2,
+               const std::vector<Metric>& metrics, Distances& result) noexcept {
+  assert(metrics.size() <= METRIC_COUNT);
+  unsigned int mask = 0;
+  for (const auto& metric : metrics) {
+    mask |= metricBit(metric);
+  }
+
+  Distances sums{};
+  const size_t min_index = std::min(normHist1.size(), normHist2.size());
+  sweepFor(mask, normHist1.data(), normHist2.data(), min_index, sums);
+
+  const auto count = std::min(metrics.size(), METRIC_COUNT);
+  for (size_t m = 0; m < count; ++m) {
+    switch (metrics[m]) {
+      case Metric::hellinger:
+        result[m] = std::sqrt(sums[slot(Metric::hellinger)] / 2.0);
+        break;
+      case Metric::jensenShannon:
+        /* Square root of the base 2 divergence, bounded by [0, 1] */
+        result[m] = std::sqrt(
+            std::max(sums[slot(Metric::jensenShannon)] / 2.0, 0.0));
+        break;
+      case Metric::l1:
+        result[m] = sums[slot(Metric::l1)];
+        break;
+      case Metric::chi:
+      default:
+        result[m] = sums[slot(Metric::chi)] / 2.0;
+    }
+  }
+}
+
 std::vector<std::vector<int>> construct2DHistogram(
     const std::vector<double>& x, const std::vector<double>& y,
     const std::array<int, 2>& bins, const std::array<double, 2>& xlim,
     const std::array<double, 2>& ylim) noexcept {
-  std::vector<std::vector<int>> result(
-      static_cast<size_t>(bins[1]),
-      std::vector<int>(static_cast<size_t>(bins[0]), 0));
+  return std::move(construct2DHistograms(x, y, {bins}, xlim, ylim).front());
+}
 
-  auto xEdges = constructEdges(xlim[0], xlim[1], bins[0]);
-  auto yEdges = constructEdges(ylim[0], ylim[1], bins[1]);
+std::vector<std::vector<std::vector<int>>> construct2DHistograms(
+    const std::vector<double>& x, const std::vector<double>& y,
+    const std::vector<std::array<int, 2>>& bins,
+    const std::array<double, 2>& xlim,
+    const std::array<double, 2>& ylim) noexcept {
+  std::vector<std::vector<std::vector<int>>> result;
+  result.reserve(bins.size());
+  for (const auto& b : bins) {
+    result.emplace_back(static_cast<size_t>(b[1]),
+                        std::vector<int>(static_cast<size_t>(b[0]), 0));
+  }
+
+  /* source[i] is the index of the finer resolution resolution i is summed
+   * from, or i itself if it has to be binned directly */
+  std::vector<size_t> source(bins.size());
+  for (size_t i = 0; i < bins.size(); ++i) {
+    source[i] = i;
+    for (size_t j = 0; j < bins.size(); ++j) {
+      if (bins[j] != bins[i] && nestsByPowerOfTwo(bins[j][0], bins[i][0]) &&
+          nestsByPowerOfTwo(bins[j][1], bins[i][1]) &&
+          (source[i] == i || bins[j][0] > bins[source[i]][0] ||
+           bins[j][1] > bins[source[i]][1])) {
+        source[i] = j;
+      }
+    }
+  }
+  /* Follow chains so every derived resolution sums a directly binned one */
+  for (size_t i = 0; i < bins.size(); ++i) {
+    while (source[source[i]] != source[i]) {
+      source[i] = source[source[i]];
+    }
+  }
+
+  std::vector<size_t> direct;
+  std::vector<std::vector<double>> xEdges;
+  std::vector<std::vector<double>> yEdges;
+  for (size_t i = 0; i < bins.size(); ++i) {
+    if (source[i] == i) {
+      direct.emplace_back(i);
+      xEdges.emplace_back(constructEdges(xlim[0], xlim[1], bins[i][0]));
+      yEdges.emplace_back(constructEdges(ylim[0], ylim[1], bins[i][1]));
+    }
+  }
 
   const auto numberOfElements = std::min(x.size(), y.size());
 
@@ -34,18 +365,35 @@ std::vector<std::vector<int>> construct2DHistogram(
       continue;
     }
 
-    const auto xEdge =
-        std::find_if(xEdges.begin(), xEdges.end(),
-                     [&](const auto& edge) { return x_value <= edge; });
-    assert(xEdge != xEdges.end());
-    const auto yEdge =
-        std::find_if(yEdges.begin(), yEdges.end(),
-                     [&](const auto& edge) { return y_value <= edge; });
-    assert(yEdge != yEdges.end());
+    for (size_t d = 0; d < direct.size(); ++d) {
+      /* First edge that is >= the value */
+      const auto xEdge =
+          std::lower_bound(xEdges[d].begin(), xEdges[d].end(), x_value);
+      assert(xEdge != xEdges[d].end());
+      const auto yEdge =
+          std::lower_bound(yEdges[d].begin(), yEdges[d].end(), y_value);
+      assert(yEdge != yEdges[d].end());
 
-    const auto xIndex = static_cast<size_t>(xEdge - xEdges.begin());
-    const auto yIndex = static_cast<size_t>(yEdge - yEdges.begin());
-    ++result[yIndex][xIndex];
+      const auto xIndex = static_cast<size_t>(xEdge - xEdges[d].begin());
+      const auto yIndex = static_cast<size_t>(yEdge - yEdges[d].begin());
+      ++result[direct[d]][yIndex][xIndex];
+    }
+  }
+
+  for (size_t i = 0; i < bins.size(); ++i) {
+    if (source[i] == i) {
+      continue;
+    }
+    const auto& fine = result[source[i]];
+    const auto xFactor =
+        static_cast<size_t>(bins[source[i]][0] / bins[i][0]);
+    const auto yFactor =
+        static_cast<size_t>(bins[source[i]][1] / bins[i][1]);
+    for (size_t yIndex = 0; yIndex < fine.size(); ++yIndex) {
+      for (size_t xIndex = 0; xIndex < fine[yIndex].size(); ++xIndex) {
+        result[i][yIndex / yFactor][xIndex / xFactor] += fine[yIndex][xIndex];
+      }
+    }
   }
 
   return result;
@@ -0,0 +1,53 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "MappedFile.h"
+
+/* C++ STL HEADER FILES */
+#include <utility>
+
+/* SYSTEM HEADER FILES */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+
+namespace cpet::util {
+
+MappedFile::MappedFile(const std::string& file) {
+  const int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw cpet::io_error("Could not open file " + file);
+  }
+
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    throw cpet::io_error("Could not stat file " + file);
+  }
+  size_ = static_cast<size_t>(status.st_size);
+
+  /* mmap of a zero length region is an error, an empty view is not */
+  if (size_ > 0) {
+    data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      size_ = 0;
+      ::close(fd);
+      throw cpet::io_error("Could not map file " + file);
+    }
+    ::madvise(data_, size_, MADV_SEQUENTIAL);
+  }
+  /* The mapping keeps its own reference to the file */
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+}
+}  // namespace cpet::util
@@ -0,0 +1,231 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "MemoryPlan.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <Eigen/Dense>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "NumpyIO.h"
+#include "Utilities.h"
+
+namespace cpet::memory {
+
+namespace {
+/* Rows of a plot3d output formatted or computed per thread at a time, see
+ * util::writeRows */
+constexpr uint64_t ROWS_PER_THREAD = uint64_t{1} << 14;
+/* Six %g values and their separators */
+constexpr uint64_t TEXT_ROW_BYTES = 96;
+/* Points, fields and the seven coordinate arrays handed to matplot */
+constexpr uint64_t PLOTTED_POINT_BYTES = 2 * sizeof(Eigen::Vector3d) +
+                                         7 * sizeof(double);
+/* Point, field and lattice index entry of a refined point */
+constexpr uint64_t REFINED_POINT_BYTES = 2 * sizeof(Eigen::Vector3d) + 32;
+/* Packed id, charge, two hash slots and the charged atom index per atom; ids
+ * that do not pack are rare enough to leave out */
+constexpr uint64_t TOPOLOGY_ATOM_BYTES =
+    sizeof(PackedAtomID) + sizeof(double) + 3 * sizeof(uint32_t);
+
+constexpr std::array<std::string_view, 5> UNITS = {"B", "KiB", "MiB", "GiB",
+                                                   "TiB"};
+
+/* Most points an adaptive grid can reach: every cell split maxDepth times,
+ * which is 8^maxDepth points per coarse point but never more than the whole
+ * grid at the finest spacing */
+[[nodiscard]] uint64_t refinedPointBound(const Grid& grid,
+                                         const int maxDepth) noexcept {
+  const uint64_t scale = uint64_t{1} << maxDepth;
+  uint64_t finest = 1;
+  for (const auto& axis : grid.axes()) {
+    finest *= axis.empty() ? 0 : (axis.size() - 1) * scale + 1;
+  }
+  const uint64_t perPoint = scale * scale * scale;
+  const uint64_t points = grid.size();
+  return (points > finest / perPoint) ? finest : points * perPoint;
+}
+
+void addItem(std::vector<Item>& items, const std::string& name,
+             const uint64_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  const auto item = std::find_if(items.begin(), items.end(),
+                                 [&](const Item& i) { return i.name == name; });
+  if (item == items.end()) {
+    items.push_back({name, bytes});
+  } else {
+    item->bytes += bytes;
+  }
+}
+}  // namespace
+
+uint64_t Plan::footprint() const noexcept {
+  return std::accumulate(
+      items.begin(), items.end(), uint64_t{0},
+      [](const uint64_t sum, const Item& item) { return sum + item.bytes; });
+}
+
+std::string Plan::describe() const {
+  auto sorted = items;
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Item& lhs, const Item& rhs) {
+              return lhs.bytes > rhs.bytes;
+            });
+  std::string result;
+  for (const auto& item : sorted) {
+    result += "  " + item.name + ": " + formatSize(item.bytes) + '\n';
+  }
+  result += "  total: " + formatSize(footprint());
+  return result;
+}
+
+uint64_t parseSize(std::string_view size) {
+  const auto invalid = [&size]() {
+    return cpet::invalid_option("Invalid memory size: " + std::string(size));
+  };
+
+  uint64_t value = 0;
+  const auto* last = size.data() + size.size();
+  const auto [ptr, ec] = std::from_chars(size.data(), last, value);
+  if (ec != std::errc() || ptr == size.data()) {
+    throw invalid();
+  }
+
+  auto suffix = util::tolower(std::string(ptr, last));
+  if (util::endswith(suffix, "ib")) {
+    suffix.resize(suffix.size() - 2);
+  } else if (suffix.size() > 1 && util::endswith(suffix, "b")) {
+    suffix.pop_back();
+  }
+  constexpr std::string_view PREFIXES = "kmgt";
+  uint64_t scale = 1;
+  if (suffix.size() == 1 && PREFIXES.find(suffix[0]) != std::string::npos) {
+    scale = uint64_t{1} << (10 * (PREFIXES.find(suffix[0]) + 1));
+  } else if (!suffix.empty() && suffix != "b") {
+    throw invalid();
+  }
+  if (value > std::numeric_limits<uint64_t>::max() / scale) {
+    throw invalid();
+  }
+  return value * scale;
+}
+
+std::string formatSize(const uint64_t bytes) {
+  auto value = static_cast<double>(bytes);
+  size_t unit = 0;
+  while (value >= 1024.0 && unit + 1 < UNITS.size()) {
+    value /= 1024.0;
+    ++unit;
+  }
+  std::ostringstream result;
+  if (unit == 0) {
+    result << bytes;
+  } else {
+    result << std::fixed << std::setprecision(1) << value;
+  }
+  result << ' ' << UNITS.at(unit);
+  return result.str();
+}
+
+Plan estimate(const Option& option, const Workload& workload, const bool stream,
+              const int numberOfThreads) {
+  Plan plan{stream, std::max(numberOfThreads, 1), {}};
+  const auto threads = static_cast<uint64_t>(plan.numberOfThreads);
+  const uint64_t atoms = workload.numberOfAtoms;
+  const uint64_t frames = workload.numberOfFrames;
+  auto& items = plan.items;
+
+  /* Systems take over their frames, so coordinates are only held once */
+  const auto heldFrames = stream ? std::min(threads, frames) : frames;
+  addItem(items, "frames", heldFrames * atoms * workload.coordinateBytes);
+  addItem(items, "topology", atoms * TOPOLOGY_ATOM_BYTES);
+
+  for (const auto& fieldLocations : option.calculateFieldLocations()) {
+    addItem(items, "field locations",
+            fieldLocations.locations().size() * frames *
+                sizeof(Eigen::Vector3d));
+  }
+
+  for (const auto& volume : option.calculateEFieldVolumes()) {
+    const uint64_t points = volume.grid().size();
+    if (volume.refinement()) {
+      /* Which cells split depends on the field, so assume all of them do */
+      addItem(items, "adaptive plot3d",
+              refinedPointBound(volume.grid(), volume.refinement()->maxDepth) *
+                  REFINED_POINT_BYTES);
+    } else if (volume.showPlot()) {
+      addItem(items, "plot3d grid", points * PLOTTED_POINT_BYTES);
+    } else if (volume.output()) {
+      const auto rowBytes = util::isNpzFile(*volume.output())
+                                ? 3 * sizeof(double)
+                                : TEXT_ROW_BYTES;
+      addItem(items, "plot3d blocks",
+              std::min(points, threads * ROWS_PER_THREAD) * rowBytes);
+    }
+  }
+
+  for (const auto& region : option.calculateEFieldTopology()) {
+    if (region.analysisOnly()) {
+      continue;
+    }
+    const auto samples =
+        static_cast<uint64_t>(std::max(region.numberOfSamples(), 0));
+    /* Gathered by the sampling threads, then copied out */
+    addItem(items, "topology samples", 2 * samples * sizeof(PathSample));
+    if (!region.computeMatrix()) {
+      continue;
+    }
+    addItem(items, "topology samples", frames * samples * sizeof(PathSample));
+    for (const auto& bins : region.resolutions()) {
+      addItem(items, "histograms",
+              frames * static_cast<uint64_t>(bins[0]) *
+                  static_cast<uint64_t>(bins[1]) * sizeof(double));
+    }
+    if (const auto& approximate = region.approximate()) {
+      addItem(items, "neighbor graphs",
+              frames * static_cast<uint64_t>(approximate->neighbors) *
+                  sizeof(sketch::Neighbor));
+    } else {
+      addItem(items, "distance matrices",
+              frames * frames * region.metrics().size() * sizeof(double));
+    }
+  }
+  return plan;
+}
+
+Plan makePlan(const Option& option, const Workload& workload,
+              const uint64_t budget, const bool stream,
+              const int numberOfThreads) {
+  auto plan = estimate(option, workload, stream, numberOfThreads);
+  if (plan.footprint() <= budget) {
+    return plan;
+  }
+  if (!stream) {
+    plan = estimate(option, workload, true, numberOfThreads);
+  }
+  while (plan.footprint() > budget && plan.numberOfThreads > 1) {
+    plan = estimate(option, workload, true, plan.numberOfThreads / 2);
+  }
+  if (plan.footprint() > budget) {
+    throw cpet::value_error(
+        "Estimated memory use exceeds --max-memory of " + formatSize(budget) +
+        " even when streaming frames on a single thread:\n" +
+        plan.describe() +
+        "\nReduce the frames (coordinatesSkip), samples, bins or plot3d "
+        "density, or use approximate instead of the distance matrix");
+  }
+  return plan;
+}
+}  // namespace cpet::memory
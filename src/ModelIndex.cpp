@@ -0,0 +1,171 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "ModelIndex.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+/* SYSTEM HEADER FILES */
+#include <unistd.h>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "BinaryIO.h"
+#include "Exceptions.h"
+#include "FrameCache.h"
+#include "MappedFile.h"
+
+namespace cpet::cache {
+
+namespace {
+constexpr std::array<char, 8> INDEX_MAGIC = {'C', 'P', 'E', 'T',
+                                             'I', 'D', 'X', '\0'};
+constexpr uint32_t INDEX_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/* Followed by numberOfModels records of begin, end, firstLine, terminated */
+struct IndexHeader {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t sourceSize;
+  int64_t sourceModified;
+  uint64_t numberOfModels;
+};
+
+using Record = std::array<uint64_t, 4>;
+
+void writeIndex(const std::string& file, const Source& source,
+                const std::vector<Frame::Model>& models) {
+  const IndexHeader header{INDEX_MAGIC, INDEX_VERSION, BYTE_ORDER_MARK,
+                           source.size, source.modified, models.size()};
+  std::vector<Record> records;
+  records.reserve(models.size());
+  for (const auto& model : models) {
+    records.push_back({model.begin, model.end, model.firstLine,
+                       static_cast<uint64_t>(model.terminated)});
+  }
+
+  /* Written aside and renamed so a concurrent run never reads half of it */
+  const auto indexFile = indexFileFor(file);
+  const auto temporaryFile = indexFile + '.' + std::to_string(::getpid());
+  std::ofstream outFile(temporaryFile, std::ios::binary | std::ios::trunc);
+  util::writeBinary(outFile, &header, 1);
+  util::writeBinary(outFile, records.data(), records.size());
+  outFile.close();
+
+  std::error_code error;
+  if (!outFile) {
+    std::filesystem::remove(temporaryFile, error);
+    throw cpet::io_error("Could not write file " + temporaryFile);
+  }
+  std::filesystem::rename(temporaryFile, indexFile, error);
+  if (error) {
+    std::filesystem::remove(temporaryFile, error);
+    throw cpet::io_error("Could not create file " + indexFile);
+  }
+}
+
+/* Cheap check that an indexed model still lines up with the file */
+[[nodiscard]] bool matches(const std::string_view contents,
+                           const Frame::Model& model) noexcept {
+  if (model.begin > model.end || model.end > contents.size() ||
+      (model.begin != 0 && contents[model.begin - 1] != '\n')) {
+    return false;
+  }
+  return model.terminated ? util::startswith(contents.substr(model.end),
+                                             "ENDMDL")
+                          : model.end == contents.size();
+}
+
+[[nodiscard]] std::vector<Frame::Model> select(
+    const std::vector<Frame::Model>& models, const int start,
+    const int skip) {
+  std::vector<Frame::Model> selected;
+  for (size_t i = 0; i < models.size(); ++i) {
+    if (Frame::isSelected(i, start, skip)) {
+      selected.emplace_back(models[i]);
+    }
+  }
+  return selected;
+}
+}  // namespace
+
+std::vector<Frame::Model> buildIndex(const std::string& file) {
+  const auto source = describe(file, false);
+  const util::MappedFile mappedFile(file);
+  auto models = Frame::indexModels(mappedFile.view(), 0, 1);
+  writeIndex(file, source, models);
+  return models;
+}
+
+std::optional<std::vector<Frame::Model>> readIndex(const std::string& file) {
+  const auto indexFile = indexFileFor(file);
+  if (!std::filesystem::exists(indexFile)) {
+    return std::nullopt;
+  }
+
+  std::ifstream inFile(indexFile, std::ios::binary);
+  IndexHeader header{};
+  util::readBinary(inFile, &header, 1, indexFile);
+  if (header.magic != INDEX_MAGIC || header.version != INDEX_VERSION ||
+      header.byteOrder != BYTE_ORDER_MARK) {
+    throw cpet::value_error(indexFile + " is not a model index");
+  }
+
+  const auto source = describe(file, false);
+  if (header.sourceSize != source.size ||
+      header.sourceModified != source.modified) {
+    SPDLOG_DEBUG("Model index {} is out of date", indexFile);
+    return std::nullopt;
+  }
+  /* Every model takes at least one byte of the source */
+  if (header.numberOfModels > source.size) {
+    throw cpet::value_error("Corrupt model index " + indexFile);
+  }
+
+  std::vector<Record> records(header.numberOfModels);
+  util::readBinary(inFile, records.data(), records.size(), indexFile);
+
+  std::vector<Frame::Model> models;
+  models.reserve(records.size());
+  for (const auto& [begin, end, firstLine, terminated] : records) {
+    models.push_back({begin, end, firstLine, terminated != 0});
+  }
+  return models;
+}
+
+std::vector<Frame::Model> selectModels(const std::string& file,
+                                       const std::string_view contents,
+                                       const int start, const int skip) {
+  try {
+    if (const auto models = readIndex(file)) {
+      auto selected = select(*models, start, skip);
+      if (std::all_of(selected.begin(), selected.end(),
+                      [&](const auto& m) { return matches(contents, m); })) {
+        SPDLOG_DEBUG("Selected {} of {} models from the index", selected.size(),
+                     models->size());
+        return selected;
+      }
+      SPDLOG_WARN("Model index does not match {}, rebuilding it", file);
+    }
+  } catch (const cpet::exception& e) {
+    SPDLOG_WARN("Ignoring model index of {}: {}", file, e.what());
+  }
+
+  const auto models = Frame::indexModels(contents, 0, 1);
+  try {
+    writeIndex(file, describe(file, false), models);
+  } catch (const cpet::io_error& e) {
+    SPDLOG_WARN("Not indexing {}: {}", file, e.what());
+  }
+  return select(models, start, skip);
+}
+}  // namespace cpet::cache
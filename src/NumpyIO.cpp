@@ -0,0 +1,311 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "NumpyIO.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "BinaryIO.h"
+#include "Exceptions.h"
+
+namespace cpet::util {
+
+namespace {
+constexpr std::string_view NPY_MAGIC = "\x93NUMPY";
+/* numpy pads its headers so that the data starts on a 64 byte boundary */
+constexpr size_t NPY_ALIGNMENT = 64;
+
+constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t END_SIGNATURE = 0x06054b50;
+constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+constexpr uint16_t ZIP_VERSION = 20;
+constexpr uint16_t ZIP64_VERSION = 45;
+/* Entries are not dated, 1980-01-01 00:00 is the earliest DOS date */
+constexpr uint16_t DOS_DATE = 0x21;
+constexpr uint32_t MAX32 = 0xFFFFFFFF;
+constexpr uint16_t MAX16 = 0xFFFF;
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = [] {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < table.size(); ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k) {
+      c = ((c & 1U) != 0) ? 0xEDB88320U ^ (c >> 1U) : c >> 1U;
+    }
+    table[i] = c;
+  }
+  return table;
+}();
+
+[[nodiscard]] uint32_t crc32(uint32_t crc, const char* data,
+                             const size_t size) noexcept {
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFFU] ^
+          (crc >> 8U);
+  }
+  return ~crc;
+}
+
+/* Field value, or the marker that it is in the zip64 extra field */
+[[nodiscard]] constexpr uint32_t field32(const uint64_t value) noexcept {
+  return static_cast<uint32_t>(std::min<uint64_t>(value, MAX32));
+}
+
+[[nodiscard]] constexpr uint16_t field16(const uint64_t value) noexcept {
+  return static_cast<uint16_t>(std::min<uint64_t>(value, MAX16));
+}
+
+/* Zip fields are little endian whatever the host is */
+template <typename T>
+void put(std::string& bytes, T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bytes.push_back(static_cast<char>(value & 0xFFU));
+    value = static_cast<T>(value >> 8U);
+  }
+}
+
+/* Whether doubles are stored least significant byte first here */
+[[nodiscard]] bool littleEndian() noexcept {
+  const uint16_t probe = 1;
+  unsigned char first{0};
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+[[nodiscard]] std::string npyHeader(const std::vector<size_t>& shape) {
+  const bool little = littleEndian();
+  std::string dictionary = std::string("{'descr': '") + (little ? '<' : '>') +
+                           "f8', 'fortran_order': False, 'shape': (";
+  for (size_t i = 0; i < shape.size(); ++i) {
+    dictionary += (i == 0) ? "" : ", ";
+    dictionary += std::to_string(shape[i]);
+  }
+  /* A one element tuple, (n,) */
+  dictionary += (shape.size() == 1) ? ",), }" : "), }";
+
+  /* magic, version and header length take 10 bytes, '\n' ends the header */
+  const auto unpadded = NPY_MAGIC.size() + 4 + dictionary.size() + 1;
+  dictionary.append((NPY_ALIGNMENT - unpadded % NPY_ALIGNMENT) % NPY_ALIGNMENT,
+                    ' ');
+  dictionary.push_back('\n');
+
+  std::string header(NPY_MAGIC);
+  header.push_back('\x01');
+  header.push_back('\x00');
+  put(header, static_cast<uint16_t>(dictionary.size()));
+  return header + dictionary;
+}
+
+[[nodiscard]] size_t elementsOf(const std::vector<size_t>& shape) {
+  return std::accumulate(shape.begin(), shape.end(), size_t{1},
+                         std::multiplies<>());
+}
+
+/* Size of data in bytes, which has to fill shape exactly */
+[[nodiscard]] uint64_t checkedSize(const std::vector<size_t>& shape,
+                                   const Chunks& data) {
+  const auto available = std::accumulate(
+      data.begin(), data.end(), size_t{0},
+      [](const size_t sum, const auto& chunk) { return sum + chunk.size(); });
+  if (elementsOf(shape) != available) {
+    throw cpet::value_error("Array data does not match its shape");
+  }
+  return available * sizeof(double);
+}
+
+void writeData(std::ostream& outFile, const Chunks& data) {
+  for (const auto& chunk : data) {
+    writeBinary(outFile, chunk.data(), chunk.size());
+  }
+}
+}  // namespace
+
+void writeNpy(const std::string& file, const std::vector<size_t>& shape,
+              const Chunks& data) {
+  static_cast<void>(checkedSize(shape, data));
+  std::ofstream outFile(file, std::ios::out | std::ios::binary);
+  if (!outFile.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+  const auto header = npyHeader(shape);
+  outFile.write(header.data(), static_cast<std::streamsize>(header.size()));
+  writeData(outFile, data);
+  outFile.close();
+  if (!outFile) {
+    throw cpet::io_error("Could not write file " + file);
+  }
+}
+
+NpzWriter::NpzWriter(const std::string& file)
+    : file_(file), outFile_(file, std::ios::out | std::ios::binary) {
+  if (!outFile_.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+}
+
+void NpzWriter::add(const std::string& name, const std::vector<size_t>& shape,
+                    const Chunks& data) {
+  static_cast<void>(checkedSize(shape, data));
+  auto chunk = data.begin();
+  add(name, shape, [&]() -> Span<const double> {
+    while (chunk != data.end() && chunk->empty()) {
+      ++chunk;
+    }
+    return (chunk == data.end()) ? Span<const double>{} : *chunk++;
+  });
+}
+
+void NpzWriter::add(const std::string& name, const std::vector<size_t>& shape,
+                    const Producer& next) {
+  const auto header = npyHeader(shape);
+  const uint64_t dataSize = elementsOf(shape) * sizeof(double);
+  Entry entry{name + std::string(NPY_EXTENSION), 0, header.size() + dataSize,
+              static_cast<uint64_t>(outFile_.tellp())};
+
+  /* The crc is only known once the data has been written, it is filled in
+   * afterwards */
+  const bool zip64 = entry.size >= MAX32;
+  std::string local;
+  put(local, LOCAL_HEADER_SIGNATURE);
+  put(local, zip64 ? ZIP64_VERSION : ZIP_VERSION);
+  put(local, uint16_t{0});  // flags
+  put(local, uint16_t{0});  // stored, no compression
+  put(local, uint16_t{0});  // time
+  put(local, DOS_DATE);
+  const auto crcOffset = local.size();
+  put(local, entry.crc);
+  put(local, field32(entry.size));
+  put(local, field32(entry.size));
+  put(local, static_cast<uint16_t>(entry.name.size()));
+  put(local, static_cast<uint16_t>(zip64 ? 20 : 0));
+  local += entry.name;
+  if (zip64) {
+    put(local, ZIP64_EXTRA_ID);
+    put(local, uint16_t{16});
+    put(local, entry.size);
+    put(local, entry.size);
+  }
+  local += header;
+  outFile_.write(local.data(), static_cast<std::streamsize>(local.size()));
+
+  entry.crc = crc32(0, header.data(), header.size());
+  uint64_t written = 0;
+  for (auto chunk = next(); !chunk.empty(); chunk = next()) {
+    written += chunk.size_bytes();
+    if (written > dataSize) {
+      break;
+    }
+    entry.crc = crc32(entry.crc, reinterpret_cast<const char*>(chunk.data()),
+                      chunk.size_bytes());
+    writeBinary(outFile_, chunk.data(), chunk.size());
+  }
+  if (written != dataSize) {
+    throw cpet::value_error("Array data does not match its shape");
+  }
+
+  std::string crc;
+  put(crc, entry.crc);
+  const auto end = outFile_.tellp();
+  outFile_.seekp(static_cast<std::streamoff>(entry.offset + crcOffset));
+  outFile_.write(crc.data(), static_cast<std::streamsize>(crc.size()));
+  outFile_.seekp(end);
+  if (!outFile_) {
+    throw cpet::io_error("Could not write file " + file_);
+  }
+  entries_.emplace_back(std::move(entry));
+}
+
+void NpzWriter::finish() {
+  const auto directoryOffset = static_cast<uint64_t>(outFile_.tellp());
+  std::string directory;
+  for (const auto& entry : entries_) {
+    std::string extra;
+    if (entry.size >= MAX32) {
+      put(extra, entry.size);
+      put(extra, entry.size);
+    }
+    if (entry.offset >= MAX32) {
+      put(extra, entry.offset);
+    }
+    const auto version = extra.empty() ? ZIP_VERSION : ZIP64_VERSION;
+
+    put(directory, CENTRAL_HEADER_SIGNATURE);
+    put(directory, version);
+    put(directory, version);
+    put(directory, uint16_t{0});  // flags
+    put(directory, uint16_t{0});  // stored, no compression
+    put(directory, uint16_t{0});  // time
+    put(directory, DOS_DATE);
+    put(directory, entry.crc);
+    put(directory, field32(entry.size));
+    put(directory, field32(entry.size));
+    put(directory, static_cast<uint16_t>(entry.name.size()));
+    put(directory,
+        static_cast<uint16_t>(extra.empty() ? 0 : extra.size() + 4));
+    put(directory, uint16_t{0});  // comment
+    put(directory, uint16_t{0});  // disk
+    put(directory, uint16_t{0});  // internal attributes
+    put(directory, uint32_t{0});  // external attributes
+    put(directory, field32(entry.offset));
+    directory += entry.name;
+    if (!extra.empty()) {
+      put(directory, ZIP64_EXTRA_ID);
+      put(directory, static_cast<uint16_t>(extra.size()));
+      directory += extra;
+    }
+  }
+
+  const uint64_t numberOfEntries = entries_.size();
+  const uint64_t directorySize = directory.size();
+  if (numberOfEntries >= MAX16 || directorySize >= MAX32 ||
+      directoryOffset >= MAX32) {
+    const uint64_t recordOffset = directoryOffset + directorySize;
+    put(directory, ZIP64_END_SIGNATURE);
+    put(directory, uint64_t{44});  // size of the rest of the record
+    put(directory, ZIP64_VERSION);
+    put(directory, ZIP64_VERSION);
+    put(directory, uint32_t{0});  // disk
+    put(directory, uint32_t{0});  // disk with the directory
+    put(directory, numberOfEntries);
+    put(directory, numberOfEntries);
+    put(directory, directorySize);
+    put(directory, directoryOffset);
+
+    put(directory, ZIP64_LOCATOR_SIGNATURE);
+    put(directory, uint32_t{0});  // disk with the zip64 record
+    put(directory, recordOffset);
+    put(directory, uint32_t{1});  // number of disks
+  }
+
+  put(directory, END_SIGNATURE);
+  put(directory, uint16_t{0});  // disk
+  put(directory, uint16_t{0});  // disk with the directory
+  put(directory, field16(numberOfEntries));
+  put(directory, field16(numberOfEntries));
+  put(directory, field32(directorySize));
+  put(directory, field32(directoryOffset));
+  put(directory, uint16_t{0});  // comment
+
+  outFile_.write(directory.data(),
+                 static_cast<std::streamsize>(directory.size()));
+  outFile_.close();
+  if (!outFile_) {
+    throw cpet::io_error("Could not write file " + file_);
+  }
+}
+}  // namespace cpet::util
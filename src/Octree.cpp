@@ -0,0 +1,224 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Octree.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "RAIIThread.h"
+
+namespace cpet::octree {
+
+namespace {
+/* Position on the grid refined maxDepth times in every cell, so that a
+ * point has the same lattice coordinates whichever cell added it */
+using Lattice = std::array<uint64_t, 3>;
+
+struct Cell {
+  Lattice corner;
+  uint64_t size;
+};
+
+class Refiner {
+ public:
+  Refiner(const Grid& grid, const Refinement& refinement, const Field& field,
+          const int numberOfThreads)
+      : grid_(grid),
+        field_(field),
+        numberOfThreads_(numberOfThreads),
+        scale_(uint64_t{1} << refinement.maxDepth),
+        tolerance_(refinement.tolerance),
+        cosTolerance_(std::cos(std::min(refinement.tolerance, M_PI))) {
+    const auto& axes = grid_.axes();
+    uint64_t total = 1;
+    for (size_t d = 0; d < 3; ++d) {
+      extent_[d] = (axes[d].size() - 1) * scale_ + 1;
+      if (extent_[d] > std::numeric_limits<uint64_t>::max() / total) {
+        throw cpet::value_error(
+            "Adaptive refinement is too deep for the density of the grid");
+      }
+      total *= extent_[d];
+    }
+  }
+
+  Sample run(const int maxDepth) {
+    std::vector<Lattice> pending;
+    pending.reserve(grid_.size());
+    for (size_t i = 0; i < grid_.size(); ++i) {
+      const auto lattice = coarse_(grid_.structuredIndex(i));
+      index_.emplace(key_(lattice), pending.size());
+      pending.push_back(lattice);
+    }
+    evaluate_(pending);
+
+    std::vector<Cell> cells;
+    const auto& axes = grid_.axes();
+    for (size_t i = 0; i < grid_.size(); ++i) {
+      const auto structured = grid_.structuredIndex(i);
+      const auto z = structured % axes[2].size();
+      const auto y = (structured / axes[2].size()) % axes[1].size();
+      const auto x = structured / (axes[2].size() * axes[1].size());
+      if (x + 1 >= axes[0].size() || y + 1 >= axes[1].size() ||
+          z + 1 >= axes[2].size()) {
+        continue;
+      }
+      Cell cell{coarse_(structured), scale_};
+      bool complete = true;
+      forEachCorner_(cell, [&](const Lattice& corner) {
+        complete = complete && index_.find(key_(corner)) != index_.end();
+      });
+      if (complete) {
+        cells.push_back(cell);
+      }
+    }
+
+    for (int depth = 0; depth < maxDepth && !cells.empty(); ++depth) {
+      pending.clear();
+      std::vector<Cell> children;
+      for (const auto& cell : cells) {
+        if (!varies_(cell)) {
+          continue;
+        }
+        const auto half = cell.size / 2;
+        for (uint64_t dx = 0; dx <= cell.size; dx += half) {
+          for (uint64_t dy = 0; dy <= cell.size; dy += half) {
+            for (uint64_t dz = 0; dz <= cell.size; dz += half) {
+              const Lattice point = {cell.corner[0] + dx, cell.corner[1] + dy,
+                                     cell.corner[2] + dz};
+              const auto next = sample_.points.size() + pending.size();
+              if (index_.emplace(key_(point), next).second) {
+                pending.push_back(point);
+              }
+              if (dx < cell.size && dy < cell.size && dz < cell.size) {
+                children.push_back({point, half});
+              }
+            }
+          }
+        }
+      }
+      SPDLOG_DEBUG("Refinement level {} splits {} cells, adding {} points",
+                   depth + 1, children.size() / 8, pending.size());
+      evaluate_(pending);
+      cells = std::move(children);
+    }
+    return std::move(sample_);
+  }
+
+ private:
+  [[nodiscard]] inline Lattice coarse_(const size_t structured) const {
+    const auto& axes = grid_.axes();
+    const auto z = structured % axes[2].size();
+    const auto y = (structured / axes[2].size()) % axes[1].size();
+    const auto x = structured / (axes[2].size() * axes[1].size());
+    return {x * scale_, y * scale_, z * scale_};
+  }
+
+  [[nodiscard]] inline uint64_t key_(const Lattice& point) const noexcept {
+    return (point[0] * extent_[1] + point[1]) * extent_[2] + point[2];
+  }
+
+  /* Linear between the grid points either side, which is where splitting
+   * the cell puts it */
+  [[nodiscard]] inline Eigen::Vector3d position_(const Lattice& point) const {
+    const auto& axes = grid_.axes();
+    Eigen::Vector3d result;
+    for (size_t d = 0; d < 3; ++d) {
+      const auto coarse = point[d] / scale_;
+      const auto fine = point[d] % scale_;
+      double x = axes[d][coarse];
+      if (fine != 0) {
+        x += (axes[d][coarse + 1] - x) * static_cast<double>(fine) /
+             static_cast<double>(scale_);
+      }
+      result[static_cast<long>(d)] = x;
+    }
+    return result;
+  }
+
+  template <typename Function>
+  static inline void forEachCorner_(const Cell& cell, const Function& func) {
+    for (uint64_t corner = 0; corner < 8; ++corner) {
+      func(Lattice{cell.corner[0] + ((corner >> 2) & 1) * cell.size,
+                   cell.corner[1] + ((corner >> 1) & 1) * cell.size,
+                   cell.corner[2] + (corner & 1) * cell.size});
+    }
+  }
+
+  [[nodiscard]] bool varies_(const Cell& cell) const {
+    std::array<Eigen::Vector3d, 8> fields;
+    size_t n = 0;
+    forEachCorner_(cell, [&](const Lattice& corner) {
+      fields[n++] = sample_.fields[index_.at(key_(corner))];
+    });
+
+    double smallest = std::numeric_limits<double>::max();
+    double largest = 0;
+    for (const auto& field : fields) {
+      smallest = std::min(smallest, field.norm());
+      largest = std::max(largest, field.norm());
+    }
+    if (largest == 0) {
+      return false;
+    }
+    if ((largest - smallest) > tolerance_ * largest) {
+      return true;
+    }
+    /* Every magnitude is within tolerance of the largest and so non-zero */
+    const Eigen::Vector3d direction = fields[0].normalized();
+    return std::any_of(fields.begin() + 1, fields.end(),
+                       [&](const Eigen::Vector3d& field) {
+                         return field.normalized().dot(direction) <
+                                cosTolerance_;
+                       });
+  }
+
+  void evaluate_(const std::vector<Lattice>& pending) {
+    const auto first = sample_.points.size();
+    sample_.points.resize(first + pending.size());
+    sample_.fields.resize(first + pending.size());
+    util::forEachChunk(
+        pending.size(), numberOfThreads_,
+        [&](const size_t begin, const size_t end, size_t) {
+          for (size_t i = begin; i < end; ++i) {
+            sample_.points[first + i] = position_(pending[i]);
+            sample_.fields[first + i] = field_(sample_.points[first + i]);
+          }
+        });
+  }
+
+  const Grid& grid_;
+  const Field& field_;
+  int numberOfThreads_;
+  uint64_t scale_;
+  double tolerance_;
+  double cosTolerance_;
+  Lattice extent_{};
+  std::unordered_map<uint64_t, size_t> index_;
+  Sample sample_;
+};
+}  // namespace
+
+Sample refine(const Grid& grid, const Refinement& refinement,
+              const Field& field, const int numberOfThreads) {
+  if (refinement.maxDepth < 0 || refinement.maxDepth > MAX_DEPTH) {
+    throw cpet::value_error("Adaptive refinement depth must be 0 to " +
+                            std::to_string(MAX_DEPTH));
+  }
+  if (grid.empty()) {
+    return {};
+  }
+  return Refiner(grid, refinement, field, numberOfThreads)
+      .run(refinement.maxDepth);
+}
+}  // namespace cpet::octree
@@ -0,0 +1,179 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Sketch.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+/* CPET HEADER FILES */
+#include "Histogram2D.h"
+#include "RAIIThread.h"
+#include "Utilities.h"
+
+namespace cpet::sketch {
+
+namespace {
+/* Candidates kept per point before re-ranking with the exact distance */
+constexpr size_t REFINE_FACTOR = 3;
+constexpr size_t MIN_LEAF_SIZE = 16;
+
+using Leaves = std::vector<std::vector<size_t>>;
+
+/* Recursively splits indices along random hyperplanes (the perpendicular
+ * bisector of two random members) until each leaf is small enough. */
+void splitNode(const Eigen::MatrixXd& sketches, std::vector<size_t> indices,
+               const size_t leafSize, Leaves& leaves) {
+  if (indices.size() <= leafSize) {
+    leaves.emplace_back(std::move(indices));
+    return;
+  }
+
+  auto& generator = *util::randomNumberGenerator();
+  std::uniform_int_distribution<size_t> pick(0, indices.size() - 1);
+  const auto a = indices[pick(generator)];
+  const auto b = indices[pick(generator)];
+
+  const Eigen::VectorXd normal = sketches.col(static_cast<Eigen::Index>(a)) -
+                                 sketches.col(static_cast<Eigen::Index>(b));
+  const double offset =
+      normal.dot(sketches.col(static_cast<Eigen::Index>(a)) +
+                 sketches.col(static_cast<Eigen::Index>(b))) /
+      2.0;
+
+  std::vector<size_t> left;
+  std::vector<size_t> right;
+  for (const auto& i : indices) {
+    if (normal.dot(sketches.col(static_cast<Eigen::Index>(i))) < offset) {
+      left.emplace_back(i);
+    } else {
+      right.emplace_back(i);
+    }
+  }
+
+  /* Degenerate split (duplicate sketches), fall back to a random halving */
+  if (left.empty() || right.empty()) {
+    std::shuffle(indices.begin(), indices.end(), generator);
+    const auto middle = indices.begin() + static_cast<long>(indices.size() / 2);
+    left.assign(indices.begin(), middle);
+    right.assign(middle, indices.end());
+  }
+  indices.clear();
+  indices.shrink_to_fit();
+
+  splitNode(sketches, std::move(left), leafSize, leaves);
+  splitNode(sketches, std::move(right), leafSize, leaves);
+}
+
+void keepNearest(std::vector<Neighbor>& candidates, const size_t count) {
+  const auto middle = candidates.begin() +
+                      static_cast<long>(std::min(count, candidates.size()));
+  std::partial_sort(
+      candidates.begin(), middle, candidates.end(),
+      [](const auto& n1, const auto& n2) { return n1.distance < n2.distance; });
+  candidates.erase(middle, candidates.end());
+}
+}  // namespace
+
+Eigen::MatrixXd construct(const std::vector<std::vector<double>>& histograms,
+                          const int sketchSize) {
+  if (histograms.empty()) {
+    return {};
+  }
+  const auto bins = static_cast<Eigen::Index>(histograms.front().size());
+  const auto size = static_cast<Eigen::Index>(sketchSize);
+
+  std::normal_distribution<double> gaussian(0.0, 1.0);
+  Eigen::MatrixXd projection(size, bins);
+  for (Eigen::Index i = 0; i < projection.size(); ++i) {
+    projection(i) = gaussian(*util::randomNumberGenerator());
+  }
+  projection /= std::sqrt(static_cast<double>(sketchSize));
+
+  Eigen::MatrixXd roots(bins, static_cast<Eigen::Index>(histograms.size()));
+  for (size_t i = 0; i < histograms.size(); ++i) {
+    roots.col(static_cast<Eigen::Index>(i)) =
+        Eigen::Map<const Eigen::VectorXd>(histograms[i].data(), bins)
+            .cwiseSqrt();
+  }
+  return projection * roots;
+}
+
+Graph nearestNeighbors(const std::vector<std::vector<double>>& histograms,
+                       const Options& options, const int numberOfThreads) {
+  const auto n = histograms.size();
+  if (n == 0) {
+    return {};
+  }
+  const auto k = std::min(static_cast<size_t>(options.neighbors), n - 1);
+  const auto sketches = construct(histograms, options.sketchSize);
+
+  const auto numberOfTrees = static_cast<size_t>(options.numberOfTrees);
+  const auto leafSize = std::max(MIN_LEAF_SIZE, 2 * (k + 1));
+  std::vector<Leaves> forest(numberOfTrees);
+  util::forEachChunk(numberOfTrees, numberOfThreads,
+                     [&](const size_t begin, const size_t end, const size_t) {
+                       for (size_t t = begin; t < end; ++t) {
+                         std::vector<size_t> indices(n);
+                         std::iota(indices.begin(), indices.end(), 0);
+                         splitNode(sketches, std::move(indices), leafSize,
+                                   forest[t]);
+                       }
+                     });
+
+  /* leafOf[t][i] is the leaf in tree t that contains point i */
+  std::vector<std::vector<size_t>> leafOf(numberOfTrees,
+                                          std::vector<size_t>(n));
+  for (size_t t = 0; t < numberOfTrees; ++t) {
+    for (size_t leaf = 0; leaf < forest[t].size(); ++leaf) {
+      for (const auto& i : forest[t][leaf]) {
+        leafOf[t][i] = leaf;
+      }
+    }
+  }
+
+  /* Euclidean sketch distance / sqrt(2) estimates the Hellinger distance */
+  const double scale = 1.0 / std::sqrt(2.0);
+  Graph graph(n);
+  util::forEachChunk(
+      n, numberOfThreads,
+      [&](const size_t begin, const size_t end, const size_t) {
+        std::vector<size_t> candidates;
+        for (size_t i = begin; i < end; ++i) {
+          candidates.clear();
+          for (size_t t = 0; t < numberOfTrees; ++t) {
+            const auto& leaf = forest[t][leafOf[t][i]];
+            candidates.insert(candidates.end(), leaf.begin(), leaf.end());
+          }
+          std::sort(candidates.begin(), candidates.end());
+          candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                           candidates.end());
+
+          auto& neighbors = graph[i];
+          neighbors.reserve(candidates.size());
+          for (const auto& j : candidates) {
+            if (j == i) {
+              continue;
+            }
+            neighbors.push_back(
+                {j, scale * (sketches.col(static_cast<Eigen::Index>(i)) -
+                             sketches.col(static_cast<Eigen::Index>(j)))
+                                .norm()});
+          }
+
+          if (options.refine) {
+            keepNearest(neighbors, REFINE_FACTOR * k);
+            for (auto& neighbor : neighbors) {
+              neighbor.distance =
+                  histo::chiDistance(histograms[i], histograms[neighbor.index]);
+            }
+          }
+          keepNearest(neighbors, k);
+        }
+      });
+  return graph;
+}
+}  // namespace cpet::sketch
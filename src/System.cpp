@@ -4,6 +4,7 @@
 /* C++ STL HEADER FILES */
 #include <array>
 #include <cmath>
+#include <type_traits>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include <cs_plain_guarded.h>
@@ -13,12 +14,32 @@
 /* CPET HEADER FILES */
 #include "Instrumentation.h"
 #include "RAIIThread.h"
+#include "Span.h"
 #include "System.h"
+#include "Volumes.h"
 
 namespace cpet {
 
+namespace {
+/* Coulomb sum over the charged atoms, without the 1/(4 pi e0) factor. The
+ * coordinates may be single precision, the sum is always kept in double. */
+template <typename Coordinate>
+Eigen::Vector3d coulombSum(const Eigen::Vector3d& position,
+                           util::Span<const Coordinate> coordinates,
+                           const Topology& topology) noexcept {
+  Eigen::Vector3d result(0, 0, 0);
+  const auto& charges = topology.charges();
+  for (const auto i : topology.chargedAtoms()) {
+    const Eigen::Vector3d d = position - coordinates[i].template cast<double>();
+    const auto dNorm = d.norm();
+    result += ((charges[i] * d) / (dNorm * dNorm * dNorm));
+  }
+  return result;
+}
+}  // namespace
+
 System::System(Frame frame, const Option& options)
-    : frame_(std::move(frame)), pointCharges_(frame_.begin(), frame_.end()) {
+    : frame_(std::move(frame)) {
   if (options.centerID().position()) {
     center_ = *(options.centerID().position());
   } else {
@@ -75,23 +96,28 @@ System::System(Frame frame, const Option& options)
     throw cpet::value_error("Basis is not linearly independent");
   }
 
-  SPDLOG_DEBUG("Removing point charges with charge of 0...");
-  pointCharges_.erase(remove_if(begin(pointCharges_), end(pointCharges_),
-                                [](const auto& p) { return p.charge == 0.0; }),
-                      end(pointCharges_));
+  inverse_ = basisMatrix_.inverse();
 }
 
 Eigen::Vector3d System::electricFieldAt(const Eigen::Vector3d& position) const {
-  Eigen::Vector3d result(0, 0, 0);
+  if (!userSpace_) {
+    return electricFieldInFrameAt_(position);
+  }
+  /* The user basis is orthonormal, so rotating the field is the same as
+   * computing it from rotated charges */
+  return inverse_ * electricFieldInFrameAt_(transformToDefaultSpace(position));
+}
+
+Eigen::Vector3d System::electricFieldInFrameAt_(
+    const Eigen::Vector3d& position) const noexcept {
   constexpr double PERM_SPACE = 0.0055263495;
   constexpr double TO_V_PER_ANG = (1.0 / (4.0 * M_PI * PERM_SPACE));
 
-  /* If we can speed this up, we should!! */
-  for (const auto& pc : pointCharges_) {
-    const Eigen::Vector3d d = (position - pc.coordinate);
-    const auto dNorm = d.norm();
-    result += ((pc.charge * d) / (dNorm * dNorm * dNorm));
-  }
+  const auto& topology = frame_.topology();
+  Eigen::Vector3d result =
+      frame_.singlePrecision()
+          ? coulombSum(position, frame_.compactCoordinates(), topology)
+          : coulombSum(position, frame_.coordinates(), topology);
   result *= TO_V_PER_ANG;
   return result;
 }
@@ -99,6 +125,28 @@ Eigen::Vector3d System::electricFieldAt(const Eigen::Vector3d& position) const {
 std::vector<PathSample> System::electricFieldTopologyIn(
     int numOfThreads, const Volume& volume, const double stepsize,
     const int numberOfSamples) const {
+  return visitVolume(volume, [&](const auto& region) {
+    using Region = std::decay_t<decltype(region)>;
+    if constexpr (std::is_same_v<Region, Cavity>) {
+      /* Cavities around atoms take their shape from this frame */
+      if (!region.placed()) {
+        const auto placed =
+            region.placedIn(frame_.topology(), [this](const size_t i) {
+              return coordinate(i);
+            });
+        return electricFieldTopologyIn_(numOfThreads, placed, stepsize,
+                                        numberOfSamples);
+      }
+    }
+    return electricFieldTopologyIn_(numOfThreads, region, stepsize,
+                                    numberOfSamples);
+  });
+}
+
+template <typename Region>
+std::vector<PathSample> System::electricFieldTopologyIn_(
+    int numOfThreads, const Region& volume, const double stepsize,
+    const int numberOfSamples) const {
   std::vector<PathSample> sampleResults;
   sampleResults.reserve(static_cast<size_t>(numberOfSamples));
 
@@ -161,7 +209,8 @@ std::vector<PathSample> System::electricFieldTopologyIn(
   return sampleResults;
 }
 
-PathSample System::sampleElectricFieldTopologyIn_(const Volume& region,
+template <typename Region>
+PathSample System::sampleElectricFieldTopologyIn_(const Region& region,
                                                   const double stepSize) const
     noexcept(true) {
   /* This is not thread-safe, however, implementation is thread-safe */
@@ -213,10 +262,12 @@ std::vector<Eigen::Vector3d> System::computeElectricFieldIn(
       [this](const Eigen::Vector3d& position) -> Eigen::Vector3d {
     return this->electricFieldAt(position);
   };
+  const auto& grid = volume.grid();
   std::vector<Eigen::Vector3d> results;
-  results.reserve(volume.points().size());
-  std::transform(volume.points().begin(), volume.points().end(),
-                 std::back_inserter(results), compute_volume_in_system);
+  results.reserve(grid.size());
+  for (size_t i = 0; i < grid.size(); ++i) {
+    results.emplace_back(compute_volume_in_system(grid[i]));
+  }
   return results;
 }
 }  // namespace cpet
@@ -5,6 +5,7 @@
 
 /* C++ STL HEADER FILES */
 #include <utility>
+#include <cstdint>
 #include <filesystem>
 #include <iomanip>
 
@@ -18,60 +19,260 @@
 #include "System.h"
 #include "Instrumentation.h"
 #include "Histogram2D.h"
+#include "RAIIThread.h"
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "NumpyIO.h"
+#include "TextWriter.h"
 
 namespace cpet {
 
+namespace {
+/* Accepts "bins N", the legacy "bins X Y", or a list of resolutions where
+ * each entry is either N (N x N) or XxY, e.g. "bins 25 50 100 200" */
+[[nodiscard]] std::vector<std::array<int, 2>> parseBins(
+    const std::vector<std::string>& options) {
+  const auto to_bins = [](const std::string& token) -> std::array<int, 2> {
+    const auto dims = util::split(token, 'x');
+    if (dims.empty() || dims.size() > 2 ||
+        !std::all_of(dims.begin(), dims.end(), util::isDouble)) {
+      throw cpet::invalid_option(
+          "Invalid Option: topology requires bin to be numeric");
+    }
+    return {std::stoi(dims.front()), std::stoi(dims.back())};
+  };
+
+  const bool explicitPairs =
+      std::any_of(options.begin(), options.end(), [](const auto& token) {
+        return token.find('x') != std::string::npos;
+      });
+  if (!explicitPairs && options.size() == 2) {
+    return {{to_bins(options[0])[0], to_bins(options[1])[0]}};
+  }
+
+  std::vector<std::array<int, 2>> result;
+  std::transform(options.begin(), options.end(), std::back_inserter(result),
+                 to_bins);
+  return result;
+}
+
+/* Samples of one .top file. Malformed lines are reported and skipped. */
+[[nodiscard]] std::vector<PathSample> readSampleFile(
+    const std::string& filename) {
+  SPDLOG_DEBUG("Loading in data from file {}", filename);
+  const util::MappedFile mappedFile(filename);
+  const auto contents = mappedFile.view();
+
+  std::vector<PathSample> samples;
+  samples.reserve(
+      static_cast<size_t>(std::count(contents.begin(), contents.end(), '\n')));
+  util::forEachLineOf(contents, [&, linenumber = 0](
+                                    const std::string_view line) mutable {
+    if (!line.empty() && !util::startswith(line, "#")) {
+      std::array<std::string_view, 3> tokens;
+      if (util::tokenize(line, ',', tokens) != 2) {
+        SPDLOG_WARN(
+            "topology data file {} contains invalid number of entries on "
+            "line {}",
+            filename, linenumber);
+      } else if (const auto distance = util::toDouble(tokens[0]),
+                 curvature = util::toDouble(tokens[1]);
+                 distance && curvature) {
+        samples.emplace_back(PathSample{*distance, *curvature});
+      } else {
+        SPDLOG_WARN(
+            "topology data file {} has non-numeric types in data section in "
+            "line {}",
+            filename, linenumber);
+      }
+    }
+    ++linenumber;
+  });
+  SPDLOG_INFO("Loaded file: {}", filename);
+  return samples;
+}
+
+/* Inserts _tag before the extension, matrix.dat -> matrix_tag.dat */
+[[nodiscard]] std::string tagFile(const std::string& file,
+                                  const std::string& tag) {
+  const std::filesystem::path path(file);
+  const auto tagged =
+      path.stem().string() + '_' + tag + path.extension().string();
+  return (path.parent_path() / tagged).string();
+}
+}  // namespace
+
 void TopologyRegion::computeTopologyWith(const std::vector<System>& systems,
                                          int numberOfThreads) const {
-  std::vector<std::vector<PathSample>> sampleResults;
+  Stream stream(*this, numberOfThreads);
+  for (const auto& system : systems) {
+    stream.add(system);
+  }
+  stream.finish();
+}
 
-  if (!analysisOnly()) {
-    assert(volume_ != nullptr);
+TopologyRegion::Stream::Stream(const TopologyRegion& region,
+                               const int numberOfThreads)
+    : region_(region), numberOfThreads_(numberOfThreads) {
+  if (!region_.analysisOnly()) {
+    assert(region_.volume_ != nullptr);
     SPDLOG_INFO("======[Sampling topology]======");
-    SPDLOG_INFO("[Volume ]   ==>> {}", volume_->description());
-    SPDLOG_INFO("[Npoints]   ==>> {}", numberOfSamples_);
-    SPDLOG_INFO("[Threads]   ==>> {}", numberOfThreads);
-    SPDLOG_INFO("[STEP SIZE] ==>> {}", stepSize_);
-
-    int index = 0;
-    for (const auto& system : systems) {
-      SPDLOG_INFO("=~=~=~=~[Trajectory {}]=~=~=~=~", index);
-      std::vector<PathSample> results;
-      {
-        Timer t;
-        results = system.electricFieldTopologyIn(numberOfThreads, *volume_,
-                                                 stepSize_, numberOfSamples_);
-      }
-
-      if (sampleOutput_) {
-        writeSampleOutput_(results, index);
-      }
-      sampleResults.emplace_back(std::move(results));
-      ++index;
+    SPDLOG_INFO("[Volume ]   ==>> {}", region_.volume_->description());
+    SPDLOG_INFO("[Npoints]   ==>> {}", region_.numberOfSamples_);
+    SPDLOG_INFO("[Threads]   ==>> {}", numberOfThreads_);
+    SPDLOG_INFO("[STEP SIZE] ==>> {}", region_.stepSize_);
+    /* Every frame's samples go into one archive instead of a .top each */
+    if (region_.sampleOutput_ && util::isNpzFile(*region_.sampleOutput_)) {
+      samples_.emplace(*region_.sampleOutput_);
     }
   }
+}
+
+void TopologyRegion::Stream::add(const System& system) {
+  if (region_.analysisOnly()) {
+    return;
+  }
+
+  SPDLOG_INFO("=~=~=~=~[Trajectory {}]=~=~=~=~", index_);
+  std::vector<PathSample> results;
+  {
+    Timer t;
+    results = system.electricFieldTopologyIn(
+        numberOfThreads_, *region_.volume_, region_.stepSize_,
+        region_.numberOfSamples_);
+  }
+
+  if (samples_) {
+    static_assert(sizeof(PathSample) == 2 * sizeof(double));
+    samples_->add("samples_" + std::to_string(index_), {results.size(), 2},
+                  {{reinterpret_cast<const double*>(results.data()),
+                    2 * results.size()}});
+  } else if (region_.sampleOutput_) {
+    region_.writeSampleOutput_(results, index_);
+  }
+  /* Samples are only needed later when histograms are built from them */
+  if (region_.computeMatrix()) {
+    sampleResults_.emplace_back(std::move(results));
+  }
+  ++index_;
+}
+
+void TopologyRegion::Stream::finish() {
+  if (samples_) {
+    samples_->finish();
+    samples_.reset();
+  }
+  region_.analyze_(std::move(sampleResults_), numberOfThreads_);
+  sampleResults_ = {};
+}
 
-  if (computeMatrix()) {
-    assert(static_cast<bool>(bins_));
+void TopologyRegion::analyze_(
+    std::vector<std::vector<PathSample>> sampleResults,
+    int numberOfThreads) const {
+  if (!computeMatrix()) {
+    return;
+  }
+
+  std::vector<histo::HistogramSet> histogramSets;
+  if (histogramInput_) {
+    SPDLOG_INFO("Loading in histograms from {}", *histogramInput_);
+    histogramSets.emplace_back(histo::readHistograms(*histogramInput_));
+    const auto& loaded = histogramSets.front();
+    SPDLOG_INFO("[Bins] ==>> {} x {}", loaded.bins[0], loaded.bins[1]);
+    SPDLOG_INFO("Loaded in {} histograms", loaded.histograms.size());
+    if (!resolutions_.empty()) {
+      SPDLOG_WARN("Ignoring bins option, using bins from histogram file");
+    }
+  } else {
+    assert(!resolutions_.empty());
     if (sampleInput_) {
-      sampleResults = loadSampleData_();
+      sampleResults = loadSampleData_(numberOfThreads);
+    }
+    histogramSets = constructHistograms_(sampleResults);
+  }
+
+  for (const auto& histograms : histogramSets) {
+    if (histogramSets.size() > 1) {
+      SPDLOG_INFO("=~=~=~=~[Bins {} x {}]=~=~=~=~", histograms.bins[0],
+                  histograms.bins[1]);
+    }
+    if (histogramOutput_) {
+      histo::writeHistograms(
+          resolutionFile_(*histogramOutput_, histograms.bins), histograms);
     }
-    const auto histograms = constructHistograms_(sampleResults);
 
-    SPDLOG_INFO("==[Computing Distance Matrix]==");
-    const auto matrix = constructMatrix_(histograms);
-    SPDLOG_INFO("Distance matrix:");
-    for (const auto& row : matrix) {
-      std::stringstream output;
-      for (const auto& col : row) {
-        output << col << ' ';
+    if (approximate_) {
+      analyzeNeighborGraph_(histograms, numberOfThreads);
+    } else {
+      analyzeDistanceMatrix_(histograms, numberOfThreads);
+    }
+  }
+}
+
+void TopologyRegion::analyzeDistanceMatrix_(
+    const histo::HistogramSet& histograms, int numberOfThreads) const {
+  SPDLOG_INFO("==[Computing Distance Matrix]==");
+  auto matrices =
+      constructMatrices_(histograms.histograms, metrics_, numberOfThreads);
+  for (size_t m = 0; m < metrics_.size(); ++m) {
+    if (!cluster_) {
+      SPDLOG_INFO("Distance matrix ({}):", histo::metricName(metrics_[m]));
+      for (const auto& row : matrices[m]) {
+        std::stringstream output;
+        for (const auto& col : row) {
+          output << col << ' ';
+        }
+        SPDLOG_INFO(output.str());
       }
-      SPDLOG_INFO(output.str());
     }
     if (matrixOutput_) {
-      writeMatrixOutput_(matrix);
+      writeMatrixOutput_(matrices[m], histograms.bins, metrics_[m],
+                         numberOfThreads);
     }
   }
+
+  if (cluster_) {
+    SPDLOG_INFO("======[Clustering Frames]======");
+    SPDLOG_INFO("[Method  ] ==>> {}", cluster::methodName(cluster_->method));
+    SPDLOG_INFO("[Clusters] ==>> {}", cluster_->numberOfClusters);
+    SPDLOG_INFO("[Metric  ] ==>> {}", histo::metricName(clusterMetric_));
+    const auto m = static_cast<size_t>(
+        std::find(metrics_.begin(), metrics_.end(), clusterMetric_) -
+        metrics_.begin());
+    cluster::Result clusters;
+    {
+      Timer t;
+      /* The matrix is not needed afterwards, so clustering may consume it */
+      clusters = cluster::clusterWith(*cluster_, std::move(matrices[m]),
+                                      numberOfThreads);
+    }
+    std::stringstream output;
+    for (const auto& medoid : clusters.medoids) {
+      output << medoid << ' ';
+    }
+    SPDLOG_INFO("[Medoids ] ==>> {}", output.str());
+    if (clusterOutput_) {
+      writeClusterOutput_(clusters, histograms.bins);
+    }
+  }
+}
+
+void TopologyRegion::analyzeNeighborGraph_(
+    const histo::HistogramSet& histograms, int numberOfThreads) const {
+  assert(static_cast<bool>(approximate_));
+  SPDLOG_INFO("===[Computing Neighbor Graph]==");
+  SPDLOG_INFO("[Neighbors  ] ==>> {}", approximate_->neighbors);
+  SPDLOG_INFO("[Sketch size] ==>> {}", approximate_->sketchSize);
+  SPDLOG_INFO("[Refine     ] ==>> {}", approximate_->refine);
+  sketch::Graph graph;
+  {
+    Timer t;
+    graph = sketch::nearestNeighbors(histograms.histograms, *approximate_,
+                                     numberOfThreads);
+  }
+  if (neighborsOutput_) {
+    writeNeighborsOutput_(graph, histograms.bins);
+  }
 }
 
 TopologyRegion cpet::TopologyRegion::fromSimple(
@@ -105,8 +306,19 @@ TopologyRegion TopologyRegion::fromBlock(
   std::optional<std::string> sampleOutput{std::nullopt};
   double stepsize = DEFAULT_STEP_SIZE;
   std::optional<std::string> sampleInput{std::nullopt};
-  std::optional<std::array<int, 2>> bins{std::nullopt};
+  std::vector<std::array<int, 2>> bins;
   std::optional<std::string> matrixOutput{std::nullopt};
+  std::optional<std::string> histogramOutput{std::nullopt};
+  std::optional<std::string> histogramInput{std::nullopt};
+  std::vector<histo::Metric> metrics{histo::Metric::chi};
+  bool binaryMatrix{false};
+  std::optional<cluster::Options> clusterOptions{std::nullopt};
+  std::optional<std::string> clusterOutput{std::nullopt};
+  std::optional<histo::Metric> clusterMetric{std::nullopt};
+  std::optional<sketch::Options> approximate{std::nullopt};
+  std::optional<std::string> neighborsOutput{std::nullopt};
+  std::optional<int> sketchSize{std::nullopt};
+  bool refine{false};
 
   constexpr const char* VOLUME_KEY = "volume";
   constexpr const char* SAMPLES_KEY = "samples";
@@ -115,6 +327,17 @@ TopologyRegion TopologyRegion::fromBlock(
   constexpr const char* SAMPLE_INPUT_KEY = "sampleinput";
   constexpr const char* BINS_KEY = "bins";
   constexpr const char* MATRIX_OUTPUT_KEY = "matrixoutput";
+  constexpr const char* HISTOGRAM_OUTPUT_KEY = "histogramoutput";
+  constexpr const char* HISTOGRAM_INPUT_KEY = "histograminput";
+  constexpr const char* METRICS_KEY = "metrics";
+  constexpr const char* MATRIX_FORMAT_KEY = "matrixformat";
+  constexpr const char* CLUSTER_KEY = "cluster";
+  constexpr const char* CLUSTER_OUTPUT_KEY = "clusteroutput";
+  constexpr const char* CLUSTER_METRIC_KEY = "clustermetric";
+  constexpr const char* NEIGHBORS_KEY = "neighbors";
+  constexpr const char* SKETCH_SIZE_KEY = "sketchsize";
+  constexpr const char* REFINE_KEY = "refine";
+  constexpr const char* NEIGHBORS_OUTPUT_KEY = "neighborsoutput";
 
   for (const auto& line : options) {
     const auto tokens = util::split(line, ' ');
@@ -146,24 +369,89 @@ TopologyRegion TopologyRegion::fromBlock(
       sampleInput = *key_options.begin();
       analysisOnly = true;
     } else if (key == BINS_KEY) {
-      if (key_options.size() < 2) {
-        if (!util::isDouble(*key_options.begin())) {
+      bins = parseBins(key_options);
+    } else if (key == MATRIX_OUTPUT_KEY) {
+      matrixOutput = *key_options.begin();
+    } else if (key == HISTOGRAM_OUTPUT_KEY) {
+      histogramOutput = *key_options.begin();
+    } else if (key == HISTOGRAM_INPUT_KEY) {
+      histogramInput = *key_options.begin();
+      analysisOnly = true;
+    } else if (key == METRICS_KEY) {
+      metrics.clear();
+      for (const auto& token : key_options) {
+        const auto metric = histo::decodeMetric(token);
+        if (!metric) {
           throw cpet::invalid_option(
-              "Invalid Option: topology requires bin to be numeric");
+              "Invalid Option: Unknown distance metric specified " + token);
         }
-        bins = {std::stoi(*key_options.begin()),
-                std::stoi(*key_options.begin())};
-      } else {
-        if (!util::isDouble(*key_options.begin()) ||
-            !util::isDouble(*(key_options.begin() + 1))) {
-          throw cpet::invalid_option(
-              "Invalid Option: topology requires bin to be numeric");
+        if (std::find(metrics.begin(), metrics.end(), *metric) ==
+            metrics.end()) {
+          metrics.emplace_back(*metric);
         }
-        bins = {std::stoi(*key_options.begin()),
-                std::stoi(*(key_options.begin() + 1))};
       }
-    } else if (key == MATRIX_OUTPUT_KEY) {
-      matrixOutput = *key_options.begin();
+    } else if (key == MATRIX_FORMAT_KEY) {
+      const auto format = util::tolower(*key_options.begin());
+      if (format != "binary" && format != "text") {
+        throw cpet::invalid_option(
+            "Invalid Option: matrixFormat should be text or binary");
+      }
+      binaryMatrix = (format == "binary");
+    } else if (key == CLUSTER_KEY) {
+      if (key_options.size() < 2) {
+        throw cpet::invalid_option(
+            "Invalid Option: cluster expects a method and number of clusters");
+      }
+      const auto method = cluster::decodeMethod(key_options[0]);
+      if (!method) {
+        throw cpet::invalid_option(
+            "Invalid Option: Unknown cluster method specified " +
+            key_options[0]);
+      }
+      if (!util::isDouble(key_options[1])) {
+        throw cpet::invalid_option(
+            "Invalid Option: number of clusters should be numeric");
+      }
+      const int numberOfClusters = std::stoi(key_options[1]);
+      if (numberOfClusters <= 0) {
+        throw cpet::invalid_option(
+            "Invalid Option: number of clusters should be > 0");
+      }
+      clusterOptions = cluster::Options{*method, numberOfClusters};
+    } else if (key == CLUSTER_OUTPUT_KEY) {
+      clusterOutput = *key_options.begin();
+    } else if (key == CLUSTER_METRIC_KEY) {
+      clusterMetric = histo::decodeMetric(*key_options.begin());
+      if (!clusterMetric) {
+        throw cpet::invalid_option(
+            "Invalid Option: Unknown cluster metric specified " +
+            *key_options.begin());
+      }
+    } else if (key == NEIGHBORS_KEY) {
+      if (!util::isDouble(*key_options.begin())) {
+        throw cpet::invalid_option(
+            "Invalid Option: number of neighbors should be numeric");
+      }
+      const int neighbors = std::stoi(*key_options.begin());
+      if (neighbors <= 0) {
+        throw cpet::invalid_option(
+            "Invalid Option: number of neighbors should be > 0");
+      }
+      approximate = sketch::Options{neighbors};
+    } else if (key == SKETCH_SIZE_KEY) {
+      if (!util::isDouble(*key_options.begin())) {
+        throw cpet::invalid_option(
+            "Invalid Option: sketch size should be numeric");
+      }
+      sketchSize = std::stoi(*key_options.begin());
+      if (*sketchSize <= 0) {
+        throw cpet::invalid_option(
+            "Invalid Option: sketch size should be > 0");
+      }
+    } else if (key == REFINE_KEY) {
+      refine = (util::tolower(*key_options.begin()) == "true");
+    } else if (key == NEIGHBORS_OUTPUT_KEY) {
+      neighborsOutput = *key_options.begin();
     } else {
       SPDLOG_WARN("Unknown key specified in block topology: {}", key);
     }
@@ -190,15 +478,82 @@ TopologyRegion TopologyRegion::fromBlock(
 
   if (sampleInput) {
     result.sampleInput(*sampleInput);
-    if (!bins) {
+    if (bins.empty()) {
       throw cpet::invalid_option(
           "Invalid Option: sampleInput specified but no bins specified!");
     }
   }
-  result.bins_ = bins;
+  if (histogramInput) {
+    if (sampleInput) {
+      throw cpet::invalid_option(
+          "Invalid Option: cannot specify both sampleInput and "
+          "histogramInput!");
+    }
+    result.histogramInput(*histogramInput);
+  }
+  if (histogramOutput) {
+    if (bins.empty() && !histogramInput) {
+      throw cpet::invalid_option(
+          "Invalid Option: histogramOutput specified but no bins specified!");
+    }
+    result.histogramOutput(*histogramOutput);
+  }
+
+  if (!bins.empty()) {
+    result.bins_ = bins.front();
+  }
+  result.resolutions_ = bins;
+  result.metrics_ = metrics;
+  result.binaryMatrix_ = binaryMatrix;
   if (matrixOutput) {
     result.matrixOutput(*matrixOutput);
   }
+
+  if (clusterOptions) {
+    if (!result.computeMatrix()) {
+      throw cpet::invalid_option(
+          "Invalid Option: cluster specified but no bins specified!");
+    }
+    /* Clusters come from a single distance matrix */
+    if (!clusterMetric) {
+      if (metrics.size() > 1) {
+        throw cpet::invalid_option(
+            "Invalid Option: several metrics specified, clusterMetric should "
+            "name the one to cluster with");
+      }
+      clusterMetric = metrics.front();
+    }
+    if (std::find(metrics.begin(), metrics.end(), *clusterMetric) ==
+        metrics.end()) {
+      throw cpet::invalid_option(
+          "Invalid Option: clusterMetric is not one of the metrics");
+    }
+    result.clusterMetric_ = *clusterMetric;
+    result.cluster_ = clusterOptions;
+    if (clusterOutput) {
+      result.clusterOutput(*clusterOutput);
+    }
+  }
+
+  if (approximate) {
+    if (!result.computeMatrix()) {
+      throw cpet::invalid_option(
+          "Invalid Option: neighbors specified but no bins specified!");
+    }
+    if (clusterOptions || matrixOutput) {
+      throw cpet::invalid_option(
+          "Invalid Option: neighbors does not compute the full distance "
+          "matrix, cannot be combined with cluster or matrixOutput");
+    }
+    if (sketchSize) {
+      approximate->sketchSize = *sketchSize;
+    }
+    approximate->refine = refine;
+    result.approximate_ = approximate;
+    if (neighborsOutput) {
+      result.neighborsOutput(*neighborsOutput);
+    }
+  }
   return result;
 }
 
@@ -224,49 +579,35 @@ void TopologyRegion::writeSampleOutput_(const std::vector<PathSample>& data,
     throw cpet::io_error("Could not open file " + file);
   }
 }
-std::vector<std::vector<PathSample>> TopologyRegion::loadSampleData_() const {
+std::vector<std::vector<PathSample>> TopologyRegion::loadSampleData_(
+    const int numberOfThreads) const {
   assert(static_cast<bool>(sampleInput_));
 
   SPDLOG_INFO("Loading in pre-sampled data with prefix {}", *sampleInput_);
-  std::vector<std::vector<PathSample>> data;
+  std::vector<std::string> files;
   auto nextFileName = [&, index = 0]() mutable {
     return *sampleInput_ + '_' + std::to_string(index++) + ".top";
   };
   std::string filename;
   while (std::filesystem::exists(filename = nextFileName())) {
-    SPDLOG_DEBUG("Loading in data from file {}", filename);
-    std::vector<PathSample> tmpData;
-    util::forEachLineIn(filename, [&,
-                                   linenumber = 0](const auto& line) mutable {
-      if (!line.empty() && !util::startswith(line, "#")) {
-        const auto tokens = util::split(line, ',');
-        if (tokens.size() != 2) {
-          SPDLOG_WARN(
-              "topology data file {} contains invalid number of entries on "
-              "line {}",
-              filename, linenumber);
-        } else if (std::all_of(tokens.begin(), tokens.end(), util::isDouble)) {
-          tmpData.emplace_back(
-              PathSample{std::stod(tokens.at(0)), std::stod(tokens.at(1))});
-        } else {
-          SPDLOG_WARN(
-              "topology data file {} has non-numeric types in data section in "
-              "line {}",
-              filename, linenumber);
-        }
-      }
-      ++linenumber;
-    });
-    SPDLOG_INFO("Loaded file: {}", filename);
-    data.emplace_back(std::move(tmpData));
+    files.emplace_back(std::move(filename));
   }
+
+  /* Files are independent, each worker fills its own slots */
+  std::vector<std::vector<PathSample>> data(files.size());
+  util::forEachChunk(files.size(), numberOfThreads,
+                     [&](const size_t begin, const size_t end, size_t) {
+                       for (size_t i = begin; i < end; ++i) {
+                         data[i] = readSampleFile(files[i]);
+                       }
+                     });
   SPDLOG_INFO("Loaded in {} topology sample files", data.size());
   return data;
 }
-std::vector<std::vector<double>> TopologyRegion::constructHistograms_(
+std::vector<histo::HistogramSet> TopologyRegion::constructHistograms_(
     const std::vector<std::vector<PathSample>>& sampleData) const {
   Timer t;
-  std::vector<std::vector<double>> histograms;
+  std::vector<histo::HistogramSet> histogramSets;
 
   const auto sampleDataFlatten = util::flatten(sampleData);
 
@@ -287,7 +628,10 @@ std::vector<std::vector<double>> TopologyRegion::constructHistograms_(
                      round(ymax->distance * 1000.0) / 1000.0};
 
   SPDLOG_INFO("====[Computing  Histograms]====");
-  SPDLOG_INFO("[Bins] ==>> {} x {}", (*bins_)[0], (*bins_)[1]);
+  for (const auto& bins : resolutions_) {
+    SPDLOG_INFO("[Bins] ==>> {} x {}", bins[0], bins[1]);
+    histogramSets.push_back({bins, xlim, ylim, {}});
+  }
   SPDLOG_INFO("[XLim] ==>> [{}, {}]", xlim[0], xlim[1]);
   SPDLOG_INFO("[YLim] ==>> [{}, {}]", ylim[0], ylim[1]);
 
@@ -301,50 +645,149 @@ std::vector<std::vector<double>> TopologyRegion::constructHistograms_(
                     distances.emplace_back(sample.distance);
                   });
 
-    const auto temp_histo =
-        histo::construct2DHistogram(distances, curvatures, *bins_, xlim, ylim);
-    histograms.emplace_back(histo::normalize(util::flatten(temp_histo)));
+    const auto temp_histos = histo::construct2DHistograms(
+        distances, curvatures, resolutions_, xlim, ylim);
+    for (size_t i = 0; i < temp_histos.size(); ++i) {
+      histogramSets[i].histograms.emplace_back(
+          histo::normalize(util::flatten(temp_histos[i])));
+    }
   }
 
-  return histograms;
+  return histogramSets;
 }
-std::vector<std::vector<double>> TopologyRegion::constructMatrix_(
-    const std::vector<std::vector<double>>& histograms) {
+std::vector<std::vector<std::vector<double>>>
+TopologyRegion::constructMatrices_(
+    const std::vector<std::vector<double>>& histograms,
+    const std::vector<histo::Metric>& metrics, int numberOfThreads) {
   Timer t;
-  std::vector<std::vector<double>> result;
-  result.reserve(histograms.size());
-
-  std::transform(
-      histograms.begin(), histograms.end(), std::back_inserter(result),
-      [&](const auto& h1) {
-        std::vector<double> tempRow;
-        tempRow.reserve(histograms.size());
-        std::transform(
-            histograms.begin(), histograms.end(), std::back_inserter(tempRow),
-            [&](const auto& h2) { return histo::chiDistance(h1, h2); });
-        return tempRow;
+  const auto n = histograms.size();
+  std::vector<std::vector<std::vector<double>>> result(
+      metrics.size(),
+      std::vector<std::vector<double>>(n, std::vector<double>(n, 0.0)));
+
+  /* Every metric is symmetric, so only the upper triangle is swept; each
+   * pair is visited once and yields all of the requested metrics. Row i holds
+   * n - i pairs, so rows are dealt out round robin rather than in contiguous
+   * ranges to give every thread a similar number of pairs. */
+  const auto stride =
+      std::clamp<size_t>(static_cast<size_t>(std::max(numberOfThreads, 1)), 1,
+                         std::max<size_t>(n, 1));
+  util::forEachChunk(
+      stride, numberOfThreads,
+      [&](const size_t begin, const size_t end, size_t) {
+        histo::Distances pairDistances{};
+        for (size_t first = begin; first < end; ++first) {
+          for (size_t i = first; i < n; i += stride) {
+            for (size_t j = i; j < n; ++j) {
+              histo::distances(histograms[i], histograms[j], metrics,
+                               pairDistances);
+              for (size_t m = 0; m < metrics.size(); ++m) {
+                result[m][i][j] = pairDistances[m];
+                result[m][j][i] = pairDistances[m];
+              }
+            }
+          }
+        }
       });
 
   return result;
 }
 void TopologyRegion::writeMatrixOutput_(
-    const std::vector<std::vector<double>>& matrix) const {
+    const std::vector<std::vector<double>>& matrix,
+    const std::array<int, 2>& bins, const histo::Metric metric,
+    const int numberOfThreads) const {
   assert(static_cast<bool>(matrixOutput_));
   if (!matrixOutput_) {
     return;
   }
   SPDLOG_DEBUG("Writing matrix results");
 
-  const auto file = *matrixOutput_;
+  auto file = resolutionFile_(*matrixOutput_, bins);
+  if (metrics_.size() > 1) {
+    file = tagFile(file, histo::metricName(metric));
+  }
+
+  if (binaryMatrix_) {
+    writeBinaryMatrix_(file, matrix, bins, metric);
+    return;
+  }
+  if (util::isNpyFile(file)) {
+    const auto cols = matrix.empty() ? 0 : matrix.front().size();
+    util::writeNpy(file, {matrix.size(), cols},
+                   util::Chunks(matrix.begin(), matrix.end()));
+    return;
+  }
+
   std::ofstream outFile(file, std::ios::out);
   if (outFile.is_open()) {
-    outFile << "#Bins: " << (*bins_)[0] << 'x' << (*bins_)[1] << '\n';
+    outFile << "#Bins: " << bins[0] << 'x' << bins[1];
+    if (metric != histo::Metric::chi) {
+      outFile << "; Metric: " << histo::metricName(metric);
+    }
+    outFile << '\n';
+    constexpr int precision = 4;
+    util::writeRows(outFile, matrix.size(), numberOfThreads,
+                    [&](util::TextBuffer& buffer, const size_t i) {
+                      for (const auto& col : matrix[i]) {
+                        buffer.appendFixed(col, precision);
+                        buffer.append(' ');
+                      }
+                      buffer.append('\n');
+                    });
+    outFile << std::flush;
+  } else {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+}
+void TopologyRegion::writeClusterOutput_(
+    const cluster::Result& clusters, const std::array<int, 2>& bins) const {
+  assert(static_cast<bool>(clusterOutput_) && static_cast<bool>(cluster_));
+  if (!clusterOutput_ || !cluster_) {
+    return;
+  }
+  SPDLOG_DEBUG("Writing cluster results");
+
+  const auto file = resolutionFile_(*clusterOutput_, bins);
+  std::ofstream outFile(file, std::ios::out);
+  if (outFile.is_open()) {
+    outFile << "#Method: " << cluster::methodName(cluster_->method)
+            << "; Clusters: " << clusters.medoids.size() << '\n';
+    outFile << "#Medoids:";
+    for (const auto& medoid : clusters.medoids) {
+      outFile << ' ' << medoid;
+    }
+    outFile << '\n';
+    std::for_each(clusters.labels.begin(), clusters.labels.end(),
+                  [&outFile](const auto& label) { outFile << label << '\n'; });
+    outFile << std::flush;
+  } else {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+}
+void TopologyRegion::writeNeighborsOutput_(
+    const sketch::Graph& graph, const std::array<int, 2>& bins) const {
+  assert(static_cast<bool>(neighborsOutput_) &&
+         static_cast<bool>(approximate_));
+  if (!neighborsOutput_ || !approximate_) {
+    return;
+  }
+  SPDLOG_DEBUG("Writing neighbor graph results");
+
+  const auto file = resolutionFile_(*neighborsOutput_, bins);
+  std::ofstream outFile(file, std::ios::out);
+  if (outFile.is_open()) {
+    outFile << "#Bins: " << bins[0] << 'x' << bins[1]
+            << "; Neighbors: " << approximate_->neighbors
+            << "; Distance: " << (approximate_->refine ? "chi" : "hellinger")
+            << '\n';
     outFile << std::fixed << std::setprecision(4);
-    for (const auto& row : matrix) {
-      for (const auto& col : row) {
-        outFile << col << ' ';
+    for (size_t i = 0; i < graph.size(); ++i) {
+      for (const auto& neighbor : graph[i]) {
+        outFile << i << ' ' << neighbor.index << ' ' << neighbor.distance
+                << '\n';
       }
-      outFile << '\n';
     }
     outFile << std::flush;
   } else {
@@ -353,4 +796,52 @@ void TopologyRegion::writeMatrixOutput_(
   }
 }
 
+std::string TopologyRegion::resolutionFile_(
+    const std::string& file, const std::array<int, 2>& bins) const {
+  if (resolutions_.size() <= 1) {
+    return file;
+  }
+  /* Multiple resolutions share one output option, tag each file by its bins */
+  return tagFile(file,
+                 std::to_string(bins[0]) + 'x' + std::to_string(bins[1]));
+}
+
+void TopologyRegion::writeBinaryMatrix_(
+    const std::string& file, const std::vector<std::vector<double>>& matrix,
+    const std::array<int, 2>& bins, const histo::Metric metric) {
+  /* Binary layout (native endianness):
+   *   char[8]  magic "CPETDMAT"
+   *   uint32   version
+   *   uint32   metric
+   *   int32[2] bins
+   *   uint64   number of rows
+   *   uint64   number of columns
+   *   f64[]    row-major matrix */
+  constexpr std::array<char, 8> MATRIX_MAGIC = {'C', 'P', 'E', 'T',
+                                                'D', 'M', 'A', 'T'};
+  constexpr uint32_t MATRIX_VERSION = 1;
+
+  std::ofstream outFile(file, std::ios::out | std::ios::binary);
+  if (!outFile.is_open()) {
+    SPDLOG_ERROR("Could not open file {}", file);
+    throw cpet::io_error("Could not open file " + file);
+  }
+
+  const auto metricIndex = static_cast<uint32_t>(metric);
+  const std::array<int32_t, 2> binsHeader = {bins[0], bins[1]};
+  const uint64_t rows = matrix.size();
+  const uint64_t cols = matrix.empty() ? 0 : matrix.front().size();
+
+  util::writeBinary(outFile, MATRIX_MAGIC.data(), MATRIX_MAGIC.size());
+  util::writeBinary(outFile, &MATRIX_VERSION, 1);
+  util::writeBinary(outFile, &metricIndex, 1);
+  util::writeBinary(outFile, binsHeader.data(), binsHeader.size());
+  util::writeBinary(outFile, &rows, 1);
+  util::writeBinary(outFile, &cols, 1);
+  for (const auto& row : matrix) {
+    util::writeBinary(outFile, row.data(), row.size());
+  }
+  outFile << std::flush;
+}
+
 }  // namespace cpet
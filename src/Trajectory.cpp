@@ -0,0 +1,604 @@
+// Copyright(c) 2020-Present, Matthew R. Hennefarth
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#include "Trajectory.h"
+
+/* C++ STL HEADER FILES */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+/* EXTERNAL LIBRARY HEADER FILES */
+#include <spdlog/spdlog.h>
+
+/* CPET HEADER FILES */
+#include "Exceptions.h"
+#include "RAIIThread.h"
+#include "Utilities.h"
+
+namespace cpet::trajectory {
+
+namespace {
+constexpr double NM_TO_ANGSTROM = 10.0;
+
+constexpr uint32_t DCD_HEADER_SIZE = 84;
+constexpr size_t DCD_CONTROL_WORDS = 20;
+constexpr size_t DCD_FIXED_ATOMS_INDEX = 8;
+constexpr size_t DCD_UNIT_CELL_INDEX = 10;
+constexpr size_t DCD_FOUR_DIMENSIONS_INDEX = 11;
+constexpr size_t DCD_CHARMM_VERSION_INDEX = 19;
+constexpr size_t DCD_UNIT_CELL_SIZE = 6 * sizeof(double);
+
+constexpr int32_t XTC_MAGIC = 1995;
+/* magic, natoms, step, time, box[9], natoms */
+constexpr size_t XTC_HEADER_SIZE = 56;
+/* ... precision, minint[3], maxint[3], smallidx, byte count */
+constexpr size_t XTC_COMPRESSED_HEADER_SIZE = 92;
+constexpr size_t XTC_UNCOMPRESSED_ATOMS = 9;
+
+/* Integer magnitudes used by the xdrfile compression, indexed by smallidx */
+constexpr std::array<int, 73> MAGIC_INTS = {
+    0,        0,        0,       0,       0,       0,       0,       0,
+    0,        8,        10,      12,      16,      20,      25,      32,
+    40,       50,       64,      80,      101,     128,     161,     203,
+    256,      322,      406,     512,     645,     812,     1024,    1290,
+    1625,     2048,     2580,    3250,    4096,    5060,    6501,    8192,
+    10321,    13003,    16384,   20642,   26007,   32768,   41285,   52015,
+    65536,    82570,    104031,  131072,  165140,  208063,  262144,  330280,
+    416127,   524287,   660561,  832255,  1048576, 1321122, 1664510, 2097152,
+    2642245,  3329021,  4194304, 5284491, 6658042, 8388607, 10568983,
+    13316085, 16777216};
+constexpr int FIRST_INDEX = 9;
+constexpr int LAST_INDEX = static_cast<int>(MAGIC_INTS.size());
+
+[[nodiscard]] inline uint32_t byteswap(const uint32_t value) noexcept {
+  return ((value & 0xffU) << 24U) | ((value & 0xff00U) << 8U) |
+         ((value & 0xff0000U) >> 8U) | ((value & 0xff000000U) >> 24U);
+}
+
+[[nodiscard]] inline float toFloat(const uint32_t bits) noexcept {
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/* XDR is big endian regardless of the machine that wrote it */
+[[nodiscard]] inline uint32_t xdrWord(const unsigned char* data) noexcept {
+  return (static_cast<uint32_t>(data[0]) << 24U) |
+         (static_cast<uint32_t>(data[1]) << 16U) |
+         (static_cast<uint32_t>(data[2]) << 8U) |
+         static_cast<uint32_t>(data[3]);
+}
+
+[[nodiscard]] inline int32_t xdrInt(const unsigned char* data) noexcept {
+  return static_cast<int32_t>(xdrWord(data));
+}
+
+[[nodiscard]] inline float xdrFloat(const unsigned char* data) noexcept {
+  return toFloat(xdrWord(data));
+}
+
+[[nodiscard]] int sizeOfInt(const uint32_t size) noexcept {
+  uint32_t num = 1;
+  int numberOfBits = 0;
+  while (size >= num && numberOfBits < 32) {
+    ++numberOfBits;
+    num <<= 1U;
+  }
+  return numberOfBits;
+}
+
+/* Bits needed to store the product of sizes as one big integer */
+[[nodiscard]] int sizeOfInts(const std::array<uint32_t, 3>& sizes) noexcept {
+  std::array<uint32_t, 32> bytes{};
+  bytes[0] = 1;
+  size_t numberOfBytes = 1;
+  for (const auto& size : sizes) {
+    uint32_t tmp = 0;
+    size_t byteCount = 0;
+    for (; byteCount < numberOfBytes; ++byteCount) {
+      tmp = bytes[byteCount] * size + tmp;
+      bytes[byteCount] = tmp & 0xffU;
+      tmp >>= 8U;
+    }
+    while (tmp != 0) {
+      bytes[byteCount++] = tmp & 0xffU;
+      tmp >>= 8U;
+    }
+    numberOfBytes = byteCount;
+  }
+
+  int numberOfBits = 0;
+  uint32_t num = 1;
+  --numberOfBytes;
+  while (bytes[numberOfBytes] >= num) {
+    ++numberOfBits;
+    num *= 2;
+  }
+  return numberOfBits + static_cast<int>(numberOfBytes) * 8;
+}
+
+/* Bit stream reader matching receivebits/receiveints from xdrfile */
+class BitReader {
+ public:
+  BitReader(const unsigned char* data, const size_t size) noexcept
+      : data_(data), size_(size) {}
+
+  [[nodiscard]] uint32_t bits(int numberOfBits) {
+    const uint32_t mask = (numberOfBits >= 32)
+                              ? 0xffffffffU
+                              : ((1U << static_cast<uint32_t>(numberOfBits)) -
+                                 1U);
+    uint32_t num = 0;
+    while (numberOfBits >= 8) {
+      lastByte_ = (lastByte_ << 8U) | nextByte_();
+      num |= (lastByte_ >> lastBits_)
+             << static_cast<uint32_t>(numberOfBits - 8);
+      numberOfBits -= 8;
+    }
+    if (numberOfBits > 0) {
+      const auto n = static_cast<uint32_t>(numberOfBits);
+      if (lastBits_ < n) {
+        lastBits_ += 8;
+        lastByte_ = (lastByte_ << 8U) | nextByte_();
+      }
+      lastBits_ -= n;
+      num |= (lastByte_ >> lastBits_) & ((1U << n) - 1U);
+    }
+    return num & mask;
+  }
+
+  void ints(int numberOfBits, const std::array<uint32_t, 3>& sizes,
+            std::array<int, 3>& nums) {
+    std::array<uint32_t, 32> bytes{};
+    int numberOfBytes = 0;
+    while (numberOfBits > 8) {
+      bytes[static_cast<size_t>(numberOfBytes++)] = bits(8);
+      numberOfBits -= 8;
+    }
+    if (numberOfBits > 0) {
+      bytes[static_cast<size_t>(numberOfBytes++)] = bits(numberOfBits);
+    }
+    for (size_t i = 2; i > 0; --i) {
+      uint32_t num = 0;
+      for (int j = numberOfBytes - 1; j >= 0; --j) {
+        auto& byte = bytes[static_cast<size_t>(j)];
+        num = (num << 8U) | byte;
+        const uint32_t p = num / sizes[i];
+        byte = p;
+        num -= p * sizes[i];
+      }
+      nums[i] = static_cast<int>(num);
+    }
+    nums[0] = static_cast<int>(bytes[0] | (bytes[1] << 8U) |
+                               (bytes[2] << 16U) | (bytes[3] << 24U));
+  }
+
+ private:
+  const unsigned char* data_;
+  size_t size_;
+  size_t count_{0};
+  uint32_t lastBits_{0};
+  uint32_t lastByte_{0};
+
+  [[nodiscard]] uint32_t nextByte_() {
+    if (count_ >= size_) {
+      throw cpet::value_error("Compressed XTC coordinates are truncated");
+    }
+    return data_[count_++];
+  }
+};
+
+[[nodiscard]] std::vector<size_t> selectFrames(const size_t numberOfFrames,
+                                               const int start,
+                                               const int skip) {
+  std::vector<size_t> selected;
+  const auto step = static_cast<size_t>(std::max(skip, 1));
+  for (auto frame = static_cast<size_t>(std::max(start, 0));
+       frame < numberOfFrames; frame += step) {
+    selected.emplace_back(frame);
+  }
+  return selected;
+}
+
+void checkTopology(const Reader& reader, const Frame& topology) {
+  const auto atoms = topology.size();
+  if (reader.numberOfAtoms() != atoms) {
+    SPDLOG_ERROR("Trajectory atoms: {}, topology atoms: {}",
+                 reader.numberOfAtoms(), atoms);
+    throw cpet::value_error(
+        "Inconsistent number of atoms in trajectory and in topology file");
+  }
+  SPDLOG_DEBUG("Trajectory has {} frames of {} atoms", reader.numberOfFrames(),
+               atoms);
+}
+
+/* Decodes frames[begin, end) into copies of the topology, in parallel */
+void decodeInto(const Reader& reader, const std::vector<size_t>& frames,
+                const size_t begin, std::vector<Frame>& result,
+                const int numberOfThreads) {
+  util::forEachChunk(
+      result.size(), numberOfThreads,
+      [&](const size_t first, const size_t last, size_t) {
+        for (size_t i = first; i < last; ++i) {
+          reader.read(frames[begin + i], result[i].coordinates());
+        }
+      });
+}
+}  // namespace
+
+void Reader::checkRead_(const size_t frame,
+                        util::Span<const Eigen::Vector3d> coordinates) const {
+  if (frame >= numberOfFrames()) {
+    throw cpet::value_error("Frame " + std::to_string(frame) +
+                            " is out of range for " + file_);
+  }
+  if (coordinates.size() != numberOfAtoms()) {
+    throw cpet::value_error("Frame of " + std::to_string(numberOfAtoms()) +
+                            " atoms read into " +
+                            std::to_string(coordinates.size()) +
+                            " coordinates");
+  }
+}
+
+std::optional<Format> formatOf(const std::string& file) noexcept {
+  const auto extension = util::tolower(file.substr(file.rfind('.') + 1));
+  if (extension == "dcd") {
+    return Format::dcd;
+  }
+  if (extension == "xtc") {
+    return Format::xtc;
+  }
+  return std::nullopt;
+}
+
+std::unique_ptr<Reader> Reader::open(const std::string& file) {
+  switch (formatOf(file).value_or(Format::dcd)) {
+    case Format::xtc:
+      return std::make_unique<XTCReader>(file);
+    case Format::dcd:
+    default:
+      return std::make_unique<DCDReader>(file);
+  }
+}
+
+DCDReader::DCDReader(const std::string& file) : Reader(file) {
+  const auto data = mappedFile_.view();
+  const auto word = [&](const size_t offset) -> uint32_t {
+    if (offset + sizeof(uint32_t) > data.size()) {
+      throw cpet::value_error("Truncated DCD header in " + file_);
+    }
+    uint32_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return swapped_ ? byteswap(value) : value;
+  };
+
+  /* The first record marker tells us the endianness of the writer */
+  if (word(0) != DCD_HEADER_SIZE) {
+    swapped_ = true;
+    if (word(0) != DCD_HEADER_SIZE) {
+      throw cpet::value_error(file_ + " is not a DCD file");
+    }
+  }
+  if (data.substr(4, 4) != "CORD") {
+    throw cpet::value_error(file_ + " is not a DCD coordinate file");
+  }
+
+  std::array<uint32_t, DCD_CONTROL_WORDS> control{};
+  for (size_t i = 0; i < control.size(); ++i) {
+    control[i] = word(8 + sizeof(uint32_t) * i);
+  }
+  size_t offset = 8 + sizeof(uint32_t) * DCD_CONTROL_WORDS;
+  if (word(offset) != DCD_HEADER_SIZE) {
+    throw cpet::value_error("Corrupt DCD header in " + file_);
+  }
+  offset += sizeof(uint32_t);
+
+  if (control[DCD_FIXED_ATOMS_INDEX] != 0) {
+    throw cpet::value_error("DCD files with fixed atoms are not supported");
+  }
+  const bool charmm = control[DCD_CHARMM_VERSION_INDEX] != 0;
+  const bool unitCell = charmm && control[DCD_UNIT_CELL_INDEX] != 0;
+  const bool fourDimensions =
+      charmm && control[DCD_FOUR_DIMENSIONS_INDEX] != 0;
+
+  /* Title record, its contents are not needed */
+  const auto titleSize = word(offset);
+  offset += sizeof(uint32_t) + titleSize;
+  if (word(offset) != titleSize) {
+    throw cpet::value_error("Corrupt DCD title in " + file_);
+  }
+  offset += sizeof(uint32_t);
+
+  if (word(offset) != sizeof(uint32_t) ||
+      word(offset + 2 * sizeof(uint32_t)) != sizeof(uint32_t)) {
+    throw cpet::value_error("Corrupt DCD atom count in " + file_);
+  }
+  numberOfAtoms_ = word(offset + sizeof(uint32_t));
+  offset += 3 * sizeof(uint32_t);
+
+  firstFrame_ = offset;
+  unitCellSize_ = unitCell ? DCD_UNIT_CELL_SIZE + 2 * sizeof(uint32_t) : 0;
+  const auto coordinateRecord =
+      numberOfAtoms_ * sizeof(float) + 2 * sizeof(uint32_t);
+  frameSize_ = unitCellSize_ + (fourDimensions ? 4 : 3) * coordinateRecord;
+
+  /* NSET is unreliable for files that are still being written */
+  numberOfFrames_ = (data.size() - firstFrame_) / frameSize_;
+  if ((data.size() - firstFrame_) % frameSize_ != 0) {
+    SPDLOG_WARN("Ignoring truncated last frame in {}", file_);
+  }
+}
+
+void DCDReader::read(const size_t frame,
+                     util::Span<Eigen::Vector3d> coordinates) const {
+  checkRead_(frame, coordinates);
+
+  const auto* record = mappedFile_.view().data() + firstFrame_ +
+                       frame * frameSize_ + unitCellSize_;
+  const auto word = [this](const char* data) -> uint32_t {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return swapped_ ? byteswap(value) : value;
+  };
+
+  const auto recordSize = numberOfAtoms_ * sizeof(float);
+  for (Eigen::Index axis = 0; axis < 3; ++axis) {
+    if (word(record) != recordSize) {
+      throw cpet::value_error("Corrupt DCD frame " + std::to_string(frame) +
+                              " in " + file_);
+    }
+    record += sizeof(uint32_t);
+    for (auto& coordinate : coordinates) {
+      coordinate[axis] = toFloat(word(record));
+      record += sizeof(float);
+    }
+    record += sizeof(uint32_t);
+  }
+}
+
+XTCReader::XTCReader(const std::string& file) : Reader(file) {
+  const auto data = mappedFile_.view();
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+  size_t offset = 0;
+  while (offset < data.size()) {
+    if (offset + XTC_HEADER_SIZE > data.size()) {
+      SPDLOG_WARN("Ignoring truncated last frame in {}", file_);
+      break;
+    }
+    if (xdrInt(bytes + offset) != XTC_MAGIC) {
+      throw cpet::value_error("Bad magic number in XTC file " + file_);
+    }
+    const auto atoms = xdrInt(bytes + offset + sizeof(int32_t));
+    if (atoms < 0) {
+      throw cpet::value_error("Corrupt XTC frame header in " + file_);
+    }
+    if (offsets_.empty()) {
+      numberOfAtoms_ = static_cast<size_t>(atoms);
+    } else if (static_cast<size_t>(atoms) != numberOfAtoms_) {
+      throw cpet::value_error("Number of atoms changes within " + file_);
+    }
+
+    /* Skip over the frame using only its header, nothing is decoded */
+    size_t frameSize = XTC_HEADER_SIZE + 3 * sizeof(float) * numberOfAtoms_;
+    if (numberOfAtoms_ > XTC_UNCOMPRESSED_ATOMS) {
+      if (offset + XTC_COMPRESSED_HEADER_SIZE > data.size()) {
+        SPDLOG_WARN("Ignoring truncated last frame in {}", file_);
+        break;
+      }
+      const auto byteCount = static_cast<size_t>(
+          xdrWord(bytes + offset + XTC_COMPRESSED_HEADER_SIZE - 4));
+      frameSize = XTC_COMPRESSED_HEADER_SIZE + ((byteCount + 3) & ~size_t{3});
+    }
+    if (offset + frameSize > data.size()) {
+      SPDLOG_WARN("Ignoring truncated last frame in {}", file_);
+      break;
+    }
+    offsets_.emplace_back(offset);
+    offset += frameSize;
+  }
+}
+
+void XTCReader::read(const size_t frame,
+                     util::Span<Eigen::Vector3d> coordinates) const {
+  checkRead_(frame, coordinates);
+  const auto* bytes =
+      reinterpret_cast<const unsigned char*>(mappedFile_.view().data()) +
+      offsets_[frame];
+
+  if (numberOfAtoms_ <= XTC_UNCOMPRESSED_ATOMS) {
+    const auto* values = bytes + XTC_HEADER_SIZE;
+    for (auto& coordinate : coordinates) {
+      for (Eigen::Index axis = 0; axis < 3; ++axis) {
+        coordinate[axis] =
+            NM_TO_ANGSTROM * static_cast<double>(xdrFloat(values));
+        values += sizeof(float);
+      }
+    }
+    return;
+  }
+
+  const float precision = xdrFloat(bytes + XTC_HEADER_SIZE);
+  std::array<int, 3> minInt{};
+  std::array<uint32_t, 3> sizeInt{};
+  for (size_t d = 0; d < 3; ++d) {
+    minInt[d] = xdrInt(bytes + XTC_HEADER_SIZE + 4 + 4 * d);
+    const auto maxInt = xdrInt(bytes + XTC_HEADER_SIZE + 16 + 4 * d);
+    sizeInt[d] = static_cast<uint32_t>(maxInt - minInt[d] + 1);
+  }
+
+  /* Large ranges are stored one coordinate at a time */
+  std::array<int, 3> bitSizeInt{};
+  int bitSize = 0;
+  if ((sizeInt[0] | sizeInt[1] | sizeInt[2]) > 0xffffffU) {
+    for (size_t d = 0; d < 3; ++d) {
+      bitSizeInt[d] = sizeOfInt(sizeInt[d]);
+    }
+  } else {
+    bitSize = sizeOfInts(sizeInt);
+  }
+
+  int smallIndex = xdrInt(bytes + XTC_HEADER_SIZE + 28);
+  if (smallIndex < FIRST_INDEX || smallIndex >= LAST_INDEX) {
+    throw cpet::value_error("Corrupt XTC frame " + std::to_string(frame) +
+                            " in " + file_);
+  }
+  const auto magic = [](const int index) {
+    return MAGIC_INTS[static_cast<size_t>(index)];
+  };
+  int smaller = magic(std::max(FIRST_INDEX, smallIndex - 1)) / 2;
+  int smallNumber = magic(smallIndex) / 2;
+  std::array<uint32_t, 3> sizeSmall{};
+  sizeSmall.fill(static_cast<uint32_t>(magic(smallIndex)));
+
+  BitReader reader(bytes + XTC_COMPRESSED_HEADER_SIZE,
+                   xdrWord(bytes + XTC_COMPRESSED_HEADER_SIZE - 4));
+  const float inversePrecision = 1.0F / precision;
+  size_t written = 0;
+  const auto emit = [&](const std::array<int, 3>& coordinate) {
+    if (written >= numberOfAtoms_) {
+      throw cpet::value_error("Corrupt XTC frame " + std::to_string(frame) +
+                              " in " + file_);
+    }
+    for (size_t d = 0; d < 3; ++d) {
+      /* Scaled in float as GROMACS does, then converted */
+      const float nanometers =
+          static_cast<float>(coordinate[d]) * inversePrecision;
+      coordinates[written][static_cast<Eigen::Index>(d)] =
+          NM_TO_ANGSTROM * static_cast<double>(nanometers);
+    }
+    ++written;
+  };
+
+  std::array<int, 3> current{};
+  std::array<int, 3> previous{};
+  int run = 0;
+  size_t atom = 0;
+  while (atom < numberOfAtoms_) {
+    if (bitSize == 0) {
+      for (size_t d = 0; d < 3; ++d) {
+        current[d] = static_cast<int>(reader.bits(bitSizeInt[d]));
+      }
+    } else {
+      reader.ints(bitSize, sizeInt, current);
+    }
+    ++atom;
+    for (size_t d = 0; d < 3; ++d) {
+      current[d] += minInt[d];
+    }
+    previous = current;
+
+    /* run keeps its value from the previous atom when the flag is unset */
+    int isSmaller = 0;
+    if (reader.bits(1) == 1) {
+      run = static_cast<int>(reader.bits(5));
+      isSmaller = run % 3;
+      run -= isSmaller;
+      --isSmaller;
+    }
+
+    if (run > 0) {
+      for (int k = 0; k < run; k += 3) {
+        std::array<int, 3> small{};
+        reader.ints(smallIndex, sizeSmall, small);
+        ++atom;
+        for (size_t d = 0; d < 3; ++d) {
+          small[d] += previous[d] - smallNumber;
+        }
+        if (k == 0) {
+          /* The first two atoms of a run are stored swapped (water) */
+          std::swap(small, previous);
+          emit(previous);
+        } else {
+          previous = small;
+        }
+        emit(small);
+      }
+    } else {
+      emit(current);
+    }
+
+    smallIndex += isSmaller;
+    if (smallIndex < FIRST_INDEX || smallIndex >= LAST_INDEX) {
+      throw cpet::value_error("Corrupt XTC frame " + std::to_string(frame) +
+                              " in " + file_);
+    }
+    if (isSmaller < 0) {
+      smallNumber = smaller;
+      smaller = (smallIndex > FIRST_INDEX) ? magic(smallIndex - 1) / 2 : 0;
+    } else if (isSmaller > 0) {
+      smaller = smallNumber;
+      smallNumber = magic(smallIndex) / 2;
+    }
+    sizeSmall.fill(static_cast<uint32_t>(magic(smallIndex)));
+  }
+}
+
+std::vector<Frame> loadFrames(const std::string& file, const Frame& topology,
+                              const int start, const int skip,
+                              const int numberOfThreads) {
+  SPDLOG_DEBUG("Loading coordinate trajectory from {} ...", file);
+  return loadFrames(*Reader::open(file), topology, start, skip,
+                    numberOfThreads);
+}
+
+std::vector<Frame> loadFrames(const Reader& reader, const Frame& topology,
+                              const int start, const int skip,
+                              const int numberOfThreads) {
+  checkTopology(reader, topology);
+  const auto frames = selectFrames(reader.numberOfFrames(), start, skip);
+
+  /* All selected frames in a single block */
+  const auto atoms = topology.size();
+  CoordinateArena arena(frames.size() * atoms);
+  std::vector<Frame> result;
+  result.reserve(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    result.emplace_back(topology.sharedTopology(), arena.allocate(atoms));
+  }
+  decodeInto(reader, frames, 0, result, numberOfThreads);
+  return result;
+}
+
+void forEachFrame(const std::string& file, const Frame& topology,
+                  const int start, const int skip, const int numberOfThreads,
+                  const std::function<void(Frame)>& func) {
+  SPDLOG_DEBUG("Streaming coordinate trajectory from {} ...", file);
+  forEachFrame(*Reader::open(file), topology, start, skip, numberOfThreads,
+               func);
+}
+
+void forEachFrame(const Reader& reader, const Frame& topology,
+                  const int start, const int skip, const int numberOfThreads,
+                  const std::function<void(Frame)>& func) {
+  checkTopology(reader, topology);
+  const auto frames = selectFrames(reader.numberOfFrames(), start, skip);
+
+  const auto batchSize = static_cast<size_t>(std::max(numberOfThreads, 1));
+  const auto atoms = topology.size();
+  for (size_t begin = 0; begin < frames.size(); begin += batchSize) {
+    const auto size = std::min(batchSize, frames.size() - begin);
+    CoordinateArena arena(size * atoms);
+    std::vector<Frame> batch;
+    batch.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      batch.emplace_back(topology.sharedTopology(), arena.allocate(atoms));
+    }
+    decodeInto(reader, frames, begin, batch, numberOfThreads);
+    for (auto& frame : batch) {
+      func(std::move(frame));
+    }
+  }
+}
+
+Frame loadTopology(const std::string& file) {
+  SPDLOG_DEBUG("Loading topology from {} ...", file);
+  auto frames = Frame::loadFramesFromFile(file, 0, 1);
+  if (frames.empty()) {
+    throw cpet::value_error("No atoms found in topology file " + file);
+  }
+  return std::move(frames.front());
+}
+}  // namespace cpet::trajectory
@@ -9,6 +9,10 @@
 
 /* CPET HEADER FILES */
 #include "Box.h"
+#include "Cavity.h"
+#include "Cylinder.h"
+#include "Ellipsoid.h"
+#include "Sphere.h"
 #include "Exceptions.h"
 #include "Utilities.h"
 #include "AtomID.h"
@@ -44,12 +48,86 @@ std::unique_ptr<Volume> makeBox(const std::vector<std::string>& options) {
       center);
 }
 
+namespace {
+/* The first count options as doubles, and the center that may follow them */
+std::pair<std::vector<double>, Eigen::Vector3d> shapeParameters(
+    const std::vector<std::string>& options, const size_t count,
+    const std::string& shape, const std::string& values) {
+  if (options.size() < count) {
+    throw cpet::invalid_option("Invalid Option: " + shape + " requires " +
+                               std::to_string(count) + " values: " + values);
+  }
+  if (!std::all_of(options.begin(),
+                   options.begin() + static_cast<long>(count),
+                   util::isDouble)) {
+    throw cpet::invalid_option("Invalid Option: " + shape + " requires " +
+                               std::to_string(count) +
+                               " doubles, received other");
+  }
+
+  Eigen::Vector3d center = {0, 0, 0};
+  if (options.size() > count) {
+    if (!AtomID::isVector(options[count])) {
+      throw cpet::invalid_option("Invalid Option: " + shape +
+                                 " center is invalid position vector");
+    }
+    center = *AtomID(options[count]).position();
+  }
+
+  std::vector<double> parameters;
+  std::transform(options.begin(), options.begin() + static_cast<long>(count),
+                 std::back_inserter(parameters),
+                 [](const std::string& value) { return std::stod(value); });
+  return {parameters, center};
+}
+}  // namespace
+
+std::unique_ptr<Volume> makeSphere(const std::vector<std::string>& options) {
+  const auto [parameters, center] =
+      shapeParameters(options, 1, "Sphere", "r");
+  return std::make_unique<Sphere>(parameters[0], center);
+}
+
+std::unique_ptr<Volume> makeCylinder(const std::vector<std::string>& options) {
+  const auto [parameters, center] =
+      shapeParameters(options, 2, "Cylinder", "r, half length");
+  return std::make_unique<Cylinder>(parameters[0], parameters[1], center);
+}
+
+std::unique_ptr<Volume> makeEllipsoid(
+    const std::vector<std::string>& options) {
+  const auto [parameters, center] =
+      shapeParameters(options, 3, "Ellipsoid", "a, b, c");
+  return std::make_unique<Ellipsoid>(
+      std::array<double, 3>{parameters[0], parameters[1], parameters[2]},
+      center);
+}
+
+std::unique_ptr<Volume> makeCavity(const std::vector<std::string>& options) {
+  if (options.size() < 2) {
+    throw cpet::invalid_option(
+        "Invalid Option: Cavity requires a probe radius and at least one "
+        "atom, residue or position");
+  }
+  if (!util::isDouble(options[0])) {
+    throw cpet::invalid_option(
+        "Invalid Option: Cavity probe radius must be a double");
+  }
+  return std::make_unique<Cavity>(
+      std::stod(options[0]),
+      std::vector<std::string>(options.begin() + 1, options.end()));
+}
+
 std::unique_ptr<Volume> Volume::generateVolume(
     const std::vector<std::string>& options) {
   static const std::unordered_map<
       std::string,
       std::function<std::unique_ptr<Volume>(const std::vector<std::string>&)>>
-      volumeHash = {{"box", &makeBox}};
+      volumeHash = {{"box", &makeBox},
+                    {"sphere", &makeSphere},
+                    {"cylinder", &makeCylinder},
+                    {"ellipsoid", &makeEllipsoid},
+                    {"cavity", &makeCavity}};
 
   if (options.empty()) {
     throw cpet::invalid_option("Invalid Option: no options to generate volume");
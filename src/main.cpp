@@ -5,6 +5,7 @@
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <vector>
 
 /* EXTERNAL LIBRARY HEADER FILES */
 #include <spdlog/sinks/stdout_sinks.h>
@@ -15,6 +16,8 @@
 /* CPET HEADER FILES */
 #include "Calculator.h"
 #include "Exceptions.h"
+#include "MemoryPlan.h"
+#include "ModelIndex.h"
 #include "config.h"
 
 std::optional<std::string> validPDBFile(const cxxopts::ParseResult& result) {
@@ -44,6 +47,16 @@ std::optional<std::string> validChargeFile(const cxxopts::ParseResult& result) {
   return result["charges"].as<std::string>();
 }
 
+std::optional<std::string> validTopologyFile(
+    const cxxopts::ParseResult& result) {
+  if (!result["topology"].as<std::string>().empty()) {
+    if (!std::filesystem::exists(result["topology"].as<std::string>())) {
+      return std::nullopt;
+    }
+  }
+  return result["topology"].as<std::string>();
+}
+
 std::optional<int> validThreads(const cxxopts::ParseResult& result) {
   if (result["threads"].as<int>() > 0) {
     return result["threads"].as<int>();
@@ -51,17 +64,41 @@ std::optional<int> validThreads(const cxxopts::ParseResult& result) {
   return std::nullopt;
 }
 
+/* cpet index FILE... writes the model offset index of each trajectory */
+int indexTrajectories(const std::vector<std::string>& files) {
+  if (files.empty()) {
+    SPDLOG_ERROR("Usage: cpet index TRAJECTORY...");
+    return EXIT_FAILURE;
+  }
+  for (const auto& file : files) {
+    try {
+      const auto models = cpet::cache::buildIndex(file);
+      SPDLOG_INFO("Indexed {} models of {}", models.size(), file);
+    } catch (const cpet::exception& exc) {
+      SPDLOG_ERROR(exc.what());
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv) {
   spdlog::set_pattern("%v");
 
+  if (argc > 1 && std::string(argv[1]) == "index") {
+    return indexTrajectories(std::vector<std::string>(argv + 2, argv + argc));
+  }
+
   cxxopts::Options options(
       "cpet",
       std::string("Classical Protein Electric Field Topology, version ") +
           std::string(PROJECT_VER));
+  options.custom_help("[OPTION...]\n  cpet index TRAJECTORY...");
   options.add_options()(
       "d,debug", "Enable debugging",
       cxxopts::value<bool>()->default_value("false"))  // a bool parameter
-      ("p,protein", "PDB", cxxopts::value<std::string>())(
+      ("p,protein", "PDB/PQR, DCD or XTC trajectory",
+       cxxopts::value<std::string>())(
           "o,options", "Option file", cxxopts::value<std::string>())(
           "c,charges", "Partial atomic charge definitions",
           cxxopts::value<std::string>()->default_value(""))(
@@ -71,6 +108,21 @@ int main(int argc, char** argv) {
           cxxopts::value<std::string>()->default_value(""))("h,help",
                                                             "Print usage")(
           "v,verbose", "Verbose output",
+          cxxopts::value<bool>()->default_value("false"))(
+          "s,stream", "Process frames one at a time to bound memory usage",
+          cxxopts::value<bool>()->default_value("false"))(
+          "T,topology",
+          "PDB/PQR providing atom ids and charges for DCD/XTC trajectories",
+          cxxopts::value<std::string>()->default_value(""))(
+          "no-cache", "Do not read or write the .cpetbin frame cache",
+          cxxopts::value<bool>()->default_value("false"))(
+          "max-memory",
+          "Memory budget such as 8G; streaming and threads are adjusted to "
+          "stay within it",
+          cxxopts::value<std::string>()->default_value(""))(
+          "single-precision",
+          "Hold coordinates as floats, halving their memory; fields are "
+          "still summed in double precision",
           cxxopts::value<bool>()->default_value("false"));
 
   std::unique_ptr<cxxopts::ParseResult> tmp_result{nullptr};
@@ -135,10 +187,24 @@ int main(int argc, char** argv) {
     SPDLOG_WARN(options.help());
     return EXIT_FAILURE;
   }
+  std::optional<std::string> topologyFile;
+  if (!(topologyFile = validTopologyFile(result))) {
+    SPDLOG_WARN("Invalid topology file");
+    SPDLOG_WARN(options.help());
+    return EXIT_FAILURE;
+  }
   /* Begin the actual program here */
   try {
+    std::optional<uint64_t> maxMemory;
+    if (const auto& size = result["max-memory"].as<std::string>();
+        !size.empty()) {
+      maxMemory = cpet::memory::parseSize(size);
+    }
     cpet::Calculator c(proteinFile.value(), optionFile.value(),
-                       chargesFile.value(), numberOfThreads.value());
+                       chargesFile.value(), numberOfThreads.value(),
+                       result["stream"].as<bool>(), topologyFile.value(),
+                       !result["no-cache"].as<bool>(), maxMemory,
+                       result["single-precision"].as<bool>());
     if (!result["out"].as<std::string>().empty()) {
       SPDLOG_WARN(
           "DEPRECATION WARNING: -O is deprecated and does not do anything! Use "
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Calculator.h"
+#include "ModelIndex.h"
+
+namespace {
+/* Every value of a field output, in order */
+std::vector<double> fieldsIn(const std::string& file) {
+  std::ifstream inFile(file);
+  std::vector<double> result;
+  std::string line;
+  while (std::getline(inFile, line)) {
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    std::istringstream values(line);
+    double value = 0;
+    while (values >> value) {
+      result.push_back(value);
+    }
+  }
+  return result;
+}
+}  // namespace
+
+TEST(Calculator, StreamSinglePrecisionWithCharges) {
+  const std::string protein = "Data/structures/models.pdb";
+  const std::string options = "Data/valid_options/field_block_output";
+  const std::string charges = "Data/structures/charges.pdb";
+  const std::string output = "calculator_fields";
+  ASSERT_TRUE(std::filesystem::exists(protein));
+  ASSERT_TRUE(std::filesystem::exists(options));
+  ASSERT_TRUE(std::filesystem::exists(charges));
+
+  const auto run = [&](const std::string& chargeFile, const bool stream,
+                       const bool singlePrecision) {
+    std::filesystem::remove(output);
+    cpet::Calculator calculator(protein, options, chargeFile, 1, stream, "",
+                                false, std::nullopt, singlePrecision);
+    calculator.compute();
+    return fieldsIn(output);
+  };
+
+  const auto original = run("", false, false);
+  const auto expected = run(charges, false, false);
+  std::vector<double> streamed;
+  ASSERT_NO_THROW(streamed = run(charges, true, true));
+  std::filesystem::remove(output);
+  std::filesystem::remove(protein + std::string(cpet::cache::INDEX_EXTENSION));
+
+  ASSERT_FALSE(expected.empty());
+  ASSERT_EQ(streamed.size(), expected.size());
+  EXPECT_NE(expected, original);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(streamed[i], expected[i], 1e-4 * std::abs(expected[i]) + 1e-9);
+  }
+}
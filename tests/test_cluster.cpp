@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include "Cluster.h"
+#include "Exceptions.h"
+
+namespace {
+/* Two well separated groups of points on a line: {0, 1, 2} and {10, 11} */
+std::vector<std::vector<double>> twoGroupMatrix() {
+  const std::vector<double> points = {0, 1, 2, 10, 11};
+  std::vector<std::vector<double>> matrix;
+  for (const auto& p1 : points) {
+    std::vector<double> row;
+    for (const auto& p2 : points) {
+      row.emplace_back(std::abs(p1 - p2));
+    }
+    matrix.emplace_back(row);
+  }
+  return matrix;
+}
+}  // namespace
+
+TEST(Cluster, DecodeMethod) {
+  EXPECT_EQ(cpet::cluster::decodeMethod("kmedoids"),
+            cpet::cluster::Method::kmedoids);
+  EXPECT_EQ(cpet::cluster::decodeMethod("PAM"),
+            cpet::cluster::Method::kmedoids);
+  EXPECT_EQ(cpet::cluster::decodeMethod("average"),
+            cpet::cluster::Method::average);
+  EXPECT_EQ(cpet::cluster::decodeMethod("hierarchical"),
+            cpet::cluster::Method::average);
+  EXPECT_FALSE(cpet::cluster::decodeMethod("kmeans"));
+}
+
+TEST(Cluster, KMedoids) {
+  const auto matrix = twoGroupMatrix();
+  for (const int threads : {1, 3}) {
+    const auto result = cpet::cluster::kMedoids(matrix, 2, threads);
+    ASSERT_EQ(result.medoids.size(), 2);
+    ASSERT_EQ(result.labels.size(), matrix.size());
+
+    EXPECT_EQ(result.labels[0], result.labels[1]);
+    EXPECT_EQ(result.labels[1], result.labels[2]);
+    EXPECT_EQ(result.labels[3], result.labels[4]);
+    EXPECT_NE(result.labels[0], result.labels[3]);
+
+    EXPECT_EQ(result.medoids[result.labels[0]], 1);
+    EXPECT_TRUE(result.medoids[result.labels[3]] == 3 ||
+                result.medoids[result.labels[3]] == 4);
+  }
+}
+
+TEST(Cluster, KMedoidsMoreClustersThanFrames) {
+  const auto matrix = twoGroupMatrix();
+  const auto result = cpet::cluster::kMedoids(matrix, 10, 2);
+  EXPECT_EQ(result.medoids.size(), matrix.size());
+}
+
+TEST(Cluster, AverageLinkage) {
+  const auto matrix = twoGroupMatrix();
+  const auto result = cpet::cluster::averageLinkage(matrix, 2);
+  ASSERT_EQ(result.medoids.size(), 2);
+  ASSERT_EQ(result.labels.size(), matrix.size());
+
+  EXPECT_EQ(result.labels[0], result.labels[1]);
+  EXPECT_EQ(result.labels[1], result.labels[2]);
+  EXPECT_EQ(result.labels[3], result.labels[4]);
+  EXPECT_NE(result.labels[0], result.labels[3]);
+  EXPECT_EQ(result.medoids[result.labels[0]], 1);
+}
+
+TEST(Cluster, AverageLinkageSingleCluster) {
+  const auto matrix = twoGroupMatrix();
+  const auto result = cpet::cluster::averageLinkage(matrix, 1);
+  ASSERT_EQ(result.medoids.size(), 1);
+  for (const auto& label : result.labels) {
+    EXPECT_EQ(label, 0);
+  }
+  EXPECT_EQ(result.medoids[0], 2);
+}
+
+TEST(Cluster, AverageLinkageInfiniteDistances) {
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  const std::vector<std::vector<double>> matrix = {
+      {0, inf, inf}, {inf, 0, 1}, {inf, 1, 0}};
+
+  const auto two = cpet::cluster::averageLinkage(matrix, 2);
+  ASSERT_EQ(two.labels.size(), matrix.size());
+  EXPECT_EQ(two.labels[1], two.labels[2]);
+  EXPECT_NE(two.labels[0], two.labels[1]);
+
+  const std::vector<std::vector<double>> apart = {
+      {0, inf, inf}, {inf, 0, inf}, {inf, inf, 0}};
+  const auto one = cpet::cluster::averageLinkage(apart, 1);
+  ASSERT_EQ(one.medoids.size(), 1);
+  for (const auto& label : one.labels) {
+    EXPECT_EQ(label, 0);
+  }
+  EXPECT_EQ(cpet::cluster::averageLinkage(apart, 3).medoids.size(), 3);
+}
+
+TEST(Cluster, AverageLinkageNaN) {
+  auto matrix = twoGroupMatrix();
+  matrix[1][3] = matrix[3][1] = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW((void)cpet::cluster::averageLinkage(matrix, 2),
+               cpet::value_error);
+}
+
+TEST(Cluster, Empty) {
+  const std::vector<std::vector<double>> matrix;
+  EXPECT_TRUE(cpet::cluster::kMedoids(matrix, 2, 1).medoids.empty());
+  EXPECT_TRUE(cpet::cluster::averageLinkage(matrix, 2).labels.empty());
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Frame.h"
+#include "FrameCache.h"
+#include "ModelIndex.h"
+
+namespace {
+/* Copies a fixture somewhere writable so the cache lands next to it */
+std::string scratchCopyOf(const std::string& file) {
+  const auto directory =
+      std::filesystem::temp_directory_path() / "cpet_framecache_test";
+  std::filesystem::create_directories(directory);
+  const auto copy = directory / std::filesystem::path(file).filename();
+  std::filesystem::copy_file(
+      file, copy, std::filesystem::copy_options::overwrite_existing);
+  std::filesystem::remove(cpet::cache::cacheFileFor(copy.string()));
+  std::filesystem::remove(cpet::cache::indexFileFor(copy.string()));
+  return copy.string();
+}
+
+void expectSameFrames(const std::vector<cpet::Frame>& frames1,
+                      const std::vector<cpet::Frame>& frames2) {
+  ASSERT_EQ(frames1.size(), frames2.size());
+  for (size_t i = 0; i < frames1.size(); ++i) {
+    EXPECT_TRUE(std::equal(frames1[i].begin(), frames1[i].end(),
+                           frames2[i].begin(), frames2[i].end()))
+        << "frame " << i;
+  }
+}
+}  // namespace
+
+TEST(FrameCache, WrittenOnFirstLoad) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  const auto cacheFile = cpet::cache::cacheFileFor(file);
+
+  const auto parsed = cpet::Frame::loadFramesFromFile(file, 0, 1);
+  expectSameFrames(cpet::cache::loadFrames(file, 0, 1, 2), parsed);
+  ASSERT_TRUE(std::filesystem::exists(cacheFile));
+
+  const cpet::cache::FrameCache cache(cacheFile);
+  EXPECT_EQ(cache.numberOfFrames(), 3);
+  EXPECT_EQ(cache.numberOfAtoms(), 3);
+  EXPECT_TRUE(cache.isCurrentFor(file));
+  EXPECT_DOUBLE_EQ(cache.charges()[1], -0.447);
+
+  /* Structure of arrays: all x, then all y, then all z */
+  const auto* coordinates = cache.coordinates(2);
+  EXPECT_DOUBLE_EQ(coordinates[0], 114.061);
+  EXPECT_DOUBLE_EQ(coordinates[6], 107.751);
+  EXPECT_THROW(static_cast<void>(cache.coordinates(3)), cpet::value_error);
+
+  const auto topology = cache.topology();
+  EXPECT_EQ(topology.begin()->id.ID(), "D:2:O110");
+  EXPECT_EQ((topology.begin() + 2)->id.ID(), "A1:1002:C112");
+}
+
+TEST(FrameCache, MatchesTextParser) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  auto frames = cpet::cache::loadFrames(file, 0, 1, 1);
+
+  for (const auto& [start, skip] :
+       std::vector<std::pair<int, int>>{{0, 1}, {0, 2}, {1, 1}, {2, 3}}) {
+    const auto parsed = cpet::Frame::loadFramesFromFile(file, start, skip);
+    expectSameFrames(cpet::cache::loadFrames(file, start, skip, 2), parsed);
+
+    std::vector<cpet::Frame> streamed;
+    cpet::cache::forEachFrame(file, start, skip, 2, [&](cpet::Frame frame) {
+      streamed.emplace_back(std::move(frame));
+    });
+    expectSameFrames(streamed, parsed);
+  }
+
+  /* A selection on the first run still caches every frame */
+  const auto other = scratchCopyOf("Data/structures/models.pdb");
+  EXPECT_EQ(cpet::cache::loadFrames(other, 2, 1, 1).size(), 1);
+  const cpet::cache::FrameCache cache(cpet::cache::cacheFileFor(other));
+  EXPECT_EQ(cache.numberOfFrames(), 3);
+}
+
+TEST(FrameCache, Invalidation) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  const auto cacheFile = cpet::cache::cacheFileFor(file);
+  auto frames = cpet::cache::loadFrames(file, 0, 1, 1);
+
+  /* Touching the file without changing it keeps the cache */
+  std::filesystem::last_write_time(
+      file, std::filesystem::last_write_time(file) + std::chrono::seconds(5));
+  const auto stored = cpet::cache::FrameCache(cacheFile).header();
+  EXPECT_TRUE(cpet::cache::FrameCache(cacheFile).isCurrentFor(file));
+  EXPECT_EQ(cpet::cache::FrameCache(cacheFile).header().sourceModified,
+            stored.sourceModified);
+
+  /* Loading refreshes the stored time, the query alone does not */
+  frames = cpet::cache::loadFrames(file, 0, 1, 1);
+  EXPECT_EQ(cpet::cache::FrameCache(cacheFile).header().sourceModified,
+            cpet::cache::describe(file, false).modified);
+
+  /* Same size, different contents */
+  {
+    std::fstream source(file, std::ios::in | std::ios::out);
+    source.seekp(std::string("MODEL        1\nHETATM 5719 O110 PRE D   2     ")
+                     .size());
+    source << "9";
+  }
+  std::filesystem::last_write_time(
+      file, std::filesystem::last_write_time(file) + std::chrono::seconds(5));
+  EXPECT_FALSE(cpet::cache::FrameCache(cacheFile).isCurrentFor(file));
+
+  const auto reloaded = cpet::cache::loadFrames(file, 0, 1, 1);
+  EXPECT_DOUBLE_EQ(reloaded.front().begin()->coordinate[0], 913.861);
+  EXPECT_TRUE(cpet::cache::FrameCache(cacheFile).isCurrentFor(file));
+
+  /* Different size */
+  std::ofstream(file, std::ios::app) << "REMARK appended\n";
+  EXPECT_FALSE(cpet::cache::FrameCache(cacheFile).isCurrentFor(file));
+}
+
+TEST(FrameCache, CorruptCacheIsIgnored) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  const auto cacheFile = cpet::cache::cacheFileFor(file);
+  std::ofstream(cacheFile) << "not a cache";
+
+  EXPECT_THROW(cpet::cache::FrameCache{cacheFile}, cpet::value_error);
+  expectSameFrames(cpet::cache::loadFrames(file, 0, 1, 1),
+                   cpet::Frame::loadFramesFromFile(file, 0, 1));
+  EXPECT_NO_THROW(cpet::cache::FrameCache{cacheFile});
+}
+
+TEST(ModelIndex, BuildAndRead) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  EXPECT_FALSE(cpet::cache::readIndex(file));
+
+  const auto built = cpet::cache::buildIndex(file);
+  ASSERT_EQ(built.size(), 3);
+  const auto read = cpet::cache::readIndex(file);
+  ASSERT_TRUE(read);
+  ASSERT_EQ(read->size(), built.size());
+  for (size_t i = 0; i < built.size(); ++i) {
+    EXPECT_EQ((*read)[i].begin, built[i].begin);
+    EXPECT_EQ((*read)[i].end, built[i].end);
+    EXPECT_EQ((*read)[i].firstLine, built[i].firstLine);
+    EXPECT_EQ((*read)[i].terminated, built[i].terminated);
+  }
+
+  std::ofstream(file, std::ios::app) << "REMARK appended\n";
+  EXPECT_FALSE(cpet::cache::readIndex(file));
+}
+
+TEST(ModelIndex, SelectsSameFrames) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+
+  for (const auto& [start, skip] :
+       std::vector<std::pair<int, int>>{{0, 1}, {0, 2}, {1, 1}, {2, 3}}) {
+    const auto scanned = cpet::Frame::loadFramesFromFile(file, start, skip);
+    expectSameFrames(
+        cpet::Frame::loadFramesFromFile(file, start, skip, 2, true), scanned);
+    EXPECT_TRUE(cpet::cache::readIndex(file));
+
+    std::vector<cpet::Frame> streamed;
+    cpet::Frame::forEachFrameInFile(
+        file, start, skip, 2,
+        [&](cpet::Frame frame) { streamed.emplace_back(std::move(frame)); },
+        true);
+    expectSameFrames(streamed, scanned);
+  }
+}
+
+TEST(ModelIndex, MisalignedIndexIsRebuilt) {
+  const auto file = scratchCopyOf("Data/structures/models.pdb");
+  const auto original = cpet::cache::buildIndex(file);
+
+  /* Move the first ENDMDL by a byte without changing size or time */
+  const auto modified = std::filesystem::last_write_time(file);
+  {
+    std::fstream source(file, std::ios::in | std::ios::out);
+    source.seekp(static_cast<std::streamoff>(original.front().end));
+    source << "\nENDMDL";
+  }
+  std::filesystem::last_write_time(file, modified);
+  ASSERT_TRUE(cpet::cache::readIndex(file));
+
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, 1, true);
+  expectSameFrames(frames, cpet::Frame::loadFramesFromFile(file, 0, 1));
+  EXPECT_EQ(cpet::cache::readIndex(file)->front().end,
+            original.front().end + 1);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+
+#include "Exceptions.h"
 #include "Histogram2D.h"
 
 TEST(Histogram2D, edges) {
@@ -112,3 +116,139 @@ TEST(Histogram2D, histogram2DSimple) {
     EXPECT_EQ(result[0][1], 1);
   }
 }
+
+TEST(Histogram2D, BinaryRoundTrip) {
+  const auto file =
+      (std::filesystem::temp_directory_path() / "cpet_test_histograms.bin")
+          .string();
+
+  const cpet::histo::HistogramSet set{{2, 3},
+                                      {0.1, 2.5},
+                                      {-1.0, 4.0},
+                                      {{0.1, 0.2, 0.3, 0.1, 0.2, 0.1},
+                                       {0.0, 0.5, 0.0, 0.25, 0.25, 0.0}}};
+  ASSERT_NO_THROW(cpet::histo::writeHistograms(file, set));
+
+  const auto loaded = cpet::histo::readHistograms(file);
+  EXPECT_EQ(loaded.bins, set.bins);
+  EXPECT_EQ(loaded.xlim, set.xlim);
+  EXPECT_EQ(loaded.ylim, set.ylim);
+  EXPECT_EQ(loaded.histograms, set.histograms);
+
+  std::filesystem::remove(file);
+}
+
+TEST(Histogram2D, BinaryInvalidFile) {
+  const auto file =
+      (std::filesystem::temp_directory_path() / "cpet_test_not_histograms.bin")
+          .string();
+  {
+    std::ofstream outFile(file);
+    outFile << "this is not a histogram file\n";
+  }
+  EXPECT_THROW(auto set = cpet::histo::readHistograms(file), cpet::value_error);
+  std::filesystem::remove(file);
+
+  EXPECT_THROW(auto set = cpet::histo::readHistograms(file), cpet::io_error);
+}
+
+TEST(Histogram2D, BinaryCountExceedsFile) {
+  const auto file =
+      (std::filesystem::temp_directory_path() / "cpet_test_histogram_count.bin")
+          .string();
+  const cpet::histo::HistogramSet set{
+      {1, 2}, {0.0, 1.0}, {0.0, 1.0}, {{0.5, 0.5}}};
+  cpet::histo::writeHistograms(file, set);
+
+  /* Number of histograms follows magic, version, bins, xlim and ylim */
+  {
+    std::fstream inOut(file, std::ios::in | std::ios::out | std::ios::binary);
+    inOut.seekp(8 + 4 + 2 * 4 + 4 * 8);
+    const uint64_t count = uint64_t{1} << 60;
+    inOut.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  }
+  EXPECT_THROW(auto loaded = cpet::histo::readHistograms(file),
+               cpet::value_error);
+  std::filesystem::remove(file);
+}
+
+TEST(Histogram2D, MultipleResolutions) {
+  std::vector<double> x_data;
+  std::vector<double> y_data;
+  for (int i = 0; i < 200; ++i) {
+    x_data.emplace_back(0.37 * (i % 11) + 0.013 * i);
+    y_data.emplace_back(0.21 * (i % 7) - 0.004 * i);
+  }
+  const std::array<double, 2> xlim = {0.0, 6.0};
+  const std::array<double, 2> ylim = {-1.0, 1.5};
+
+  /* 8, 4 and 2 nest into 16, 5x3 has to be binned directly */
+  const std::vector<std::array<int, 2>> bins = {
+      {2, 2}, {16, 16}, {4, 8}, {5, 3}, {8, 8}};
+  const auto results =
+      cpet::histo::construct2DHistograms(x_data, y_data, bins, xlim, ylim);
+  ASSERT_EQ(results.size(), bins.size());
+
+  for (size_t i = 0; i < bins.size(); ++i) {
+    const auto expected =
+        cpet::histo::construct2DHistogram(x_data, y_data, bins[i], xlim, ylim);
+    EXPECT_EQ(results[i], expected)
+        << "bins " << bins[i][0] << 'x' << bins[i][1];
+  }
+}
+
+TEST(Histogram2D, NestsByPowerOfTwo) {
+  EXPECT_TRUE(cpet::histo::nestsByPowerOfTwo(200, 25));
+  EXPECT_TRUE(cpet::histo::nestsByPowerOfTwo(50, 50));
+  EXPECT_FALSE(cpet::histo::nestsByPowerOfTwo(75, 25));
+  EXPECT_FALSE(cpet::histo::nestsByPowerOfTwo(25, 50));
+  EXPECT_FALSE(cpet::histo::nestsByPowerOfTwo(25, 0));
+}
+
+TEST(Histogram2D, DistanceMetrics) {
+  using cpet::histo::Metric;
+  const std::vector<Metric> metrics = {Metric::chi, Metric::hellinger,
+                                       Metric::jensenShannon, Metric::l1};
+
+  const std::vector<double> h1 = {0.5, 0.5, 0.0, 0.0};
+  const std::vector<double> h2 = {0.0, 0.0, 0.25, 0.75};
+  const std::vector<double> h3 = {0.25, 0.25, 0.25, 0.25};
+
+  cpet::histo::Distances same{};
+  cpet::histo::distances(h1, h1, metrics, same);
+  for (const auto& d : same) {
+    EXPECT_NEAR(d, 0.0, 1e-12);
+  }
+
+  /* Disjoint supports saturate every bounded metric */
+  cpet::histo::Distances disjoint{};
+  cpet::histo::distances(h1, h2, metrics, disjoint);
+  EXPECT_NEAR(disjoint[0], cpet::histo::chiDistance(h1, h2), 1e-12);
+  EXPECT_NEAR(disjoint[1], 1.0, 1e-12);
+  EXPECT_NEAR(disjoint[2], 1.0, 1e-12);
+  EXPECT_NEAR(disjoint[3], 2.0, 1e-12);
+
+  cpet::histo::Distances partial{};
+  cpet::histo::distances(h1, h3, metrics, partial);
+  EXPECT_NEAR(partial[0], cpet::histo::chiDistance(h1, h3), 1e-12);
+  EXPECT_NEAR(partial[3], 1.0, 1e-12);
+  cpet::histo::Distances reversed{};
+  cpet::histo::distances(h3, h1, metrics, reversed);
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    EXPECT_NEAR(partial[i], reversed[i], 1e-12);
+  }
+
+  /* A subset in a different order is reported in that order */
+  cpet::histo::Distances subset{};
+  cpet::histo::distances(h1, h2, {Metric::l1, Metric::hellinger}, subset);
+  EXPECT_NEAR(subset[0], disjoint[3], 1e-12);
+  EXPECT_NEAR(subset[1], disjoint[1], 1e-12);
+}
+
+TEST(Histogram2D, DecodeMetric) {
+  EXPECT_EQ(cpet::histo::decodeMetric("Hellinger"),
+            cpet::histo::Metric::hellinger);
+  EXPECT_EQ(cpet::histo::decodeMetric("js"),
+            cpet::histo::Metric::jensenShannon);
+  EXPECT_FALSE(cpet::histo::decodeMetric("euclid"));
+}
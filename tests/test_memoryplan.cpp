@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "Exceptions.h"
+#include "MemoryPlan.h"
+#include "Option.h"
+
+TEST(MemoryPlan, ParseSize) {
+  EXPECT_EQ(cpet::memory::parseSize("512"), 512);
+  EXPECT_EQ(cpet::memory::parseSize("512B"), 512);
+  EXPECT_EQ(cpet::memory::parseSize("64kb"), 64 * 1024);
+  EXPECT_EQ(cpet::memory::parseSize("3M"), 3 * 1024 * 1024);
+  EXPECT_EQ(cpet::memory::parseSize("8G"), uint64_t{8} << 30);
+  EXPECT_EQ(cpet::memory::parseSize("8GiB"), uint64_t{8} << 30);
+  EXPECT_EQ(cpet::memory::parseSize("2T"), uint64_t{2} << 40);
+
+  for (const auto* invalid : {"", "G", "1.5G", "12X", "-1", "8 G"}) {
+    EXPECT_THROW(static_cast<void>(cpet::memory::parseSize(invalid)),
+                 cpet::invalid_option)
+        << invalid;
+  }
+
+  EXPECT_EQ(cpet::memory::formatSize(512), "512 B");
+  EXPECT_EQ(cpet::memory::formatSize(uint64_t{3} << 29), "1.5 GiB");
+}
+
+TEST(MemoryPlan, StreamsToFit) {
+  const cpet::Option option{"Data/valid_options/topology_block_histo"};
+  const cpet::memory::Workload workload{10000, 1000};
+
+  const auto loaded = cpet::memory::estimate(option, workload, false, 4);
+  const auto frames = std::find_if(
+      loaded.items.begin(), loaded.items.end(),
+      [](const cpet::memory::Item& item) { return item.name == "frames"; });
+  ASSERT_NE(frames, loaded.items.end());
+  EXPECT_EQ(frames->bytes, 1000 * 10000 * 24);
+
+  /* Enough room to keep every frame */
+  auto plan = cpet::memory::makePlan(option, workload, uint64_t{1} << 30,
+                                     false, 4);
+  EXPECT_FALSE(plan.stream);
+  EXPECT_EQ(plan.numberOfThreads, 4);
+
+  /* The 200 x 200 histograms of 1000 frames alone take 320 MB */
+  const uint64_t budget = 400'000'000;
+  ASSERT_GT(loaded.footprint(), budget);
+  plan = cpet::memory::makePlan(option, workload, budget, false, 4);
+  EXPECT_TRUE(plan.stream);
+  EXPECT_EQ(plan.numberOfThreads, 4);
+  EXPECT_LE(plan.footprint(), budget);
+
+  try {
+    static_cast<void>(
+        cpet::memory::makePlan(option, workload, 100'000'000, false, 4));
+    FAIL() << "Expected the budget to be rejected";
+  } catch (const cpet::value_error& e) {
+    EXPECT_NE(std::string(e.what()).find("histograms"), std::string::npos)
+        << e.what();
+  }
+}
+
+TEST(MemoryPlan, ReducesThreads) {
+  const cpet::Option option{"Data/valid_options/simple_field"};
+  const cpet::memory::Workload workload{1'000'000, 100};
+
+  /* Streaming holds one frame of 24 MB per thread */
+  const auto single = cpet::memory::estimate(option, workload, true, 1);
+  const auto budget = single.footprint() + 3 * 24'000'000;
+  const auto plan = cpet::memory::makePlan(option, workload, budget, true, 8);
+  EXPECT_TRUE(plan.stream);
+  EXPECT_EQ(plan.numberOfThreads, 4);
+  EXPECT_LE(plan.footprint(), budget);
+}
+
+TEST(MemoryPlan, AdaptiveWorstCase) {
+  const cpet::Option option{"Data/valid_options/plot3d_block_adaptive"};
+  const cpet::memory::Workload workload{100, 1};
+  const auto& grid = option.calculateEFieldVolumes().front().grid();
+
+  /* Depth 3 splits each cell edge in 8, and 8^3 points per coarse point
+   * exceed the finest grid */
+  uint64_t finest = 1;
+  for (const auto& axis : grid.axes()) {
+    finest *= (axis.size() - 1) * 8 + 1;
+  }
+  ASSERT_LT(finest, grid.size() * 512);
+
+  const auto plan = cpet::memory::estimate(option, workload, false, 1);
+  const auto adaptive = std::find_if(
+      plan.items.begin(), plan.items.end(), [](const cpet::memory::Item& item) {
+        return item.name == "adaptive plot3d";
+      });
+  ASSERT_NE(adaptive, plan.items.end());
+  /* Point, field and lattice index entry per refined point */
+  EXPECT_EQ(adaptive->bytes, finest * (2 * sizeof(Eigen::Vector3d) + 32));
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "NumpyIO.h"
+
+namespace {
+std::string scratchFile(const std::string& name) {
+  const auto directory =
+      std::filesystem::temp_directory_path() / "cpet_numpyio_test";
+  std::filesystem::create_directories(directory);
+  return (directory / name).string();
+}
+
+std::string contentsOf(const std::string& file) {
+  std::ifstream inFile(file, std::ios::binary);
+  return {std::istreambuf_iterator<char>(inFile),
+          std::istreambuf_iterator<char>()};
+}
+
+uint32_t read32(const std::string& bytes, const size_t offset) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[offset + i]))
+             << (8 * i);
+  }
+  return value;
+}
+}  // namespace
+
+TEST(NumpyIO, Extensions) {
+  EXPECT_TRUE(cpet::util::isNpyFile("matrix.npy"));
+  EXPECT_FALSE(cpet::util::isNpyFile("matrix.dat"));
+  EXPECT_FALSE(cpet::util::isNpyFile(".npy"));
+  EXPECT_TRUE(cpet::util::isNpzFile("out/volume.npz"));
+  EXPECT_FALSE(cpet::util::isNpzFile("volume.npy"));
+}
+
+TEST(NumpyIO, WritesNpy) {
+  const auto file = scratchFile("matrix.npy");
+  const std::vector<std::vector<double>> matrix = {{1.0, 2.0, 3.0},
+                                                   {4.0, 5.0, 6.5}};
+  cpet::util::writeNpy(file, {2, 3},
+                       cpet::util::Chunks(matrix.begin(), matrix.end()));
+
+  const auto bytes = contentsOf(file);
+  ASSERT_EQ(bytes.substr(0, 8), std::string("\x93NUMPY\x01\x00", 8));
+  const size_t headerLength = static_cast<uint8_t>(bytes[8]) +
+                              256U * static_cast<uint8_t>(bytes[9]);
+  const auto dataOffset = 10 + headerLength;
+  EXPECT_EQ(dataOffset % 64, 0);
+
+  const auto header = bytes.substr(10, headerLength);
+  EXPECT_EQ(header.find("{'descr': '<f8', 'fortran_order': False, "
+                        "'shape': (2, 3), }"),
+            0);
+  EXPECT_EQ(header.back(), '\n');
+
+  ASSERT_EQ(bytes.size(), dataOffset + 6 * sizeof(double));
+  std::vector<double> data(6);
+  std::memcpy(data.data(), bytes.data() + dataOffset,
+              data.size() * sizeof(double));
+  EXPECT_EQ(data, (std::vector<double>{1.0, 2.0, 3.0, 4.0, 5.0, 6.5}));
+
+  const std::vector<double> vector = {1.0, 2.0};
+  EXPECT_THROW(cpet::util::writeNpy(file, {3}, {vector}), cpet::value_error);
+}
+
+TEST(NumpyIO, WritesNpz) {
+  const auto file = scratchFile("arrays.npz");
+  const std::vector<Eigen::Vector3d> points = {{1, 2, 3}, {4, 5, 6}};
+  const std::vector<double> scalars = {7.0};
+  {
+    cpet::util::NpzWriter npz(file);
+    npz.add("points", {2, 3}, {cpet::util::flatView(points)});
+    npz.add("scalar", {1}, {scalars});
+    npz.finish();
+  }
+
+  const auto bytes = contentsOf(file);
+  EXPECT_EQ(read32(bytes, 0), 0x04034b50);
+  EXPECT_NE(bytes.find("points.npy"), std::string::npos);
+  EXPECT_NE(bytes.find("'shape': (1,), }"), std::string::npos);
+
+  /* End of central directory record: two entries, no comment */
+  const auto end = bytes.size() - 22;
+  EXPECT_EQ(read32(bytes, end), 0x06054b50);
+  EXPECT_EQ(read32(bytes, end + 8), 0x00020002);
+  const auto directoryOffset = read32(bytes, end + 16);
+  EXPECT_EQ(read32(bytes, directoryOffset), 0x02014b50);
+}
+
+TEST(NumpyIO, StreamsNpz) {
+  std::vector<double> values(3000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = 0.5 * static_cast<double>(i);
+  }
+  const auto whole = scratchFile("whole.npz");
+  {
+    cpet::util::NpzWriter npz(whole);
+    npz.add("values", {1000, 3}, {values});
+    npz.finish();
+  }
+
+  /* The same array produced in uneven pieces */
+  const auto streamed = scratchFile("streamed.npz");
+  {
+    cpet::util::NpzWriter npz(streamed);
+    size_t first = 0;
+    npz.add("values", {1000, 3}, [&]() -> cpet::util::Span<const double> {
+      const auto count = std::min<size_t>(values.size() - first, 700);
+      const cpet::util::Span<const double> chunk(values.data() + first, count);
+      first += count;
+      return chunk;
+    });
+    npz.finish();
+  }
+  EXPECT_EQ(contentsOf(streamed), contentsOf(whole));
+
+  cpet::util::NpzWriter npz(scratchFile("short.npz"));
+  EXPECT_THROW(
+      npz.add("short", {2}, []() { return cpet::util::Span<const double>{}; }),
+      cpet::value_error);
+}
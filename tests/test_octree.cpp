@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Box.h"
+#include "Exceptions.h"
+#include "Octree.h"
+#include "Sphere.h"
+
+namespace {
+/* Coulomb-like field of a unit charge at source */
+Eigen::Vector3d chargeField(const Eigen::Vector3d& point,
+                            const Eigen::Vector3d& source) {
+  const Eigen::Vector3d d = point - source;
+  return d / (d.norm() * d.norm() * d.norm());
+}
+
+std::set<std::tuple<double, double, double>> asSet(
+    const std::vector<Eigen::Vector3d>& points) {
+  std::set<std::tuple<double, double, double>> result;
+  for (const auto& p : points) {
+    result.emplace(p[0], p[1], p[2]);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(Octree, UniformFieldIsNotRefined) {
+  const auto grid = cpet::Box({1, 1, 1}).grid({4, 4, 4});
+  const auto sample = cpet::octree::refine(
+      grid, {4, 0.01},
+      [](const Eigen::Vector3d&) { return Eigen::Vector3d{1, 2, 3}; });
+  EXPECT_EQ(sample.points, grid.points());
+  ASSERT_EQ(sample.fields.size(), grid.size());
+  EXPECT_EQ(sample.fields.front(), Eigen::Vector3d(1, 2, 3));
+}
+
+TEST(Octree, RefinesNearACharge) {
+  const auto grid = cpet::Box({2, 2, 2}).grid({4, 4, 4});
+  const Eigen::Vector3d source{0.9, 0.1, -0.3};
+  const auto field = [&source](const Eigen::Vector3d& p) {
+    return chargeField(p, source);
+  };
+  constexpr int DEPTH = 3;
+  const auto sample = cpet::octree::refine(grid, {DEPTH, 0.8}, field);
+
+  /* The coarse grid comes first, then the refined points, each once */
+  ASSERT_GT(sample.points.size(), grid.size());
+  for (size_t i = 0; i < grid.size(); ++i) {
+    EXPECT_EQ(sample.points[i], grid[i]);
+  }
+  EXPECT_EQ(asSet(sample.points).size(), sample.points.size());
+  for (size_t i = 0; i < sample.points.size(); ++i) {
+    EXPECT_EQ(sample.fields[i], field(sample.points[i]));
+  }
+
+  /* Far fewer points than the uniform grid of the same resolution, and the
+   * finest ones close to the charge */
+  const auto fine = cpet::Box({2, 2, 2}).grid({32, 32, 32});
+  EXPECT_LT(sample.points.size(), fine.size() / 4);
+  const auto coarseStep = 2.0 / 4;
+  size_t nearby = 0;
+  for (size_t i = grid.size(); i < sample.points.size(); ++i) {
+    nearby += ((sample.points[i] - source).norm() < 2 * coarseStep) ? 1 : 0;
+  }
+  EXPECT_GT(2 * nearby, sample.points.size() - grid.size());
+
+  /* Every point lies on the grid refined DEPTH times */
+  for (const auto& point : sample.points) {
+    for (long d = 0; d < 3; ++d) {
+      const auto steps = (point[d] + 2.0) / (coarseStep / (1 << DEPTH));
+      EXPECT_NEAR(steps, std::round(steps), 1e-6);
+    }
+  }
+
+  /* Threads only share out the fields */
+  const auto threaded = cpet::octree::refine(grid, {DEPTH, 0.8}, field, 3);
+  EXPECT_EQ(threaded.points, sample.points);
+}
+
+TEST(Octree, FilteredGrid) {
+  const cpet::Sphere sphere(2.0);
+  const auto grid = sphere.grid({4, 4, 4});
+  const Eigen::Vector3d source{0.2, 0.3, 0.1};
+  const auto sample = cpet::octree::refine(
+      grid, {2, 0.2},
+      [&source](const Eigen::Vector3d& p) { return chargeField(p, source); });
+  ASSERT_GT(sample.points.size(), grid.size());
+
+  /* Only cells with every corner in the sphere are split, and a sphere is
+   * convex */
+  for (const auto& point : sample.points) {
+    EXPECT_LE(point.norm(), 2.0 + 1e-12);
+  }
+}
+
+TEST(Octree, InvalidDepth) {
+  const auto grid = cpet::Box({1, 1, 1}).grid({2, 2, 2});
+  const auto field = [](const Eigen::Vector3d& p) { return p; };
+  EXPECT_THROW((void)cpet::octree::refine(grid, {-1, 0.1}, field),
+               cpet::value_error);
+  EXPECT_THROW(
+      (void)cpet::octree::refine(grid, {cpet::octree::MAX_DEPTH + 1, 0.1},
+                                 field),
+      cpet::value_error);
+  EXPECT_TRUE(cpet::octree::refine({}, {2, 0.1}, field).points.empty());
+}
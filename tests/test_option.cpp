@@ -210,7 +210,7 @@ TEST(Option, Plot3DSimpleValid) {
   const cpet::EFieldVolume& efv = option.calculateEFieldVolumes()[0];
 
   EXPECT_TRUE(efv.showPlot());
-  EXPECT_FALSE(efv.points().empty());
+  EXPECT_FALSE(efv.grid().empty());
   std::array<int, 3> expectedDensity = {3, 4, 3};
   EXPECT_EQ(efv.sampleDensity(), expectedDensity);
   EXPECT_EQ(efv.volume().type(), "box");
@@ -243,8 +243,8 @@ TEST(Option, Plot3dBlockBoxValid) {
   EXPECT_TRUE(efv0.showPlot());
   EXPECT_FALSE(efv1.showPlot());
 
-  EXPECT_FALSE(efv0.points().empty());
-  EXPECT_FALSE(efv1.points().empty());
+  EXPECT_FALSE(efv0.grid().empty());
+  EXPECT_FALSE(efv1.grid().empty());
 
   std::array<int, 3> expectedDensity = {5, 4, 5};
   EXPECT_EQ(efv0.sampleDensity(), expectedDensity);
@@ -297,6 +297,28 @@ TEST(Option, InvalidPlot3dBlockNoVolume) {
   EXPECT_THROW(auto o = cpet::Option{options_file}, cpet::invalid_option);
 }
 
+TEST(Option, Plot3dBlockAdaptive) {
+  std::string options_file = "Data/valid_options/plot3d_block_adaptive";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_EQ(option.calculateEFieldVolumes().size(), 1);
+  const auto& efv = option.calculateEFieldVolumes()[0];
+  ASSERT_TRUE(efv.refinement());
+  EXPECT_EQ(efv.refinement()->maxDepth, 3);
+  EXPECT_DOUBLE_EQ(efv.refinement()->tolerance, 0.25);
+  EXPECT_NE(efv.details().find("Adaptive: 3"), std::string::npos);
+
+  options_file = "Data/invalid_options/plot3d_block_adaptive_depth";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+  EXPECT_THROW(auto o = cpet::Option{options_file}, cpet::invalid_option);
+
+  options_file = "Data/invalid_options/plot3d_block_adaptive_fraction";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+  EXPECT_THROW(auto o = cpet::Option{options_file}, cpet::invalid_option);
+}
+
 TEST(Option, FieldBlockValid) {
   std::string options_file = "Data/valid_options/field_block_valid";
   ASSERT_TRUE(std::filesystem::exists(options_file));
@@ -514,4 +536,154 @@ TEST(Option, StartStepEmptyValid) {
 
   EXPECT_EQ(option.coordinatesStartIndex(), 0);
   EXPECT_EQ(option.coordinatesStepSize(), 1);
-}
\ No newline at end of file
+}
+
+TEST(Option, TopologyBlockCluster) {
+  std::string options_file = "Data/valid_options/topology_block_cluster";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  ASSERT_TRUE(tr.cluster());
+  EXPECT_EQ(tr.cluster()->method, cpet::cluster::Method::kmedoids);
+  EXPECT_EQ(tr.cluster()->numberOfClusters, 4);
+  ASSERT_TRUE(tr.clusterOutput());
+  EXPECT_EQ(*tr.clusterOutput(), "clusters.dat");
+}
+
+TEST(Option, TopologyBlockClusterMetric) {
+  std::string options_file = "Data/valid_options/topology_block_cluster_metric";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  ASSERT_TRUE(tr.cluster());
+  EXPECT_EQ(tr.metrics().size(), 2);
+  EXPECT_EQ(tr.clusterMetric(), cpet::histo::Metric::hellinger);
+}
+
+TEST(Option, TopologyBlockClusterSeveralMetrics) {
+  std::string options_file = "Data/invalid_options/topo_block_cluster_metrics";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_THROW(option = cpet::Option{options_file}, cpet::invalid_option);
+}
+
+TEST(Option, TopologyBlockClusterNoBins) {
+  std::string options_file = "Data/invalid_options/topo_block_cluster_nobins";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_THROW(option = cpet::Option{options_file}, cpet::invalid_option);
+}
+
+TEST(Option, TopologyBlockNeighbors) {
+  std::string options_file = "Data/valid_options/topology_block_neighbors";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  ASSERT_TRUE(tr.approximate());
+  EXPECT_EQ(tr.approximate()->neighbors, 10);
+  EXPECT_EQ(tr.approximate()->sketchSize, 32);
+  EXPECT_TRUE(tr.approximate()->refine);
+  ASSERT_TRUE(tr.neighborsOutput());
+  EXPECT_EQ(*tr.neighborsOutput(), "graph.dat");
+  EXPECT_FALSE(tr.cluster());
+}
+
+TEST(Option, TopologyBlockNeighborsWithCluster) {
+  std::string options_file =
+      "Data/invalid_options/topo_block_neighbors_cluster";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_THROW(option = cpet::Option{options_file}, cpet::invalid_option);
+}
+
+TEST(Option, TopologyBlockHistogramInput) {
+  std::string options_file =
+      "Data/valid_options/topology_block_histogram_input";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  EXPECT_TRUE(tr.analysisOnly());
+  EXPECT_TRUE(tr.computeMatrix());
+  EXPECT_FALSE(tr.bins());
+  EXPECT_FALSE(tr.sampleInput());
+  ASSERT_TRUE(tr.histogramInput());
+  EXPECT_EQ(*tr.histogramInput(), "histograms.bin");
+  EXPECT_FALSE(tr.histogramOutput());
+}
+
+TEST(Option, TopologyBlockHistogramResolutions) {
+  std::string options_file =
+      "Data/valid_options/topology_block_histo_resolutions";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  const std::vector<std::array<int, 2>> expectedResolutions = {
+      {25, 25}, {50, 50}, {100, 100}, {200, 200}};
+  EXPECT_EQ(tr.resolutions(), expectedResolutions);
+
+  std::array<int, 2> expectedBins = {25, 25};
+  ASSERT_TRUE(tr.bins());
+  EXPECT_EQ(*tr.bins(), expectedBins);
+}
+
+TEST(Option, TopologyBlockHistogramResolutionPairs) {
+  std::string options_file =
+      "Data/valid_options/topology_block_histo_resolutions_pairs";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  const std::vector<std::array<int, 2>> expectedResolutions = {{25, 50},
+                                                               {100, 100}};
+  EXPECT_EQ(tr.resolutions(), expectedResolutions);
+}
+
+TEST(Option, TopologyBlockMetrics) {
+  std::string options_file = "Data/valid_options/topology_block_metrics";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_NO_THROW(option = cpet::Option{options_file});
+  ASSERT_FALSE(option.calculateEFieldTopology().empty());
+
+  const auto& tr = option.calculateEFieldTopology()[0];
+  const std::vector<cpet::histo::Metric> expectedMetrics = {
+      cpet::histo::Metric::chi, cpet::histo::Metric::hellinger,
+      cpet::histo::Metric::jensenShannon, cpet::histo::Metric::l1};
+  EXPECT_EQ(tr.metrics(), expectedMetrics);
+  EXPECT_TRUE(tr.binaryMatrix());
+}
+
+TEST(Option, TopologyBlockUnknownMetric) {
+  std::string options_file = "Data/invalid_options/topo_block_unknown_metric";
+  ASSERT_TRUE(std::filesystem::exists(options_file));
+
+  cpet::Option option;
+  ASSERT_THROW(option = cpet::Option{options_file}, cpet::invalid_option);
+}
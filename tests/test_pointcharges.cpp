@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <exception>
+#include <filesystem>
 #include <string>
 #include <vector>
 
@@ -9,6 +10,7 @@
 #include "Exceptions.h"
 #include "PointCharge.h"
 #include "Frame.h"
+#include "Topology.h"
 
 TEST(AtomID, GenerateFromPDB) {
   const std::vector<std::string> pdbLines = {
@@ -83,6 +85,59 @@ TEST(AtomID, ConstructFromPQR) {
                cpet::value_error);
 }
 
+TEST(PackedAtomID, RoundTrip) {
+  for (const std::string id : {"D:115:C101", "A1:1002:C112", "A:-3:O", "1:1:1",
+                               "ABCD:2147483647:HH21"}) {
+    const auto packed = cpet::PackedAtomID::pack(id);
+    ASSERT_TRUE(packed) << id;
+    EXPECT_EQ(packed->str(), id);
+  }
+  const auto packed = cpet::PackedAtomID::pack("A1:1002:C112");
+  EXPECT_EQ(packed->chain(), "A1");
+  EXPECT_EQ(packed->residue(), 1002);
+  EXPECT_EQ(packed->name(), "C112");
+
+  /* Would not print back as the same id */
+  for (const std::string id :
+       {"GF:56 :a", "A:007:CA", "A:+7:CA", "A:-0:CA", "ABCDE:1:CA", "A:1:HHH21",
+        "A:1.5:CA", "A:1", "A:1:CA:"}) {
+    EXPECT_FALSE(cpet::PackedAtomID::pack(id)) << id;
+  }
+}
+
+TEST(AtomID, PackedEquality) {
+  const cpet::AtomID a("A1:1002:C112");
+  const cpet::AtomID b(std::string("A1:1002:C112"));
+  const cpet::AtomID c("A1:1002:C113");
+  ASSERT_TRUE(a.packed());
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_FALSE(a == c);
+
+  /* Ids that do not pack still compare by their string */
+  const cpet::AtomID d("GF:56 :a");
+  EXPECT_FALSE(d.packed());
+  EXPECT_EQ(d, cpet::AtomID("GF:56 :a"));
+  EXPECT_FALSE(d == cpet::AtomID("GF:56:a"));
+}
+
+TEST(Topology, KeepsIdsThatDoNotPack) {
+  const std::vector<cpet::AtomID> ids = {cpet::AtomID("A:1:CA"),
+                                         cpet::AtomID("GF:56 :a"),
+                                         cpet::AtomID("A:007:CA")};
+  const cpet::Topology topology(ids, {0.5, 0.0, -0.5});
+  ASSERT_EQ(topology.size(), ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(topology.id(i), ids[i]);
+    EXPECT_EQ(topology.id(i).ID(), ids[i].ID());
+    EXPECT_TRUE(topology.hasID(i, ids[i]));
+    EXPECT_EQ(topology.indexOf(ids[i]), i);
+  }
+  EXPECT_FALSE(topology.hasID(1, cpet::AtomID("GF:56:a")));
+  EXPECT_FALSE(topology.indexOf(cpet::AtomID("A:7:CA")));
+  EXPECT_EQ(topology.chargedAtoms(), std::vector<uint32_t>({0, 2}));
+}
+
 TEST(AtomID, ConstructWithString) {
   EXPECT_NO_THROW(cpet::AtomID("D:115:C101"));
   EXPECT_THROW(cpet::AtomID("A:152"), cpet::value_error);
@@ -223,3 +278,211 @@ TEST(PointCharge, find) {
 }
 
 // test pointcharges (some of the basic functionalities...)
+
+TEST(Frame, LoadPDBModels) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1);
+  ASSERT_EQ(frames.size(), 3);
+  for (const auto& frame : frames) {
+    ASSERT_EQ(std::distance(frame.begin(), frame.end()), 3);
+    EXPECT_EQ(frame.begin()->id.ID(), "D:2:O110");
+    EXPECT_EQ((frame.begin() + 2)->id.ID(), "A1:1002:C112");
+    EXPECT_DOUBLE_EQ((frame.begin() + 1)->charge, -0.447);
+  }
+  EXPECT_DOUBLE_EQ(frames[2].begin()->coordinate[0], 114.061);
+  EXPECT_DOUBLE_EQ(frames[2].begin()->coordinate[2], 107.751);
+
+  const auto skipped = cpet::Frame::loadFramesFromFile(file, 1, 1);
+  ASSERT_EQ(skipped.size(), 2);
+  EXPECT_DOUBLE_EQ(skipped[0].begin()->coordinate[0], 113.961);
+}
+
+TEST(Frame, LoadPQR) {
+  const std::string file = "Data/structures/single.pqr";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1);
+  ASSERT_EQ(frames.size(), 1);
+  const auto& frame = frames.front();
+  ASSERT_EQ(std::distance(frame.begin(), frame.end()), 2);
+  EXPECT_EQ(frame.begin()->id.ID(), "A:1300:HMB3");
+  EXPECT_DOUBLE_EQ(frame.begin()->coordinate[2], -3.295);
+  EXPECT_DOUBLE_EQ((frame.begin() + 1)->charge, 0.063);
+
+  EXPECT_THROW(auto pc = cpet::Frame::parsePointCharge(
+                   "ATOM 4520 HMC1 HEM A 1300 2.780",
+                   cpet::constants::FileType::pqr),
+               cpet::value_error);
+  EXPECT_THROW(
+      auto frames = cpet::Frame::loadFramesFromFile("Data/missing.pdb", 0, 1),
+      cpet::io_error);
+}
+
+TEST(Frame, ParallelLoadPreservesOrder) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  for (const auto& [start, skip] :
+       std::vector<std::pair<int, int>>{{0, 1}, {0, 2}, {1, 1}, {2, 3}}) {
+    const auto sequential =
+        cpet::Frame::loadFramesFromFile(file, start, skip, 1);
+    const auto parallel = cpet::Frame::loadFramesFromFile(file, start, skip, 4);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (size_t i = 0; i < sequential.size(); ++i) {
+      EXPECT_TRUE(std::equal(sequential[i].begin(), sequential[i].end(),
+                             parallel[i].begin(), parallel[i].end()));
+    }
+  }
+}
+
+TEST(Frame, IndexModels) {
+  const std::string contents =
+      "MODEL 1\nATOM\nENDMDL\nMODEL 2\nATOM\nENDMDL\nATOM\n";
+
+  const auto models = cpet::Frame::indexModels(contents, 0, 1);
+  ASSERT_EQ(models.size(), 3);
+  EXPECT_EQ(models[0].firstLine, 1);
+  EXPECT_EQ(models[1].firstLine, 4);
+  EXPECT_EQ(models[2].firstLine, 7);
+  EXPECT_TRUE(models[1].terminated);
+  EXPECT_FALSE(models[2].terminated);
+  EXPECT_EQ(contents.substr(models[1].begin, models[1].end - models[1].begin),
+            "MODEL 2\nATOM\n");
+
+  const auto skipped = cpet::Frame::indexModels(contents, 1, 1);
+  ASSERT_EQ(skipped.size(), 2);
+  EXPECT_EQ(skipped[0].firstLine, 4);
+}
+
+TEST(Frame, ParseErrorReportsLine) {
+  const std::string file = "Data/structures/bad_line.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  try {
+    auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, 2);
+    FAIL() << "Expected a parse error";
+  } catch (const cpet::value_error& e) {
+    EXPECT_NE(std::string(e.what()).find("bad_line.pdb:6:"), std::string::npos)
+        << e.what();
+  }
+  EXPECT_NO_THROW(auto frames = cpet::Frame::loadFramesFromFile(file, 0, 2));
+}
+
+TEST(Frame, StreamMatchesLoad) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  for (const int threads : {1, 2, 4}) {
+    const auto loaded = cpet::Frame::loadFramesFromFile(file, 0, 1, threads);
+    size_t index = 0;
+    cpet::Frame::forEachFrameInFile(
+        file, 0, 1, threads, [&](const cpet::Frame& frame) {
+          ASSERT_LT(index, loaded.size());
+          EXPECT_TRUE(std::equal(frame.begin(), frame.end(),
+                                 loaded[index].begin(), loaded[index].end()));
+          ++index;
+        });
+    EXPECT_EQ(index, loaded.size());
+  }
+}
+
+TEST(Frame, ModelsShareTopology) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  for (const int threads : {1, 2}) {
+    auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, threads);
+    ASSERT_EQ(frames.size(), 3);
+    for (const auto& frame : frames) {
+      EXPECT_EQ(frame.sharedTopology(), frames.front().sharedTopology());
+    }
+    const auto pc = frames[1].find(cpet::AtomID("A1:1002:C112"));
+    EXPECT_DOUBLE_EQ(pc->coordinate[0], 111.535);
+
+    cpet::Frame::updateCharges(frames, {1.0, 2.0, 3.0});
+    for (const auto& frame : frames) {
+      EXPECT_EQ(frame.sharedTopology(), frames.front().sharedTopology());
+      EXPECT_DOUBLE_EQ((frame.begin() + 2)->charge, 3.0);
+    }
+    EXPECT_THROW(cpet::Frame::updateCharges(frames, {1.0}), cpet::value_error);
+  }
+}
+
+TEST(Frame, ModelsWithDifferentAtoms) {
+  const std::string file = "Data/structures/models_varying.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, 2);
+  ASSERT_EQ(frames.size(), 4);
+  EXPECT_EQ(frames[1].size(), 2);
+  EXPECT_NE(frames[1].sharedTopology(), frames[0].sharedTopology());
+  EXPECT_NE(frames[2].sharedTopology(), frames[0].sharedTopology());
+  EXPECT_DOUBLE_EQ((frames[2].begin() + 1)->charge, -0.5);
+  EXPECT_EQ((frames[2].begin() + 2)->id.ID(), "A1:1002:C112");
+  EXPECT_EQ(frames[3].sharedTopology(), frames[0].sharedTopology());
+  EXPECT_DOUBLE_EQ(frames[3].begin()->coordinate[0], 114.161);
+}
+
+TEST(Frame, ArenaStorage) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  /* Frames that share a topology are consecutive blocks of one slab */
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, 2);
+  ASSERT_GT(frames.size(), 2);
+  const auto atoms = frames[1].size();
+  ASSERT_EQ(frames[2].sharedTopology(), frames[1].sharedTopology());
+  EXPECT_EQ(frames[2].coordinates().data(),
+            frames[1].coordinates().data() + atoms);
+
+  /* Copies do not alias the slab */
+  auto copy = frames[1];
+  copy.coordinates()[0] += Eigen::Vector3d{1, 0, 0};
+  EXPECT_NE(copy.coordinates()[0], frames[1].coordinates()[0]);
+  EXPECT_EQ(copy.coordinates()[1], frames[1].coordinates()[1]);
+
+  /* Storage outlives the arena and its other blocks */
+  cpet::CoordinateStorage block;
+  {
+    cpet::CoordinateArena arena(4);
+    const auto first = arena.allocate(3);
+    block = arena.allocate(1);
+    EXPECT_EQ(block.get(), first.get() + 3);
+    EXPECT_NE(arena.allocate(1).get(), first.get() + 4);
+  }
+  block[0] = Eigen::Vector3d{1, 2, 3};
+  EXPECT_EQ(block[0], Eigen::Vector3d(1, 2, 3));
+}
+
+TEST(Frame, SinglePrecision) {
+  const std::string file = "Data/structures/models.pdb";
+  ASSERT_TRUE(std::filesystem::exists(file));
+
+  const auto frames = cpet::Frame::loadFramesFromFile(file, 0, 1, 1);
+  ASSERT_FALSE(frames.empty());
+  auto frame = frames.front();
+  EXPECT_FALSE(frame.singlePrecision());
+
+  cpet::CompactArena arena(1024);
+  frame.toSinglePrecision(arena);
+  EXPECT_TRUE(frame.singlePrecision());
+  EXPECT_TRUE(frame.coordinates().empty());
+  ASSERT_EQ(frame.size(), frames.front().size());
+  ASSERT_EQ(frame.compactCoordinates().size(), frame.size());
+  for (size_t i = 0; i < frame.size(); ++i) {
+    EXPECT_NEAR((frame.coordinate(i) - frames.front().coordinate(i)).norm(),
+                0, 1e-4);
+    EXPECT_EQ(frame[i].id, frames.front()[i].id);
+  }
+
+  /* Copies stay single precision and own their coordinates */
+  const auto copy = frame;
+  EXPECT_TRUE(copy.singlePrecision());
+  EXPECT_NE(copy.compactCoordinates().data(),
+            frame.compactCoordinates().data());
+  EXPECT_EQ(copy.coordinate(0), frame.coordinate(0));
+  EXPECT_EQ(std::distance(copy.begin(), copy.end()),
+            static_cast<std::ptrdiff_t>(frame.size()));
+}
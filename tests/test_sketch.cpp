@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cmath>
+
+#include "Sketch.h"
+#include "Histogram2D.h"
+
+namespace {
+/* Five histograms peaked in the first half and five in the second half */
+std::vector<std::vector<double>> twoGroupHistograms() {
+  constexpr size_t bins = 20;
+  std::vector<std::vector<double>> histograms;
+  for (size_t group = 0; group < 2; ++group) {
+    for (size_t member = 0; member < 5; ++member) {
+      std::vector<int> counts(bins, 1);
+      for (size_t b = 0; b < bins / 2; ++b) {
+        counts[group * bins / 2 + b] += 50 + static_cast<int>(member + b);
+      }
+      histograms.emplace_back(cpet::histo::normalize(counts));
+    }
+  }
+  return histograms;
+}
+
+double hellinger(const std::vector<double>& p, const std::vector<double>& q) {
+  double sum = 0.0;
+  for (size_t i = 0; i < p.size(); ++i) {
+    const double diff = std::sqrt(p[i]) - std::sqrt(q[i]);
+    sum += diff * diff;
+  }
+  return std::sqrt(sum / 2.0);
+}
+}  // namespace
+
+TEST(Sketch, Construct) {
+  const auto histograms = twoGroupHistograms();
+  const auto sketches = cpet::sketch::construct(histograms, 8);
+  EXPECT_EQ(sketches.rows(), 8);
+  EXPECT_EQ(sketches.cols(), histograms.size());
+
+  EXPECT_EQ(cpet::sketch::construct({}, 8).size(), 0);
+}
+
+TEST(Sketch, PreservesHellinger) {
+  const auto histograms = twoGroupHistograms();
+  const auto sketches = cpet::sketch::construct(histograms, 1024);
+
+  const double exact = hellinger(histograms[0], histograms[9]);
+  const double approximate =
+      (sketches.col(0) - sketches.col(9)).norm() / std::sqrt(2.0);
+  EXPECT_NEAR(approximate, exact, 0.25 * exact);
+}
+
+TEST(Sketch, NearestNeighbors) {
+  const auto histograms = twoGroupHistograms();
+  for (const bool refine : {false, true}) {
+    cpet::sketch::Options options{2};
+    options.sketchSize = 128;
+    options.refine = refine;
+
+    const auto graph = cpet::sketch::nearestNeighbors(histograms, options, 2);
+    ASSERT_EQ(graph.size(), histograms.size());
+    for (size_t i = 0; i < graph.size(); ++i) {
+      ASSERT_EQ(graph[i].size(), 2);
+      for (const auto& neighbor : graph[i]) {
+        EXPECT_NE(neighbor.index, i);
+        EXPECT_EQ(neighbor.index / 5, i / 5)
+            << "frame " << i << " matched to other group " << neighbor.index;
+      }
+      EXPECT_LE(graph[i][0].distance, graph[i][1].distance);
+    }
+  }
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -9,6 +10,7 @@
 #include "PointCharge.h"
 #include "FieldLocations.h"
 #include "Frame.h"
+#include "Cavity.h"
 
 TEST(System, SimpleField) {
   cpet::Option option;
@@ -53,3 +55,88 @@ TEST(System, SimpleField) {
     EXPECT_NEAR((field - expected_result).norm(), 0, 0.00001);
   }
 }
+
+TEST(System, UserSpaceField) {
+  const cpet::Option option{"Data/valid_options/align_rotated"};
+
+  std::vector<cpet::PointCharge> pc;
+  pc.emplace_back(Eigen::Vector3d{1.0, 0.2, -0.4}, -0.8,
+                  cpet::AtomID{"A:1:N"});
+  pc.emplace_back(Eigen::Vector3d{-0.3, 1.7, 2.2}, 0.6, cpet::AtomID{"A:2:O"});
+  pc.emplace_back(Eigen::Vector3d{2.5, -1.1, 0.9}, 0.0, cpet::AtomID{"A:3:C"});
+  pc.emplace_back(Eigen::Vector3d{0.4, 0.9, 3.1}, 0.3, cpet::AtomID{"A:4:H"});
+  const cpet::Frame frame{pc};
+
+  cpet::System sys{frame, option};
+  sys.transformToUserSpace();
+
+  /* The frame is left as it was, only its view through the system moves */
+  EXPECT_EQ(sys.frame().coordinates()[0], pc[0].coordinate);
+  for (size_t i = 0; i < pc.size(); ++i) {
+    EXPECT_NEAR((sys.coordinate(i) -
+                 sys.transformToUserSpace(pc[i].coordinate))
+                    .norm(),
+                0, 1e-12);
+    EXPECT_NEAR((sys.transformToDefaultSpace(sys.coordinate(i)) -
+                 pc[i].coordinate)
+                    .norm(),
+                0, 1e-12);
+  }
+
+  /* Field of the charges moved into the user basis one by one */
+  const Eigen::Vector3d location{0.7, -0.2, 1.3};
+  Eigen::Vector3d expected(0, 0, 0);
+  for (size_t i = 0; i < pc.size(); ++i) {
+    const Eigen::Vector3d d = location - sys.coordinate(i);
+    expected += pc[i].charge * d / (d.norm() * d.norm() * d.norm());
+  }
+  expected *= 1.0 / (4.0 * M_PI * 0.0055263495);
+
+  EXPECT_NEAR((sys.electricFieldAt(location) - expected).norm(), 0,
+              1e-9 * expected.norm());
+}
+
+TEST(System, SinglePrecisionField) {
+  const cpet::Option option{"Data/valid_options/align_rotated"};
+
+  std::vector<cpet::PointCharge> pc;
+  pc.emplace_back(Eigen::Vector3d{41.125, 20.5, -13.375}, -0.8,
+                  cpet::AtomID{"A:1:N"});
+  pc.emplace_back(Eigen::Vector3d{39.871, 22.013, -11.296}, 0.6,
+                  cpet::AtomID{"A:2:O"});
+  pc.emplace_back(Eigen::Vector3d{43.402, 18.977, -12.651}, 0.3,
+                  cpet::AtomID{"A:3:H"});
+  const cpet::Frame frame{pc};
+  auto compact = frame;
+  cpet::CompactArena arena(16);
+  compact.toSinglePrecision(arena);
+
+  cpet::System sys{frame, option};
+  cpet::System single{compact, option};
+  sys.transformToUserSpace();
+  single.transformToUserSpace();
+
+  for (const auto& location :
+       {Eigen::Vector3d{0.7, -0.2, 1.3}, Eigen::Vector3d{-2.0, 3.5, 0.25}}) {
+    const auto expected = sys.electricFieldAt(location);
+    EXPECT_NEAR((single.electricFieldAt(location) - expected).norm(), 0,
+                1e-5 * expected.norm());
+  }
+}
+
+TEST(System, CavityTopology) {
+  cpet::Option option;
+  std::vector<cpet::PointCharge> pc;
+  pc.emplace_back(Eigen::Vector3d{0, 0, 0}, 1, cpet::AtomID{"A:1:N"});
+  pc.emplace_back(Eigen::Vector3d{3, 0, 0}, -1, cpet::AtomID{"A:2:O"});
+  const cpet::System sys{cpet::Frame{pc}, option};
+
+  /* Placed around A:1:N of this frame; paths stay within its sphere, up to
+   * the voxels reaching past it and one step */
+  const cpet::Cavity cavity(1.0, {"A:1:N"});
+  const auto samples = sys.electricFieldTopologyIn(1, cavity, 0.01, 20);
+  ASSERT_EQ(samples.size(), 20);
+  for (const auto& sample : samples) {
+    EXPECT_LE(sample.distance, 2.5);
+  }
+}
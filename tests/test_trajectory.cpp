@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Exceptions.h"
+#include "Frame.h"
+#include "Trajectory.h"
+
+namespace {
+/* Coordinates written by the test trajectories, in Angstroms */
+Eigen::Vector3d expectedCoordinate(const size_t atom, const size_t frame) {
+  const auto i = static_cast<double>(atom);
+  const auto f = static_cast<double>(frame);
+  return Eigen::Vector3d{(1000 + 3 * i + 100 * f) / 100.0,
+                         (2000 - 2 * i + 100 * f) / 100.0,
+                         (1500 + static_cast<double>(atom % 4) + 100 * f) /
+                             100.0};
+}
+
+void checkReader(const cpet::trajectory::Reader& reader, const size_t atoms,
+                 const size_t frames) {
+  ASSERT_EQ(reader.numberOfAtoms(), atoms);
+  ASSERT_EQ(reader.numberOfFrames(), frames);
+
+  std::vector<Eigen::Vector3d> coordinates;
+  /* Read out of order to exercise seeking */
+  for (const auto frame : {frames - 1, size_t{0}, frames / 2}) {
+    reader.read(frame, coordinates);
+    ASSERT_EQ(coordinates.size(), atoms);
+    for (size_t i = 0; i < atoms; ++i) {
+      EXPECT_NEAR((coordinates[i] - expectedCoordinate(i, frame)).norm(), 0.0,
+                  1e-4)
+          << "atom " << i << " frame " << frame;
+    }
+  }
+  EXPECT_THROW(reader.read(frames, coordinates), cpet::value_error);
+}
+}  // namespace
+
+TEST(Trajectory, FormatOf) {
+  EXPECT_EQ(cpet::trajectory::formatOf("run.xtc"),
+            cpet::trajectory::Format::xtc);
+  EXPECT_EQ(cpet::trajectory::formatOf("path/run.DCD"),
+            cpet::trajectory::Format::dcd);
+  EXPECT_FALSE(cpet::trajectory::formatOf("run.pdb"));
+}
+
+TEST(Trajectory, ReadDCD) {
+  const std::string file = "Data/structures/traj.dcd";
+  ASSERT_TRUE(std::filesystem::exists(file));
+  checkReader(cpet::trajectory::DCDReader(file), 12, 4);
+}
+
+TEST(Trajectory, ReadBigEndianXPLORDCD) {
+  const std::string file = "Data/structures/traj_xplor_be.dcd";
+  ASSERT_TRUE(std::filesystem::exists(file));
+  checkReader(cpet::trajectory::DCDReader(file), 12, 4);
+}
+
+TEST(Trajectory, ReadCompressedXTC) {
+  const std::string file = "Data/structures/traj.xtc";
+  ASSERT_TRUE(std::filesystem::exists(file));
+  checkReader(cpet::trajectory::XTCReader(file), 12, 4);
+}
+
+TEST(Trajectory, ReadUncompressedXTC) {
+  const std::string file = "Data/structures/traj_small.xtc";
+  ASSERT_TRUE(std::filesystem::exists(file));
+  checkReader(cpet::trajectory::XTCReader(file), 3, 2);
+}
+
+TEST(Trajectory, InvalidFile) {
+  EXPECT_THROW(cpet::trajectory::XTCReader("Data/structures/traj.dcd"),
+               cpet::value_error);
+  EXPECT_THROW(cpet::trajectory::DCDReader("Data/structures/traj.xtc"),
+               cpet::value_error);
+}
+
+TEST(Trajectory, FramesFromTopology) {
+  const auto topology =
+      cpet::trajectory::loadTopology("Data/structures/topology.pdb");
+  ASSERT_EQ(std::distance(topology.begin(), topology.end()), 12);
+
+  for (const std::string file :
+       {"Data/structures/traj.dcd", "Data/structures/traj.xtc"}) {
+    const auto frames =
+        cpet::trajectory::loadFrames(file, topology, 1, 2, 2);
+    ASSERT_EQ(frames.size(), 2) << file;
+
+    for (size_t f = 0; f < frames.size(); ++f) {
+      size_t i = 0;
+      auto reference = topology.begin();
+      for (const auto& pc : frames[f]) {
+        EXPECT_EQ(pc.id, reference->id);
+        EXPECT_DOUBLE_EQ(pc.charge, reference->charge);
+        EXPECT_NEAR(
+            (pc.coordinate - expectedCoordinate(i, 1 + 2 * f)).norm(), 0.0,
+            1e-4);
+        ++reference;
+        ++i;
+      }
+    }
+
+    size_t streamed = 0;
+    cpet::trajectory::forEachFrame(
+        file, topology, 1, 2, 2, [&](const cpet::Frame& frame) {
+          ASSERT_LT(streamed, frames.size());
+          EXPECT_TRUE(std::equal(frame.begin(), frame.end(),
+                                 frames[streamed].begin(),
+                                 frames[streamed].end()));
+          ++streamed;
+        });
+    EXPECT_EQ(streamed, frames.size());
+  }
+
+  const auto single =
+      cpet::trajectory::loadTopology("Data/structures/single.pqr");
+  EXPECT_THROW(auto frames = cpet::trajectory::loadFrames(
+                   "Data/structures/traj.dcd", single, 0, 1, 1),
+               cpet::value_error);
+}
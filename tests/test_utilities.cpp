@@ -1,10 +1,17 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include "Exceptions.h"
+#include "TextWriter.h"
 #include "Utilities.h"
 
 TEST(Split, HandlesStandardInput) {
@@ -251,4 +258,107 @@ TEST(endswith, normal) {
   EXPECT_FALSE(cpet::util::endswith("hello", "hhello"));
   EXPECT_TRUE(cpet::util::endswith("something", ""));
   EXPECT_FALSE(cpet::util::endswith("", "something"));
-}
\ No newline at end of file
+}
+
+TEST(parseDouble, FixedWidthFields) {
+  EXPECT_DOUBLE_EQ(cpet::util::parseDouble(" 113.861"), 113.861);
+  EXPECT_DOUBLE_EQ(cpet::util::parseDouble("-0.846  "), -0.846);
+  EXPECT_DOUBLE_EQ(cpet::util::parseDouble("+0.063\r"), 0.063);
+  EXPECT_DOUBLE_EQ(cpet::util::parseDouble("1e-3"), 1e-3);
+  EXPECT_THROW(auto d = cpet::util::parseDouble("   "), cpet::value_error);
+  EXPECT_THROW(auto d = cpet::util::parseDouble(""), cpet::value_error);
+  EXPECT_THROW(auto d = cpet::util::parseDouble("PRE"), cpet::value_error);
+}
+
+TEST(fromChars, StopsWhereFromCharsWould) {
+  const auto parse = [](const std::string_view str, double& value) {
+    const auto [ptr, ec] =
+        cpet::util::fromChars(str.data(), str.data() + str.size(), value);
+    return std::make_pair(ptr - str.data(), ec);
+  };
+  double value{-1};
+  EXPECT_EQ(parse("1.5e3xyz", value), std::make_pair(5L, std::errc()));
+  EXPECT_DOUBLE_EQ(value, 1500);
+  EXPECT_EQ(parse("0x1p3", value), std::make_pair(1L, std::errc()));
+  EXPECT_DOUBLE_EQ(value, 0);
+  EXPECT_EQ(parse("-inf", value).second, std::errc());
+  EXPECT_TRUE(std::isinf(value));
+
+  value = 7;
+  for (const auto* invalid : {"", " 1", "+1", ".", "e5"}) {
+    EXPECT_EQ(parse(invalid, value).second, std::errc::invalid_argument)
+        << invalid;
+  }
+  EXPECT_DOUBLE_EQ(value, 7);
+}
+
+TEST(toDouble, MatchesIsDouble) {
+  for (const std::string str :
+       {"4", "4.", ".0", "-.02", "+1.5", " 4.5", "4.6124    ", "1e-3",
+        "-0.846\r", "", "\t \n", "a4.5", "4.12b", "4.5 6", "- 19.1290", "+-1",
+        "inf", "nan", "-", "."}) {
+    const auto result = cpet::util::toDouble(str);
+    EXPECT_EQ(result.has_value(), cpet::util::isDouble(str)) << str;
+    if (result) {
+      EXPECT_EQ(*result, std::stod(str)) << str;
+    }
+  }
+}
+
+TEST(tokenize, MatchesSplit) {
+  const std::string line = "  ATOM 4520  HMC1 HEM A 1300 ";
+  std::array<std::string_view, 8> tokens;
+  const auto count = cpet::util::tokenize(line, ' ', tokens);
+  const auto expected = cpet::util::split(line, ' ');
+  ASSERT_EQ(count, expected.size());
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_EQ(tokens[i], expected[i]);
+  }
+
+  std::array<std::string_view, 2> truncated;
+  EXPECT_EQ(cpet::util::tokenize(line, ' ', truncated), 2);
+  EXPECT_EQ(truncated[1], "4520");
+}
+
+TEST(TextBuffer, MatchesStream) {
+  const std::vector<double> values = {0.0,      -0.0,   1.0,     -2.5,
+                                      113.861,  1e-7,   -3.3e12, 123456.5,
+                                      0.100001, 1.5e300};
+  for (const auto value : values) {
+    cpet::util::TextBuffer buffer;
+    std::ostringstream general;
+    general << value;
+    buffer.appendGeneral(value);
+    EXPECT_EQ(buffer.view(), general.str());
+
+    buffer.clear();
+    std::ostringstream fixed;
+    fixed << std::fixed << std::setprecision(4) << value;
+    buffer.appendFixed(value, 4);
+    EXPECT_EQ(buffer.view(), fixed.str());
+  }
+
+  const Eigen::Vector3d vector(-0.846, 12.5, 1e-9);
+  std::ostringstream aligned;
+  aligned << vector.transpose();
+  cpet::util::TextBuffer buffer;
+  buffer.appendAligned(vector);
+  EXPECT_EQ(buffer.view(), aligned.str());
+}
+
+TEST(TextBuffer, WriteRowsInOrder) {
+  constexpr size_t rows = 100000;
+  std::ostringstream expected;
+  for (size_t i = 0; i < rows; ++i) {
+    expected << i * 0.5 << '\n';
+  }
+  for (const int threads : {1, 3}) {
+    std::ostringstream written;
+    cpet::util::writeRows(written, rows, threads,
+                          [](cpet::util::TextBuffer& buffer, const size_t i) {
+                            buffer.appendGeneral(static_cast<double>(i) * 0.5);
+                            buffer.append('\n');
+                          });
+    EXPECT_EQ(written.str(), expected.str()) << threads << " threads";
+  }
+}
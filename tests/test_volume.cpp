@@ -2,10 +2,19 @@
 
 #include <Eigen/Core>
 #include <array>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 
 #include "Box.h"
+#include "Cavity.h"
+#include "Cylinder.h"
+#include "Ellipsoid.h"
 #include "Exceptions.h"
+#include "Sphere.h"
+#include "Topology.h"
+#include "Volume.h"
+#include "Volumes.h"
 
 TEST(Box, BasicProperties) {
   cpet::Box b({1.3, 2.4, 2});
@@ -124,3 +133,223 @@ TEST(Box, InvalidParameters) {
   EXPECT_THROW(cpet::Box({1.5, 2, -3}), cpet::value_error);
   EXPECT_THROW(cpet::Box({-1.5, 2, -3}), cpet::value_error);
 }
+
+TEST(Sphere, BasicProperties) {
+  const cpet::Sphere s(2.0, {1, 0, 0});
+  EXPECT_EQ(s.type(), "sphere");
+  EXPECT_EQ(s.description(), "Sphere: 2.000000");
+  EXPECT_DOUBLE_EQ(s.maxDim(), 2.0);
+  EXPECT_DOUBLE_EQ(s.diagonal(), 4.0);
+
+  EXPECT_TRUE(s.isInside({1, 0, 0}));
+  EXPECT_TRUE(s.isInside({2.9, 0, 0}));
+  EXPECT_FALSE(s.isInside({-1.1, 0, 0}));
+  EXPECT_FALSE(s.isInside({2.5, 1.5, 0}));
+
+  /* Uniform over the ball: a quarter of the points within half the radius
+   * would mean a bias towards the center */
+  constexpr int SAMPLES = 4000;
+  int inner = 0;
+  for (int i = 0; i < SAMPLES; i++) {
+    const auto point = s.randomPoint();
+    EXPECT_TRUE(s.isInside(point));
+    inner += ((point - Eigen::Vector3d{1, 0, 0}).norm() < 1.0) ? 1 : 0;
+  }
+  EXPECT_NEAR(static_cast<double>(inner) / SAMPLES, 0.125, 0.03);
+
+  constexpr double STEP_SIZE = 0.001;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_LE(s.randomDistance(STEP_SIZE), s.diagonal() / STEP_SIZE);
+  }
+
+  EXPECT_THROW(cpet::Sphere(0.0), cpet::value_error);
+  EXPECT_THROW(cpet::Sphere(-1.0), cpet::value_error);
+}
+
+TEST(Cylinder, BasicProperties) {
+  const cpet::Cylinder c(1.0, 3.0);
+  EXPECT_EQ(c.type(), "cylinder");
+  EXPECT_EQ(c.description(), "Cylinder: 1.000000 3.000000");
+  EXPECT_DOUBLE_EQ(c.maxDim(), 3.0);
+  EXPECT_NEAR(c.diagonal(), 2 * std::sqrt(10.0), 1e-12);
+
+  EXPECT_TRUE(c.isInside({0.5, 0.5, -2.9}));
+  EXPECT_FALSE(c.isInside({0.8, 0.8, 0}));
+  EXPECT_FALSE(c.isInside({0, 0, 3.1}));
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(c.isInside(c.randomPoint()));
+  }
+  EXPECT_THROW(cpet::Cylinder(1.0, 0.0), cpet::value_error);
+}
+
+TEST(Ellipsoid, BasicProperties) {
+  const cpet::Ellipsoid e({1, 2, 4}, {0, 0, 1});
+  EXPECT_EQ(e.type(), "ellipsoid");
+  EXPECT_EQ(e.description(), "Ellipsoid: 1.000000 2.000000 4.000000");
+  EXPECT_DOUBLE_EQ(e.maxDim(), 4.0);
+  EXPECT_DOUBLE_EQ(e.diagonal(), 8.0);
+
+  EXPECT_TRUE(e.isInside({0, 0, 4.9}));
+  EXPECT_TRUE(e.isInside({0, 1.9, 1}));
+  EXPECT_FALSE(e.isInside({1.1, 0, 1}));
+  EXPECT_FALSE(e.isInside({0.8, 1.5, 1}));
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(e.isInside(e.randomPoint()));
+  }
+  EXPECT_THROW(cpet::Ellipsoid({1, -2, 4}), cpet::value_error);
+}
+
+TEST(Volume, ShapedGrid) {
+  const std::array<int, 3> density = {8, 8, 8};
+  const cpet::Sphere s(2.0, {0, 1, 0});
+  const auto grid = s.grid(density);
+  const auto bounds = cpet::Box({2, 2, 2}, {0, 1, 0}).grid(density);
+
+  /* The points of the bounding box grid inside the sphere, in order */
+  std::vector<Eigen::Vector3d> expected;
+  for (const auto& point : bounds.points()) {
+    if (s.isInside(point)) {
+      expected.push_back(point);
+    }
+  }
+  ASSERT_FALSE(expected.empty());
+  ASSERT_LT(expected.size(), bounds.size());
+  EXPECT_EQ(grid.points(), expected);
+
+  /* At most one run of indices per (x, y) column of the bounding grid */
+  EXPECT_LE(grid.numberOfRuns(),
+            bounds.axes()[0].size() * bounds.axes()[1].size());
+
+  /* Filtering again keeps the original indices */
+  const auto half =
+      grid.filter([](const Eigen::Vector3d& p) { return p[0] > 0; });
+  for (size_t i = 0; i < half.size(); ++i) {
+    EXPECT_GT(half[i][0], 0);
+    EXPECT_TRUE(s.isInside(half[i]));
+  }
+}
+
+TEST(Volume, GenerateVolume) {
+  const auto sphere = cpet::Volume::generateVolume({"sphere", "1.5", "1:2:3"});
+  EXPECT_EQ(sphere->type(), "sphere");
+  EXPECT_TRUE(sphere->isInside({1, 2, 4}));
+  EXPECT_FALSE(sphere->isInside({0, 0, 0}));
+
+  const auto cylinder = cpet::Volume::generateVolume({"cylinder", "1", "2"});
+  EXPECT_EQ(cylinder->type(), "cylinder");
+  EXPECT_TRUE(cylinder->isInside({0, 0, 1.5}));
+
+  const auto ellipsoid =
+      cpet::Volume::generateVolume({"ellipsoid", "1", "2", "3"});
+  EXPECT_EQ(ellipsoid->type(), "ellipsoid");
+  EXPECT_DOUBLE_EQ(ellipsoid->maxDim(), 3.0);
+
+  /* Each shape reaches the sampling loop as its own type */
+  EXPECT_EQ(cpet::visitVolume(*ellipsoid,
+                              [](const auto& region) {
+                                return std::is_same_v<
+                                    std::decay_t<decltype(region)>,
+                                    cpet::Ellipsoid>;
+                              }),
+            true);
+
+  EXPECT_THROW(cpet::Volume::generateVolume({"sphere"}),
+               cpet::invalid_option);
+  EXPECT_THROW(cpet::Volume::generateVolume({"cylinder", "1", "a"}),
+               cpet::invalid_option);
+  EXPECT_THROW(cpet::Volume::generateVolume({"ellipsoid", "1", "2", "3", "x"}),
+               cpet::invalid_option);
+  EXPECT_THROW(cpet::Volume::generateVolume({"cone", "1"}),
+               cpet::invalid_option);
+}
+
+TEST(Cavity, Positions) {
+  const cpet::Cavity c(1.0, {"0:0:0", "1.5:0:0"});
+  EXPECT_EQ(c.type(), "cavity");
+  EXPECT_EQ(c.description(), "Cavity: 1.000000 0:0:0 1.5:0:0");
+  ASSERT_TRUE(c.placed());
+  EXPECT_DOUBLE_EQ(c.maxDim(), 1.75);
+
+  EXPECT_TRUE(c.isInside({0, 0, 0}));
+  EXPECT_TRUE(c.isInside({0.75, 0.5, 0}));
+  EXPECT_TRUE(c.isInside({2.3, 0, 0}));
+  EXPECT_FALSE(c.isInside({0.75, 0.95, 0}));
+  EXPECT_FALSE(c.isInside({-1.2, 0, 0}));
+  EXPECT_FALSE(c.isInside({10, 10, 10}));
+
+  /* The voxels cover the union of two unit spheres */
+  const auto voxelVolume = std::pow(1.0 / cpet::Cavity::VOXELS_PER_RADIUS, 3);
+  const auto d = 1.5;
+  const auto lens = M_PI * (4 + d) * (2 - d) * (2 - d) / 12;
+  const auto expected = 2 * 4 * M_PI / 3 - lens;
+  EXPECT_GE(static_cast<double>(c.numberOfVoxels()) * voxelVolume, expected);
+
+  /* Points near the surface are inside exactly when within a sphere */
+  const Eigen::Vector3d second{1.5, 0, 0};
+  for (int i = 0; i < 1000; i++) {
+    const Eigen::Vector3d point =
+        Eigen::Vector3d(0.75, 0, 0) +
+        Eigen::Vector3d::Random().cwiseProduct(Eigen::Vector3d(1.8, 1.1, 1.1));
+    EXPECT_EQ(c.isInside(point),
+              point.norm() <= 1.0 || (point - second).norm() <= 1.0)
+        << point.transpose();
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(c.isInside(c.randomPoint()));
+  }
+  constexpr double STEP_SIZE = 0.001;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_LE(c.randomDistance(STEP_SIZE), c.diagonal() / STEP_SIZE);
+  }
+
+  const auto grid = c.grid({4, 4, 4});
+  ASSERT_FALSE(grid.empty());
+  for (const auto& point : grid.points()) {
+    EXPECT_TRUE(c.isInside(point));
+  }
+}
+
+TEST(Cavity, PlacedInFrame) {
+  const cpet::Topology topology(
+      {cpet::AtomID{"A:1:N"}, cpet::AtomID{"A:1:CA"}, cpet::AtomID{"A:2:N"},
+       cpet::AtomID{"B:7:O"}},
+      {0.1, 0.2, 0.3, 0.4});
+  const std::vector<Eigen::Vector3d> coordinates = {
+      {0, 0, 0}, {1, 0, 0}, {5, 5, 5}, {-4, 0, 0}};
+  const auto coordinate = [&](const size_t i) { return coordinates[i]; };
+
+  const cpet::Cavity c(0.8, {"A:1", "B:7:O"});
+  EXPECT_FALSE(c.placed());
+  EXPECT_FALSE(c.isInside({0, 0, 0}));
+  EXPECT_THROW((void)c.grid({2, 2, 2}), cpet::invalid_option);
+
+  const auto placed = c.placedIn(topology, coordinate);
+  EXPECT_TRUE(placed.placed());
+  EXPECT_TRUE(placed.isInside({0, 0, 0}));
+  EXPECT_TRUE(placed.isInside({1.5, 0, 0}));
+  EXPECT_TRUE(placed.isInside({-4, 0.5, 0}));
+  EXPECT_FALSE(placed.isInside({5, 5, 5}));
+  EXPECT_FALSE(placed.isInside({-2, 0, 0}));
+
+  EXPECT_THROW((void)cpet::Cavity(1.0, {"A:3"}).placedIn(topology, coordinate),
+               cpet::value_not_found);
+  EXPECT_THROW(
+      (void)cpet::Cavity(1.0, {"A:2:CA"}).placedIn(topology, coordinate),
+      cpet::value_not_found);
+}
+
+TEST(Cavity, InvalidParameters) {
+  EXPECT_THROW(cpet::Cavity(0.0, {"0:0:0"}), cpet::value_error);
+  EXPECT_THROW(cpet::Cavity(1.0, {}), cpet::invalid_option);
+  EXPECT_THROW(cpet::Cavity(1.0, {"A"}), cpet::invalid_option);
+  EXPECT_THROW(cpet::Volume::generateVolume({"cavity", "1.0"}),
+               cpet::invalid_option);
+  EXPECT_THROW(cpet::Volume::generateVolume({"cavity", "r", "A:1"}),
+               cpet::invalid_option);
+
+  const auto cavity = cpet::Volume::generateVolume({"cavity", "2", "A:1:CA"});
+  EXPECT_EQ(cavity->type(), "cavity");
+}